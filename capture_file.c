@@ -0,0 +1,106 @@
+#include "capture_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+_Static_assert(sizeof(capture_file_header_t) == 64, "capture file header must be 64 bytes");
+_Static_assert(sizeof(capture_record_t) == 16 + CAPTURE_FRAME_BYTES, "capture record layout changed");
+
+void capture_file_header_init(capture_file_header_t *header)
+{
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, CAPTURE_FILE_MAGIC, sizeof(header->magic));
+    header->version = CAPTURE_FILE_VERSION;
+    header->header_size = sizeof(capture_file_header_t);
+    header->width = CAPTURE_FRAME_WIDTH;
+    header->height = CAPTURE_FRAME_HEIGHT;
+    header->frame_bytes = CAPTURE_FRAME_BYTES;
+    header->record_size = sizeof(capture_record_t);
+}
+
+bool capture_file_header_valid(const capture_file_header_t *header)
+{
+    return memcmp(header->magic, CAPTURE_FILE_MAGIC, sizeof(header->magic)) == 0 &&
+           header->version == CAPTURE_FILE_VERSION &&
+           header->header_size >= sizeof(capture_file_header_t) &&
+           header->width == CAPTURE_FRAME_WIDTH &&
+           header->height == CAPTURE_FRAME_HEIGHT &&
+           header->frame_bytes == CAPTURE_FRAME_BYTES &&
+           header->record_size == sizeof(capture_record_t);
+}
+
+// =============================================================================
+// 串口文本记录
+// =============================================================================
+void capture_record_print(const capture_record_t *record)
+{
+    static const char hex[] = "0123456789abcdef";
+    // 按行分块输出，避免一次性占用14KB栈/静态内存
+    char chunk[2 * 60 + 1];
+
+    printf(CAPTURE_LINE_PREFIX "%lu %llu %ld ",
+           (unsigned long)record->frame_id,
+           (unsigned long long)record->timestamp_us,
+           (long)record->frame_to_dma_interval_us);
+
+    for (size_t i = 0; i < CAPTURE_FRAME_BYTES; i += 60)
+    {
+        for (size_t j = 0; j < 60; j++)
+        {
+            uint8_t b = record->data[i + j];
+            chunk[j * 2] = hex[b >> 4];
+            chunk[j * 2 + 1] = hex[b & 0x0F];
+        }
+        chunk[sizeof(chunk) - 1] = '\0';
+        fputs(chunk, stdout);
+    }
+    putchar('\n');
+}
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+bool capture_record_parse_line(const char *line, capture_record_t *record)
+{
+    // 串口日志里记录前面可能混有其它输出，从前缀开始解析
+    const char *p = strstr(line, CAPTURE_LINE_PREFIX);
+    if (p == NULL)
+        return false;
+    p += sizeof(CAPTURE_LINE_PREFIX) - 1;
+
+    char *end;
+    unsigned long frame_id = strtoul(p, &end, 10);
+    if (end == p)
+        return false;
+    p = end;
+    unsigned long long timestamp = strtoull(p, &end, 10);
+    if (end == p)
+        return false;
+    p = end;
+    long interval = strtol(p, &end, 10);
+    if (end == p || *end != ' ')
+        return false;
+    p = end + 1;
+
+    for (size_t i = 0; i < CAPTURE_FRAME_BYTES; i++)
+    {
+        int hi = hex_value(p[i * 2]);
+        int lo = (hi < 0) ? -1 : hex_value(p[i * 2 + 1]);
+        if (lo < 0)
+            return false;
+        record->data[i] = (uint8_t)((hi << 4) | lo);
+    }
+
+    record->frame_id = (uint32_t)frame_id;
+    record->timestamp_us = (uint64_t)timestamp;
+    record->frame_to_dma_interval_us = (int32_t)interval;
+    return true;
+}
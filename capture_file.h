@@ -0,0 +1,63 @@
+#ifndef CAPTURE_FILE_H
+#define CAPTURE_FILE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// =============================================================================
+// X3501 捕获文件格式 (.cap)
+//
+// 定长记录、只追加、可直接mmap：
+//   [capture_file_header_t][capture_record_t][capture_record_t]...
+// 第i条记录位于 header_size + i * record_size，记录数 = (文件长度 - header_size) / record_size，
+// 写入中途断电只会丢掉最后一条不完整的记录。所有字段为小端 (RP2350与x86/ARM主机一致)。
+// =============================================================================
+
+#define CAPTURE_FILE_MAGIC "X3501CAP"
+#define CAPTURE_FILE_VERSION 1
+
+#define CAPTURE_FRAME_WIDTH 240
+#define CAPTURE_FRAME_HEIGHT 240
+#define CAPTURE_FRAME_BYTES (CAPTURE_FRAME_WIDTH * CAPTURE_FRAME_HEIGHT / 8) // 7,200字节, 1bpp, LSB为左边像素
+
+typedef struct {
+    char magic[8];          // "X3501CAP"
+    uint16_t version;       // CAPTURE_FILE_VERSION
+    uint16_t header_size;   // sizeof(capture_file_header_t)
+    uint16_t width;         // 240
+    uint16_t height;        // 240
+    uint32_t frame_bytes;   // 7200
+    uint32_t record_size;   // sizeof(capture_record_t)
+    uint8_t reserved[40];
+} capture_file_header_t;    // 64字节
+
+typedef struct {
+    uint32_t frame_id;                  // lcd_framebuffer 的帧序号
+    int32_t frame_to_dma_interval_us;   // FRAME边沿到DMA完成 (0 = 未知)
+    uint64_t timestamp_us;              // DMA完成时刻 (time_us_64)
+    uint8_t data[CAPTURE_FRAME_BYTES];
+} capture_record_t;                     // 7216字节 (8字节对齐)
+
+// 填充文件头
+void capture_file_header_init(capture_file_header_t *header);
+
+// 校验文件头 (magic/版本/几何参数)
+bool capture_file_header_valid(const capture_file_header_t *header);
+
+// =============================================================================
+// 串口文本记录
+//
+// 设备端没有文件系统，通过USB串口输出一行文本，主机端 lcd_host import 转成 .cap：
+//   @CAP <frame_id> <timestamp_us> <frame_to_dma_interval_us> <14400个十六进制字符>
+// =============================================================================
+#define CAPTURE_LINE_PREFIX "@CAP "
+#define CAPTURE_LINE_MAX (sizeof(CAPTURE_LINE_PREFIX) + 48 + CAPTURE_FRAME_BYTES * 2 + 2)
+
+// 把一条记录以文本行输出到stdout
+void capture_record_print(const capture_record_t *record);
+
+// 解析一行文本记录，成功返回true
+bool capture_record_parse_line(const char *line, capture_record_t *record);
+
+#endif // CAPTURE_FILE_H
@@ -14,6 +14,28 @@ void frame_stats_init(frame_stats_t* stats, const char* display_name, float data
     stats->last_print_time_ms = 0;
     stats->display_name = display_name;
     stats->data_size_kb = data_size_kb;
+    stats->variant_count = 0;
+    stats->variant_names = NULL;
+}
+
+// 清零各变体的累计值
+static void frame_stats_clear_variants(frame_stats_t* stats)
+{
+    for (uint32_t i = 0; i < FRAME_STATS_MAX_VARIANTS; i++)
+    {
+        stats->variant_conversion_time[i] = 0;
+        stats->variant_frames[i] = 0;
+    }
+}
+
+// 设置变体名称
+void frame_stats_set_variants(frame_stats_t* stats, const char *const *names, uint32_t count)
+{
+    if (stats == NULL) return;
+
+    stats->variant_count = count < FRAME_STATS_MAX_VARIANTS ? count : FRAME_STATS_MAX_VARIANTS;
+    stats->variant_names = names;
+    frame_stats_clear_variants(stats);
 }
 
 // 更新帧统计并可选择性打印
@@ -43,9 +65,28 @@ void frame_stats_update(frame_stats_t* stats,
         stats->total_conversion_time = 0;
         stats->total_transfer_time = 0;
         stats->total_frames = 0;
+        frame_stats_clear_variants(stats);
     }
 }
 
+// 更新帧统计，转换时间同时计入指定变体
+void frame_stats_update_variant(frame_stats_t* stats,
+                                uint32_t variant,
+                                uint32_t conversion_time_us,
+                                uint32_t transfer_time_us,
+                                bool used_dma)
+{
+    if (stats == NULL) return;
+
+    // 先计入变体：frame_stats_update 可能打印并清零
+    if (variant < stats->variant_count)
+    {
+        stats->variant_conversion_time[variant] += conversion_time_us;
+        stats->variant_frames[variant]++;
+    }
+    frame_stats_update(stats, conversion_time_us, transfer_time_us, used_dma);
+}
+
 // 强制打印当前统计信息
 void frame_stats_print_now(frame_stats_t* stats, bool used_dma)
 {
@@ -70,6 +111,19 @@ void frame_stats_print_now(frame_stats_t* stats, bool used_dma)
            avg_total_time, avg_transfer_speed_mbps);
     printf("  • 帧率: %.1f FPS, 数据处理: 240x240 ⇒ %.1fKB\n",
            (float)stats->frame_count * 1000.0f / time_duration, stats->data_size_kb);
+
+    // 各变体的平均转换时间 (只列出这段时间里出现过的)
+    if (stats->variant_count > 0)
+    {
+        printf("  • 分项平均转换:");
+        for (uint32_t i = 0; i < stats->variant_count; i++)
+        {
+            if (stats->variant_frames[i] == 0) continue;
+            printf(" %s %luμs(%lu帧)", stats->variant_names[i],
+                   stats->variant_conversion_time[i] / stats->variant_frames[i], stats->variant_frames[i]);
+        }
+        printf("\n");
+    }
 }
 
 // 重置统计信息
@@ -82,4 +136,5 @@ void frame_stats_reset(frame_stats_t* stats)
     stats->total_transfer_time = 0;
     stats->total_frames = 0;
     stats->last_print_time_ms = time_us_64() / 1000;
+    frame_stats_clear_variants(stats);
 }
\ No newline at end of file
@@ -4,6 +4,9 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+// 按变体 (如旋转角度) 分开统计转换时间的最大变体数
+#define FRAME_STATS_MAX_VARIANTS 4
+
 // 帧统计结构体
 typedef struct {
     uint32_t frame_count;
@@ -13,6 +16,11 @@ typedef struct {
     uint32_t last_print_time_ms;
     const char* display_name;  // 显示器名称，如"ST7789"或"ST75320"
     float data_size_kb;        // 数据大小 (KB)
+    // 按变体分开累计的转换时间 (variant_count为0时不统计)
+    uint32_t variant_count;
+    const char *const *variant_names;
+    uint32_t variant_conversion_time[FRAME_STATS_MAX_VARIANTS];
+    uint32_t variant_frames[FRAME_STATS_MAX_VARIANTS];
 } frame_stats_t;
 
 // 初始化帧统计
@@ -24,6 +32,16 @@ void frame_stats_update(frame_stats_t* stats,
                        uint32_t transfer_time_us,
                        bool used_dma);
 
+// 设置变体名称 (最多 FRAME_STATS_MAX_VARIANTS 个，names 必须一直有效)，打印时按变体列出平均转换时间
+void frame_stats_set_variants(frame_stats_t* stats, const char *const *names, uint32_t count);
+
+// 同 frame_stats_update，并把转换时间计入第 variant 个变体
+void frame_stats_update_variant(frame_stats_t* stats,
+                                uint32_t variant,
+                                uint32_t conversion_time_us,
+                                uint32_t transfer_time_us,
+                                bool used_dma);
+
 // 强制打印当前统计信息
 void frame_stats_print_now(frame_stats_t* stats, bool used_dma);
 
@@ -0,0 +1,130 @@
+// =============================================================================
+// 主机端 .cap 文件读写
+// =============================================================================
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "capture_store.h"
+
+// =============================================================================
+// 读取 (mmap)
+// =============================================================================
+bool capture_reader_open(capture_reader_t *reader, const char *path)
+{
+    memset(reader, 0, sizeof(*reader));
+    reader->fd = open(path, O_RDONLY);
+    if (reader->fd < 0)
+    {
+        perror(path);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(reader->fd, &st) != 0 || (size_t)st.st_size < sizeof(capture_file_header_t))
+    {
+        fprintf(stderr, "%s: 不是捕获文件\n", path);
+        close(reader->fd);
+        return false;
+    }
+
+    reader->map_size = (size_t)st.st_size;
+    void *map = mmap(NULL, reader->map_size, PROT_READ, MAP_SHARED, reader->fd, 0);
+    if (map == MAP_FAILED)
+    {
+        perror("mmap");
+        close(reader->fd);
+        return false;
+    }
+    reader->map = map;
+    reader->header = (const capture_file_header_t *)map;
+
+    if (!capture_file_header_valid(reader->header))
+    {
+        fprintf(stderr, "%s: 文件头无效或版本不支持\n", path);
+        capture_reader_close(reader);
+        return false;
+    }
+
+    // 尾部不完整的记录 (写入中断) 直接忽略
+    reader->count = (uint32_t)((reader->map_size - reader->header->header_size) / reader->header->record_size);
+    madvise(map, reader->map_size, MADV_SEQUENTIAL);
+    return true;
+}
+
+void capture_reader_close(capture_reader_t *reader)
+{
+    if (reader->map != NULL)
+        munmap((void *)reader->map, reader->map_size);
+    if (reader->fd >= 0)
+        close(reader->fd);
+    memset(reader, 0, sizeof(*reader));
+    reader->fd = -1;
+}
+
+// =============================================================================
+// 追加写入
+// =============================================================================
+bool capture_writer_open(capture_writer_t *writer, const char *path)
+{
+    memset(writer, 0, sizeof(*writer));
+    writer->fp = fopen(path, "a+b");
+    if (writer->fp == NULL)
+    {
+        perror(path);
+        return false;
+    }
+
+    fseek(writer->fp, 0, SEEK_END);
+    long size = ftell(writer->fp);
+
+    if (size == 0)
+    {
+        capture_file_header_t header;
+        capture_file_header_init(&header);
+        if (fwrite(&header, sizeof(header), 1, writer->fp) != 1)
+        {
+            perror(path);
+            fclose(writer->fp);
+            return false;
+        }
+        return true;
+    }
+
+    capture_file_header_t header;
+    fseek(writer->fp, 0, SEEK_SET);
+    if (fread(&header, sizeof(header), 1, writer->fp) != 1 || !capture_file_header_valid(&header))
+    {
+        fprintf(stderr, "%s: 已存在且不是兼容的捕获文件\n", path);
+        fclose(writer->fp);
+        return false;
+    }
+
+    // 截掉上次中断留下的不完整记录，保证新记录对齐
+    long body = size - header.header_size;
+    long complete = header.header_size + (body / (long)header.record_size) * (long)header.record_size;
+    if (complete != size && ftruncate(fileno(writer->fp), complete) != 0)
+    {
+        perror(path);
+        fclose(writer->fp);
+        return false;
+    }
+    fseek(writer->fp, 0, SEEK_END);
+    return true;
+}
+
+bool capture_writer_append(capture_writer_t *writer, const capture_record_t *record)
+{
+    if (fwrite(record, sizeof(*record), 1, writer->fp) != 1)
+        return false;
+    writer->count++;
+    return true;
+}
+
+void capture_writer_close(capture_writer_t *writer)
+{
+    if (writer->fp != NULL)
+        fclose(writer->fp);
+    writer->fp = NULL;
+}
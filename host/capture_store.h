@@ -0,0 +1,38 @@
+// =============================================================================
+// 主机端 .cap 文件读写 (格式见 capture_file.h)
+// 读：mmap整个文件按下标访问记录；写：只追加
+// =============================================================================
+#ifndef CAPTURE_STORE_H
+#define CAPTURE_STORE_H
+
+#include <stdio.h>
+#include "capture_file.h"
+
+typedef struct {
+    int fd;
+    const uint8_t *map;
+    size_t map_size;
+    const capture_file_header_t *header;
+    uint32_t count;
+} capture_reader_t;
+
+typedef struct {
+    FILE *fp;
+    uint32_t count; // 本次打开后追加的记录数
+} capture_writer_t;
+
+bool capture_reader_open(capture_reader_t *reader, const char *path);
+void capture_reader_close(capture_reader_t *reader);
+
+static inline const capture_record_t *capture_reader_record(const capture_reader_t *reader, uint32_t index)
+{
+    return (const capture_record_t *)(reader->map + reader->header->header_size +
+                                      (size_t)index * reader->header->record_size);
+}
+
+// 打开文件用于追加：不存在或为空时写入文件头，已有文件则校验文件头并截掉不完整的尾记录
+bool capture_writer_open(capture_writer_t *writer, const char *path);
+bool capture_writer_append(capture_writer_t *writer, const capture_record_t *record);
+void capture_writer_close(capture_writer_t *writer);
+
+#endif // CAPTURE_STORE_H
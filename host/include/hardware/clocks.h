@@ -0,0 +1,22 @@
+#ifndef _HARDWARE_CLOCKS_H
+#define _HARDWARE_CLOCKS_H
+
+#include "pico.h"
+
+// 模拟的系统时钟与SDK默认值一致 (RP2350: 150MHz)
+#define SIM_CLK_SYS_HZ 150000000u
+
+enum clock_index {
+    clk_gpout0 = 0,
+    clk_ref = 4,
+    clk_sys = 5,
+    clk_peri = 6,
+};
+
+static inline uint32_t clock_get_hz(enum clock_index clk_index)
+{
+    (void)clk_index;
+    return SIM_CLK_SYS_HZ;
+}
+
+#endif // _HARDWARE_CLOCKS_H
@@ -0,0 +1,135 @@
+#ifndef _HARDWARE_DMA_H
+#define _HARDWARE_DMA_H
+
+#include "pico.h"
+
+#define NUM_DMA_CHANNELS 16
+
+enum dma_channel_transfer_size {
+    DMA_SIZE_8 = 0,
+    DMA_SIZE_16 = 1,
+    DMA_SIZE_32 = 2
+};
+
+// DREQ编号与RP2350一致
+enum {
+    DREQ_PIO0_TX0 = 0,
+    DREQ_PIO0_RX0 = 4,
+    DREQ_PIO1_TX0 = 8,
+    DREQ_PIO1_RX0 = 12,
+    DREQ_PIO2_TX0 = 16,
+    DREQ_PIO2_RX0 = 20,
+    DREQ_SPI0_TX = 24,
+    DREQ_SPI0_RX = 25,
+    DREQ_SPI1_TX = 26,
+    DREQ_SPI1_RX = 27,
+    DREQ_FORCE = 0x3f,
+};
+
+// 通道寄存器 (地址寄存器按主机指针宽度)
+// 只模拟控制块用到的别名 AL3 的 {TRANS_COUNT, READ_ADDR_TRIG}：与 {uint32_t, 指针} 结构体布局相同，
+// 按结构体大小对齐，控制通道可以用写环绕反复写入；写入非0的READ_ADDR_TRIG启动通道 (写0为空触发)
+typedef struct {
+    io_rw_addr read_addr;
+    io_rw_addr write_addr;
+    io_rw_32 transfer_count;
+    io_rw_32 ctrl_trig;
+    _Alignas(2 * sizeof(io_rw_addr)) io_rw_32 al3_transfer_count;
+    io_rw_addr al3_read_addr_trig;
+} dma_channel_hw_t;
+
+typedef struct {
+    dma_channel_hw_t ch[NUM_DMA_CHANNELS];
+    io_rw_32 intr;
+    io_rw_32 inte0;
+    io_rw_32 inte1;
+    io_rw_32 ints0;
+    io_rw_32 ints1;
+    io_rw_32 sniff_ctrl;
+    io_rw_32 sniff_data;
+} dma_hw_t;
+
+extern dma_hw_t *const dma_hw;
+
+typedef struct {
+    uint32_t data_size;
+    uint32_t dreq;
+    uint32_t chain_to;
+    uint32_t ring_size_bits;
+    bool ring_write;
+    bool read_increment;
+    bool write_increment;
+    bool enable;
+    bool irq_quiet;
+    bool sniff_enable;
+    bool bswap;
+    bool high_priority;
+} dma_channel_config;
+
+static inline dma_channel_hw_t *dma_channel_hw_addr(uint channel)
+{
+    return &dma_hw->ch[channel];
+}
+
+int dma_claim_unused_channel(bool required);
+void dma_channel_claim(uint channel);
+void dma_channel_unclaim(uint channel);
+bool dma_channel_is_claimed(uint channel);
+
+dma_channel_config dma_channel_get_default_config(uint channel);
+dma_channel_config dma_get_channel_config(uint channel);
+
+static inline void channel_config_set_read_increment(dma_channel_config *c, bool incr) { c->read_increment = incr; }
+static inline void channel_config_set_write_increment(dma_channel_config *c, bool incr) { c->write_increment = incr; }
+static inline void channel_config_set_dreq(dma_channel_config *c, uint dreq) { c->dreq = dreq; }
+static inline void channel_config_set_chain_to(dma_channel_config *c, uint chain_to) { c->chain_to = chain_to; }
+static inline void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size) { c->data_size = size; }
+static inline void channel_config_set_ring(dma_channel_config *c, bool write, uint size_bits)
+{
+    c->ring_write = write;
+    c->ring_size_bits = size_bits;
+}
+static inline void channel_config_set_bswap(dma_channel_config *c, bool bswap) { c->bswap = bswap; }
+static inline void channel_config_set_irq_quiet(dma_channel_config *c, bool irq_quiet) { c->irq_quiet = irq_quiet; }
+static inline void channel_config_set_high_priority(dma_channel_config *c, bool high_priority) { c->high_priority = high_priority; }
+static inline void channel_config_set_enable(dma_channel_config *c, bool enable) { c->enable = enable; }
+static inline void channel_config_set_sniff_enable(dma_channel_config *c, bool sniff_enable) { c->sniff_enable = sniff_enable; }
+
+void dma_channel_set_config(uint channel, const dma_channel_config *config, bool trigger);
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr, bool trigger);
+void dma_channel_set_write_addr(uint channel, volatile void *write_addr, bool trigger);
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger);
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trigger);
+void dma_channel_transfer_from_buffer_now(uint channel, const volatile void *read_addr, uint32_t transfer_count);
+void dma_channel_transfer_to_buffer_now(uint channel, volatile void *write_addr, uint32_t transfer_count);
+void dma_channel_start(uint channel);
+void dma_start_channel_mask(uint32_t chan_mask);
+void dma_channel_abort(uint channel);
+bool dma_channel_is_busy(uint channel);
+void dma_channel_wait_for_finish_blocking(uint channel);
+
+void dma_channel_set_irq0_enabled(uint channel, bool enabled);
+void dma_channel_set_irq1_enabled(uint channel, bool enabled);
+bool dma_channel_get_irq0_status(uint channel);
+bool dma_channel_get_irq1_status(uint channel);
+void dma_channel_acknowledge_irq0(uint channel);
+void dma_channel_acknowledge_irq1(uint channel);
+
+// 嗅探器 (sniffer)
+#define DMA_SNIFF_CTRL_CALC_VALUE_CRC32 0x0
+#define DMA_SNIFF_CTRL_CALC_VALUE_CRC32R 0x1
+#define DMA_SNIFF_CTRL_CALC_VALUE_CRC16 0x2
+#define DMA_SNIFF_CTRL_CALC_VALUE_CRC16R 0x3
+#define DMA_SNIFF_CTRL_CALC_VALUE_EVEN 0xe
+#define DMA_SNIFF_CTRL_CALC_VALUE_SUM 0xf
+
+void dma_sniffer_enable(uint channel, uint mode, bool force_channel_enable);
+void dma_sniffer_disable(void);
+void dma_sniffer_set_byte_swap_enabled(bool swap);
+void dma_sniffer_set_output_invert_enabled(bool invert);
+void dma_sniffer_set_output_reverse_enabled(bool reverse);
+void dma_sniffer_set_data_accumulator(uint32_t seed_value);
+uint32_t dma_sniffer_get_data_accumulator(void);
+
+#endif // _HARDWARE_DMA_H
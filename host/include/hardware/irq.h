@@ -0,0 +1,33 @@
+#ifndef _HARDWARE_IRQ_H
+#define _HARDWARE_IRQ_H
+
+#include "pico.h"
+
+// RP2350 IRQ编号 (只列出固件用到的)
+#define TIMER0_IRQ_0 0
+#define PIO0_IRQ_0 15
+#define PIO0_IRQ_1 16
+#define PIO1_IRQ_0 17
+#define PIO1_IRQ_1 18
+#define PIO2_IRQ_0 19
+#define PIO2_IRQ_1 20
+#define IO_IRQ_BANK0 21
+#define DMA_IRQ_0 10
+#define DMA_IRQ_1 11
+#define DMA_IRQ_2 12
+#define DMA_IRQ_3 13
+#define SIO_IRQ_FIFO 25
+#define NUM_IRQS 52
+
+#define PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY 0x80
+
+typedef void (*irq_handler_t)(void);
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler);
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority);
+void irq_remove_handler(uint num, irq_handler_t handler);
+void irq_set_enabled(uint num, bool enabled);
+bool irq_is_enabled(uint num);
+void irq_set_priority(uint num, uint8_t hardware_priority);
+
+#endif // _HARDWARE_IRQ_H
@@ -0,0 +1,191 @@
+#ifndef _HARDWARE_PIO_H
+#define _HARDWARE_PIO_H
+
+#include "pico.h"
+#include "hardware/gpio.h"
+
+#define NUM_PIOS 3
+#define NUM_PIO_STATE_MACHINES 4
+#define PIO_INSTRUCTION_COUNT 32
+
+#define PIO_FDEBUG_TXSTALL_LSB 24
+
+typedef struct {
+    io_rw_32 fdebug;
+    io_wo_32 txf[NUM_PIO_STATE_MACHINES];
+    io_ro_32 rxf[NUM_PIO_STATE_MACHINES];
+    io_rw_32 irq;
+    io_rw_32 inte0;
+    io_rw_32 rxf_putget[NUM_PIO_STATE_MACHINES][4]; // RP2350: FJOIN_RX_GET/PUT时的RX FIFO存储
+} pio_hw_t;
+
+typedef pio_hw_t *PIO;
+
+extern pio_hw_t *const pio0;
+extern pio_hw_t *const pio1;
+extern pio_hw_t *const pio2;
+
+typedef struct {
+    const uint16_t *instructions;
+    uint8_t length;
+    int8_t origin;
+    uint8_t pio_version;
+} pio_program_t;
+
+typedef struct {
+    uint32_t clkdiv_int;
+    float clkdiv;
+    uint in_base;
+    uint out_base;
+    uint out_count;
+    uint set_base;
+    uint set_count;
+    uint sideset_base;
+    uint sideset_bits;      // 含可选使能位
+    bool sideset_optional;
+    bool sideset_pindirs;
+    uint jmp_pin;
+    bool in_shift_right;
+    bool in_autopush;
+    uint in_push_threshold;
+    bool out_shift_right;
+    bool out_autopull;
+    uint out_pull_threshold;
+    uint fifo_join;
+    uint status_sel;
+    uint status_n;
+    uint wrap_target;
+    uint wrap;
+} pio_sm_config;
+
+enum pio_fifo_join {
+    PIO_FIFO_JOIN_NONE = 0,
+    PIO_FIFO_JOIN_TX = 1,
+    PIO_FIFO_JOIN_RX = 2,
+    PIO_FIFO_JOIN_TXGET = 4,
+    PIO_FIFO_JOIN_TXPUT = 8,
+    PIO_FIFO_JOIN_PUTGET = 12,
+};
+
+enum pio_mov_status_type {
+    STATUS_TX_LESSTHAN = 0,
+    STATUS_RX_LESSTHAN = 1,
+};
+
+enum pio_interrupt_source {
+    pis_interrupt0 = 8,
+    pis_interrupt1 = 9,
+    pis_interrupt2 = 10,
+    pis_interrupt3 = 11,
+};
+
+static inline pio_sm_config pio_get_default_sm_config(void)
+{
+    pio_sm_config c = {0};
+    c.clkdiv = 1.0f;
+    c.in_shift_right = true;
+    c.out_shift_right = true;
+    c.in_push_threshold = 32;
+    c.out_pull_threshold = 32;
+    c.wrap = 31;
+    return c;
+}
+
+static inline void sm_config_set_in_pins(pio_sm_config *c, uint in_base) { c->in_base = in_base; }
+static inline void sm_config_set_in_pin_base(pio_sm_config *c, uint in_base) { c->in_base = in_base; }
+static inline void sm_config_set_out_pins(pio_sm_config *c, uint out_base, uint out_count)
+{
+    c->out_base = out_base;
+    c->out_count = out_count;
+}
+static inline void sm_config_set_set_pins(pio_sm_config *c, uint set_base, uint set_count)
+{
+    c->set_base = set_base;
+    c->set_count = set_count;
+}
+static inline void sm_config_set_sideset_pins(pio_sm_config *c, uint sideset_base) { c->sideset_base = sideset_base; }
+static inline void sm_config_set_sideset(pio_sm_config *c, uint bit_count, bool optional, bool pindirs)
+{
+    c->sideset_bits = bit_count;
+    c->sideset_optional = optional;
+    c->sideset_pindirs = pindirs;
+}
+static inline void sm_config_set_jmp_pin(pio_sm_config *c, uint pin) { c->jmp_pin = pin; }
+static inline void sm_config_set_clkdiv(pio_sm_config *c, float div) { c->clkdiv = div; }
+static inline void sm_config_set_in_shift(pio_sm_config *c, bool shift_right, bool autopush, uint push_threshold)
+{
+    c->in_shift_right = shift_right;
+    c->in_autopush = autopush;
+    c->in_push_threshold = push_threshold;
+}
+static inline void sm_config_set_out_shift(pio_sm_config *c, bool shift_right, bool autopull, uint pull_threshold)
+{
+    c->out_shift_right = shift_right;
+    c->out_autopull = autopull;
+    c->out_pull_threshold = pull_threshold;
+}
+static inline void sm_config_set_fifo_join(pio_sm_config *c, enum pio_fifo_join join) { c->fifo_join = join; }
+static inline void sm_config_set_mov_status(pio_sm_config *c, enum pio_mov_status_type status_sel, uint status_n)
+{
+    c->status_sel = status_sel;
+    c->status_n = status_n;
+}
+static inline void sm_config_set_wrap(pio_sm_config *c, uint wrap_target, uint wrap)
+{
+    c->wrap_target = wrap_target;
+    c->wrap = wrap;
+}
+
+static inline uint pio_encode_jmp(uint addr) { return 0x0000u | (addr & 0x1fu); }
+static inline uint pio_encode_set(uint dest, uint value) { return 0xe000u | (dest << 5) | (value & 0x1fu); }
+static inline uint pio_encode_mov(uint dest, uint src) { return 0xa000u | (dest << 5) | (src & 7u); }
+static inline uint pio_encode_pull(bool if_empty, bool block) { return 0x8080u | (if_empty ? 0x40u : 0) | (block ? 0x20u : 0); }
+static inline uint pio_encode_out(uint dest, uint count) { return 0x6000u | (dest << 5) | (count & 0x1fu); }
+
+enum pio_src_dest {
+    pio_pins = 0u,
+    pio_x = 1u,
+    pio_y = 2u,
+    pio_null = 3u,
+    pio_pindirs = 4u,
+    pio_exec_mov = 4u,
+    pio_status = 5u,
+    pio_pc = 5u,
+    pio_isr = 6u,
+    pio_osr = 7u,
+};
+
+uint pio_get_index(PIO pio);
+uint pio_get_dreq(PIO pio, uint sm, bool is_tx);
+bool pio_can_add_program(PIO pio, const pio_program_t *program);
+uint pio_add_program(PIO pio, const pio_program_t *program);
+void pio_remove_program(PIO pio, const pio_program_t *program, uint loaded_offset);
+int pio_claim_unused_sm(PIO pio, bool required);
+void pio_sm_claim(PIO pio, uint sm);
+void pio_sm_unclaim(PIO pio, uint sm);
+bool pio_claim_free_sm_and_add_program(const pio_program_t *program, PIO *pio, uint *sm, uint *offset);
+void pio_gpio_init(PIO pio, uint pin);
+int pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint pin_base, uint pin_count, bool is_out);
+void pio_sm_set_pins_with_mask(PIO pio, uint sm, uint32_t pin_values, uint32_t pin_mask);
+void pio_sm_set_pindirs_with_mask(PIO pio, uint sm, uint32_t pin_dirs, uint32_t pin_mask);
+int pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config *config);
+void pio_sm_set_config(PIO pio, uint sm, const pio_sm_config *config);
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled);
+void pio_sm_restart(PIO pio, uint sm);
+void pio_sm_clear_fifos(PIO pio, uint sm);
+void pio_sm_exec(PIO pio, uint sm, uint instr);
+void pio_sm_set_clkdiv(PIO pio, uint sm, float div);
+uint pio_sm_get_rx_fifo_level(PIO pio, uint sm);
+bool pio_sm_is_rx_fifo_empty(PIO pio, uint sm);
+bool pio_sm_is_tx_fifo_empty(PIO pio, uint sm);
+uint32_t pio_sm_get(PIO pio, uint sm);
+uint32_t pio_sm_get_blocking(PIO pio, uint sm);
+void pio_sm_put(PIO pio, uint sm, uint32_t data);
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data);
+uint8_t pio_sm_get_pc(PIO pio, uint sm);
+
+void pio_interrupt_clear(PIO pio, uint pio_interrupt_num);
+bool pio_interrupt_get(PIO pio, uint pio_interrupt_num);
+void pio_set_irq0_source_enabled(PIO pio, enum pio_interrupt_source source, bool enabled);
+
+#endif // _HARDWARE_PIO_H
@@ -0,0 +1,16 @@
+#ifndef _HARDWARE_TIMER_H
+#define _HARDWARE_TIMER_H
+
+#include "pico.h"
+
+// 模拟时钟：主机单调时钟 + 模拟总线/睡眠推进量 (见 sim_hal.h)
+uint64_t time_us_64(void);
+
+static inline uint32_t time_us_32(void)
+{
+    return (uint32_t)time_us_64();
+}
+
+void busy_wait_us(uint64_t delay_us);
+
+#endif // _HARDWARE_TIMER_H
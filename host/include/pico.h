@@ -0,0 +1,37 @@
+// =============================================================================
+// 主机模拟HAL: pico.h
+// 只提供固件源码用到的Pico SDK子集，行为由 host/sim_*.c 模拟
+// =============================================================================
+#ifndef _PICO_H
+#define _PICO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef unsigned int uint;
+
+typedef volatile uint32_t io_rw_32;
+typedef const volatile uint32_t io_ro_32;
+typedef volatile uint32_t io_wo_32;
+// 主机指针为64位，DMA地址寄存器按指针宽度模拟
+typedef volatile uintptr_t io_rw_addr;
+
+#define __not_in_flash_func(func_name) func_name
+#define __time_critical_func(func_name) func_name
+#define __scratch_x(group) __attribute__((section(".bss.scratch_x." group)))
+#define __unused __attribute__((unused))
+#define __force_inline inline __attribute__((always_inline))
+
+#define PICO_ON_DEVICE 0
+#define LIB_PICO_HOST_SIM 1
+
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+
+// 主循环/忙等待中的让步点：推进模拟事件(DMA完成、X3501信号源等)
+void tight_loop_contents(void);
+void __wfi(void);
+
+void panic(const char *fmt, ...);
+
+#endif // _PICO_H
@@ -0,0 +1,11 @@
+#ifndef _PICO_STDLIB_H
+#define _PICO_STDLIB_H
+
+#include "pico.h"
+#include "pico/time.h"
+#include "hardware/gpio.h"
+#include "hardware/timer.h"
+
+bool stdio_init_all(void);
+
+#endif // _PICO_STDLIB_H
@@ -0,0 +1,17 @@
+#ifndef _PICO_SYNC_H
+#define _PICO_SYNC_H
+
+#include "pico.h"
+#include "hardware/sync.h"
+
+// 模拟实现：进入临界区即屏蔽模拟中断分发(等价于固件上的关中断+自旋锁)
+typedef struct {
+    volatile uint32_t depth;
+} critical_section_t;
+
+void critical_section_init(critical_section_t *crit_sec);
+void critical_section_enter_blocking(critical_section_t *crit_sec);
+void critical_section_exit(critical_section_t *crit_sec);
+void critical_section_deinit(critical_section_t *crit_sec);
+
+#endif // _PICO_SYNC_H
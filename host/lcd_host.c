@@ -0,0 +1,2328 @@
+// =============================================================================
+// lcd_host - 主机端捕获→转换→输出流水线
+//
+// 与固件使用同一份 lcd_framebuffer.c / spi_lcd.c / lcd_st75320.c / frame_stats.c，
+// 底层换成 host/ 下的模拟HAL。用于在Linux上剖析转换代码 (perf/valgrind)，
+// 并用SPI/DMA计数器发现吞吐量回退。
+//
+// 用法:
+//   lcd_host bench [--lcd st7789|st75320] [--color rgb565|rgb444] [--engine lut|pio] [--te] [--beam] [--link pio|spi] [--address once|page] [--frames N] [--virtual] [--irq-latency US] [--fault-every N]
+//   lcd_host synth <out.cap> [--frames N]
+//   lcd_host import <serial.log> <out.cap>
+//   lcd_host replay <in.cap> [--lcd ...] [--speed original|max] [--virtual]
+//   lcd_host stress [--frames N]
+//   lcd_host faults [--frames N] [--fault-every N] [--irq-latency US]
+//   lcd_host verify [in.cap] [--color rgb565|rgb444] [--frames N]   (ST7789输出引擎 + ST75320转换内核/输出链路)
+//   lcd_host kernels [--frames N]
+// =============================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "hardware/spi.h"
+#include "lcd_framebuffer.h"
+#include "lcd_triple_buffer.h"
+#include "spi_lcd.h"
+#include "lcd_st75320.h"
+#include "capture_file.h"
+#include "capture_store.h"
+#include "sim_hal.h"
+
+// 与 lcd_converter.c 一致
+#define LCD_CAPTURE_PIO pio0
+#define LCD_CAPTURE_SM 0
+#define LCD_MONITOR_PIO pio2
+#define LCD_MONITOR_LINE_SM 0
+#define LCD_MONITOR_CLOCK_SM 1
+
+// X3501 实测时序：帧周期约14ms，FRAME到最后一行约13.8ms
+#define X3501_FRAME_PERIOD_US 14000
+#define X3501_ACTIVE_US 13800
+
+#define FRAME_BYTES SIM_X3501_FRAME_BYTES
+#define ROW_BYTES 30
+
+typedef enum {
+    HOST_LCD_ST7789 = 0,
+    HOST_LCD_ST75320 = 1
+} host_lcd_t;
+
+typedef enum {
+    REPLAY_SPEED_ORIGINAL = 0, // 按记录的时间戳间隔提交
+    REPLAY_SPEED_MAX = 1       // 显示完一帧立即提交下一帧
+} replay_speed_t;
+
+#define HOST_MAX_ARGS 4
+
+typedef struct {
+    host_lcd_t lcd;
+    lcd_color_format_t color; // ST7789像素格式
+    lcd_output_engine_t engine; // ST7789输出引擎
+    bool st7789_te;             // ST7789按TE节拍送显
+    bool beam;                  // 追帧送显：不等整帧，按带送出已经捕获的行
+    bool st75320_pio_link;      // ST75320经pio1显示链路发送
+    bool st75320_contiguous;    // ST75320整页宽度的连续页只寻址一次
+    uint32_t frames;
+    sim_time_mode_t time_mode;
+    uint32_t irq_latency_us;
+    uint32_t fault_every;
+    replay_speed_t speed;
+    bool frames_set;
+    const char *args[HOST_MAX_ARGS]; // 位置参数 (文件名)
+    int arg_count;
+} host_options_t;
+
+// =============================================================================
+// 主机时间 (真实CPU耗时，不含模拟总线等待)
+// =============================================================================
+static uint64_t host_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// =============================================================================
+// 捕获PIO (lcd_capture.pio 的主机等价配置，程序长度与原程序一致)
+// =============================================================================
+static const uint16_t host_capture_instructions[16] = {0};
+static const pio_program_t host_capture_program = {
+    .instructions = host_capture_instructions,
+    .length = 16,
+    .origin = 0,
+};
+
+static void init_capture_pio(void)
+{
+    uint offset = pio_add_program(LCD_CAPTURE_PIO, &host_capture_program);
+    pio_sm_claim(LCD_CAPTURE_PIO, LCD_CAPTURE_SM);
+
+    pio_sm_config c = pio_get_default_sm_config();
+    sm_config_set_in_pins(&c, 5);
+    sm_config_set_in_shift(&c, true, true, 32);
+    sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_RX);
+    sm_config_set_jmp_pin(&c, 2);
+    pio_sm_init(LCD_CAPTURE_PIO, LCD_CAPTURE_SM, offset, &c);
+}
+
+// 帧完整性监视 (lcd_line_monitor 8条 + lcd_dataclk_monitor 15条)，计数由X3501模型推送
+static const uint16_t host_monitor_instructions[15] = {0};
+static const pio_program_t host_line_monitor_program = {
+    .instructions = host_monitor_instructions,
+    .length = 8,
+    .origin = -1,
+};
+static const pio_program_t host_dataclk_monitor_program = {
+    .instructions = host_monitor_instructions,
+    .length = 15,
+    .origin = -1,
+};
+
+static bool init_monitor_pio(void)
+{
+    uint line_offset = pio_add_program(LCD_MONITOR_PIO, &host_line_monitor_program);
+    uint clock_offset = pio_add_program(LCD_MONITOR_PIO, &host_dataclk_monitor_program);
+    pio_sm_claim(LCD_MONITOR_PIO, LCD_MONITOR_LINE_SM);
+    pio_sm_claim(LCD_MONITOR_PIO, LCD_MONITOR_CLOCK_SM);
+
+    pio_sm_config c = pio_get_default_sm_config();
+    sm_config_set_jmp_pin(&c, 2);
+    sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_RX);
+    pio_sm_init(LCD_MONITOR_PIO, LCD_MONITOR_LINE_SM, line_offset, &c);
+
+    c = pio_get_default_sm_config();
+    sm_config_set_in_pin_base(&c, 4);
+    sm_config_set_jmp_pin(&c, 3);
+    pio_sm_init(LCD_MONITOR_PIO, LCD_MONITOR_CLOCK_SM, clock_offset, &c);
+    pio_sm_put(LCD_MONITOR_PIO, LCD_MONITOR_CLOCK_SM, LCD_FB_WIDTH / 4);
+
+    pio_sm_set_enabled(LCD_MONITOR_PIO, LCD_MONITOR_LINE_SM, true);
+    pio_sm_set_enabled(LCD_MONITOR_PIO, LCD_MONITOR_CLOCK_SM, true);
+    return lcd_framebuffer_init_integrity_monitor(LCD_MONITOR_PIO, LCD_MONITOR_LINE_SM, LCD_MONITOR_CLOCK_SM);
+}
+
+// =============================================================================
+// 合成帧：类似示波表界面 (边框、网格、移动波形、读数块)
+// =============================================================================
+static inline void synth_set(uint8_t *frame, int x, int y)
+{
+    if (x < 0 || x >= LCD_FB_WIDTH || y < 0 || y >= LCD_FB_HEIGHT)
+        return;
+    frame[y * ROW_BYTES + x / 8] |= (uint8_t)(1u << (x % 8));
+}
+
+static void synth_frame(uint32_t index, uint8_t *frame)
+{
+    memset(frame, 0, FRAME_BYTES);
+
+    // 边框
+    for (int i = 0; i < LCD_FB_WIDTH; i++)
+    {
+        synth_set(frame, i, 0);
+        synth_set(frame, i, 179);
+        synth_set(frame, 0, i * 180 / LCD_FB_WIDTH);
+        synth_set(frame, 239, i * 180 / LCD_FB_WIDTH);
+    }
+
+    // 点状网格
+    for (int y = 20; y < 180; y += 20)
+        for (int x = 0; x < LCD_FB_WIDTH; x += 4)
+            synth_set(frame, x, y);
+    for (int x = 24; x < LCD_FB_WIDTH; x += 24)
+        for (int y = 0; y < 180; y += 4)
+            synth_set(frame, x, y);
+
+    // 波形 (约12Hz平移一次；X3501以约71Hz重复刷新同一画面)
+    int phase = (int)(index / 6) * 3;
+    int last_y = -1;
+    for (int x = 1; x < 239; x++)
+    {
+        int y = 90 + (int)(60.0 * sin((x + phase) * 0.0785));
+        if (last_y >= 0)
+        {
+            int step = (y > last_y) ? 1 : -1;
+            for (int yy = last_y; yy != y; yy += step)
+                synth_set(frame, x, yy);
+        }
+        synth_set(frame, x, y);
+        last_y = y;
+    }
+
+    // 读数区：每隔几帧变化一次的实心块
+    uint32_t reading = index / 24;
+    for (int digit = 0; digit < 5; digit++)
+    {
+        uint32_t value = (reading >> (digit * 3)) & 7;
+        int x0 = 20 + digit * 40;
+        for (int y = 190; y < 230; y++)
+            for (int x = x0; x < x0 + 8 + (int)value * 3; x++)
+                synth_set(frame, x, y);
+    }
+}
+
+typedef struct {
+    uint32_t limit;
+    uint32_t fault_every; // 0 = 不注入故障
+    uint32_t injected;    // 已注入的故障帧数
+    uint32_t last_index;  // 最近发送的帧序号
+} synth_source_t;
+
+static bool synth_next_frame(void *ctx, uint32_t index, uint8_t *frame, uint32_t *period_us)
+{
+    synth_source_t *src = (synth_source_t *)ctx;
+    (void)period_us;
+    if (index >= src->limit)
+        return false;
+    synth_frame(index, frame);
+    src->last_index = index;
+    return true;
+}
+
+// 每fault_every帧注入一次信号故障，依次为：少一行、多一行、一行少一个DATACLK、一行多一个DATACLK
+static void synth_fault(void *ctx, uint32_t index, sim_x3501_fault_t *fault)
+{
+    synth_source_t *src = (synth_source_t *)ctx;
+    if (src->fault_every == 0 || index == 0 || index % src->fault_every != 0)
+        return;
+
+    src->injected++;
+    switch ((index / src->fault_every) % 4)
+    {
+    case 1:
+        fault->lines = SIM_X3501_LINES - 1;
+        break;
+    case 2:
+        fault->lines = SIM_X3501_LINES + 1;
+        break;
+    case 3:
+        fault->bad_line = 100;
+        fault->bad_line_clocks = LCD_FB_WIDTH / 4 - 1;
+        break;
+    default:
+        fault->bad_line = 100;
+        fault->bad_line_clocks = LCD_FB_WIDTH / 4 + 1;
+        break;
+    }
+}
+
+// =============================================================================
+// ST7789面板扫描模型：TE在每个刷新周期的消隐开始时上升，之后逐行扫描 (与 spi_lcd.c 的扫描模型相同：
+// 320条栅极线 + 24行前后沿)。面板振荡器与标称60Hz有偏差，驱动要靠测得的TE周期。
+// spi0的sink按DC电平解析RASET/RAMWR，像素字节从sink被调用的时刻 (DMA开始) 起按字节时间依次上线；
+// 每写完一行算出它第一次被显示的刷新周期。一帧的行分在两个刷新周期里显示就是撕裂
+// (那个周期里一部分行是新帧、一部分是旧帧)
+// =============================================================================
+#define HOST_PIN_DC 16 // 与 display_init 一致
+#define HOST_PIN_TE 22
+#define ST7789_PANEL_PERIOD_NS 16400000ull
+#define ST7789_PANEL_LINES 344
+#define ST7789_PANEL_BLANK_LINES 24
+
+typedef struct {
+    bool enabled;
+    uint64_t first_rise_ns;
+    uint64_t byte_ns;      // 像素字节的线上时间 (每个窗口开始时按spi0累计的总线时间/字节数更新)
+    uint64_t last_byte_ns; // 上一个字节的上线时刻
+    uint8_t cmd;
+    uint32_t arg;
+    uint16_t ys;           // RASET起始行
+    uint32_t pixel_bytes;  // RAMWR之后的像素字节数
+    uint32_t row_bytes;
+    int64_t min_refresh, max_refresh; // 当前帧各行第一次显示的刷新周期
+    bool frame_rows;                  // 当前帧写过像素行
+    uint32_t frames;
+    uint32_t torn;
+} panel_scan_t;
+
+static panel_scan_t panel_scan;
+
+// 在刷新周期k里，第row行在 first_rise + k x 周期 + (消隐 + row) x 行时间 被扫描；
+// 返回第一个在t之后扫描到该行的周期
+static int64_t panel_refresh_showing(uint64_t t, uint32_t row)
+{
+    uint64_t line_ns = ST7789_PANEL_PERIOD_NS / ST7789_PANEL_LINES;
+    int64_t offset = (int64_t)t - (int64_t)(panel_scan.first_rise_ns + (ST7789_PANEL_BLANK_LINES + row) * line_ns);
+    int64_t period = (int64_t)ST7789_PANEL_PERIOD_NS;
+    return offset <= 0 ? -((-offset) / period) : (offset + period - 1) / period;
+}
+
+static void panel_scan_byte(panel_scan_t *p, uint8_t b, uint64_t now)
+{
+    uint64_t t = p->last_byte_ns + p->byte_ns;
+    p->last_byte_ns = t > now ? t : now;
+    if (!gpio_get(HOST_PIN_DC))
+    {
+        p->cmd = b;
+        p->arg = 0;
+        if (b == 0x2C)
+        {
+            sim_spi_stats_t stats;
+            sim_spi_get_stats(spi0, &stats);
+            if (stats.bytes > 0)
+                p->byte_ns = stats.bus_time_ns / stats.bytes;
+            p->pixel_bytes = 0;
+        }
+        return;
+    }
+    if (p->cmd == 0x2B && p->arg < 2)
+        p->ys = (uint16_t)((p->arg == 0) ? b << 8 : (p->ys & 0xFF00) | b);
+    else if (p->cmd == 0x2C && ++p->pixel_bytes % p->row_bytes == 0)
+    {
+        uint32_t row = p->ys + p->pixel_bytes / p->row_bytes - 1;
+        int64_t k = panel_refresh_showing(p->last_byte_ns, row);
+        if (!p->frame_rows || k < p->min_refresh)
+            p->min_refresh = k;
+        if (!p->frame_rows || k > p->max_refresh)
+            p->max_refresh = k;
+        p->frame_rows = true;
+    }
+    p->arg++;
+}
+
+static void panel_scan_sink(void *ctx, const void *data, size_t frames, uint data_bits)
+{
+    panel_scan_t *p = (panel_scan_t *)ctx;
+    uint64_t now = sim_now_ns();
+    for (size_t i = 0; i < frames; i++)
+    {
+        if (data_bits == 16)
+        {
+            uint16_t v = ((const uint16_t *)data)[i];
+            panel_scan_byte(p, (uint8_t)(v >> 8), now);
+            panel_scan_byte(p, (uint8_t)v, now);
+        }
+        else
+        {
+            panel_scan_byte(p, ((const uint8_t *)data)[i], now);
+        }
+    }
+}
+
+// 上一帧的行全部写完之后才会提交下一帧：在提交时结算上一帧
+static void panel_scan_end_frame(void)
+{
+    if (!panel_scan.enabled || !panel_scan.frame_rows)
+        return;
+    panel_scan.frames++;
+    if (panel_scan.max_refresh != panel_scan.min_refresh)
+        panel_scan.torn++;
+    panel_scan.frame_rows = false;
+}
+
+static void panel_scan_start(lcd_color_format_t format)
+{
+    memset(&panel_scan, 0, sizeof(panel_scan));
+    panel_scan.enabled = true;
+    panel_scan.row_bytes = LCD_FB_WIDTH * (format == LCD_COLOR_RGB444 ? 12 : 16) / 8;
+    panel_scan.first_rise_ns = sim_now_ns() + ST7789_PANEL_PERIOD_NS;
+    sim_gpio_start_pulses(HOST_PIN_TE, panel_scan.first_rise_ns, ST7789_PANEL_PERIOD_NS,
+                          ST7789_PANEL_PERIOD_NS * ST7789_PANEL_BLANK_LINES / ST7789_PANEL_LINES);
+    sim_spi_set_sink(spi0, panel_scan_sink, &panel_scan);
+}
+
+static void panel_scan_stop(void)
+{
+    panel_scan_end_frame();
+    sim_gpio_stop_pulses();
+    sim_spi_set_sink(spi0, NULL, NULL);
+}
+
+// 固件的主循环一直在转，TE开始窗口可能在两个模拟事件之间打开：按TE节拍送显时
+// 每隔一小段模拟时间唤醒一次主循环，而不是直接跳到下一个事件
+#define TE_POLL_TICK_NS 20000ull
+
+static void te_poll_tick(void *ctx)
+{
+    (void)ctx;
+}
+
+static void te_poll_schedule(void)
+{
+    sim_cancel(te_poll_tick, NULL);
+    sim_schedule(sim_now_ns() + TE_POLL_TICK_NS, te_poll_tick, NULL);
+}
+
+// =============================================================================
+// 流水线：与 lcd_converter.c 的初始化顺序和主循环一致
+// =============================================================================
+static bool display_init(const host_options_t *opt)
+{
+    if (opt->lcd == HOST_LCD_ST75320)
+    {
+        lcd_init();
+        if (!lcd_set_pio_link(opt->st75320_pio_link) && opt->st75320_pio_link)
+            return false;
+        lcd_set_contiguous_refresh(opt->st75320_contiguous);
+    }
+    else
+    {
+        lcd_config_t config = LCD_CONFIG_ST7789_240x240;
+        config.spi_freq_hz = 80000000;
+        config.color_format = opt->color;
+        config.output_engine = opt->engine;
+        config.pin_cs = 17;
+        config.pin_dc = 16;
+        config.pin_rst = 20;
+        config.pin_sck = 18;
+        config.pin_mosi = 19;
+        config.pin_blk = 21;
+        config.pin_te = HOST_PIN_TE;
+        if (!spi_lcd_init(&config))
+        {
+            printf("错误: SPI LCD初始化失败\n");
+            return false;
+        }
+        spi_lcd_set_continuous_window(0, 0, 239, 239);
+        if (opt->st7789_te && !spi_lcd_set_te_pacing(true))
+            return false;
+    }
+    return lcd_framebuffer_init();
+}
+
+static bool pipeline_init(const host_options_t *opt)
+{
+    if (!display_init(opt))
+        return false;
+    init_capture_pio();
+    if (!lcd_framebuffer_init_auto_capture(LCD_CAPTURE_PIO, LCD_CAPTURE_SM))
+        return false;
+    if (!init_monitor_pio())
+        return false;
+    if (!lcd_framebuffer_start_auto_capture())
+        return false;
+    lcd_capture_frame_irq_enable(LCD_CAPTURE_PIO);
+    return true;
+}
+
+static uint64_t dirty_rows_total = 0;  // 送显帧的脏行累计
+
+// 与 lcd_converter.c 一致：异步提交，发送由DMA完成中断推进
+static void display_render_frame(host_lcd_t lcd)
+{
+    const lcd_dirty_rows_t *dirty = lcd_framebuffer_get_dirty_rows();
+    dirty_rows_total += lcd_framebuffer_count_dirty_rows(dirty);
+    panel_scan_end_frame();
+
+    if (lcd == HOST_LCD_ST75320)
+        lcd_submit_dirty_from_framebuffer(dirty);
+    else
+        spi_lcd_submit_dirty_from_framebuffer(dirty);
+}
+
+// 记录已完成帧的统计，返回能否取下一帧 (上一帧已经发完；ST7789按TE节拍时还要在本周期的开始窗口里)
+static bool display_output_poll(host_lcd_t lcd)
+{
+    return lcd == HOST_LCD_ST75320 ? lcd_poll() : spi_lcd_frame_slot();
+}
+
+static void display_output_wait(host_lcd_t lcd)
+{
+    if (lcd == HOST_LCD_ST75320)
+        lcd_wait();
+    else
+        spi_lcd_wait();
+}
+
+typedef struct {
+    uint32_t crc_checked;      // 校验过的新帧数
+    uint32_t crc_mismatches;   // 嗅探器CRC与软件CRC不一致的帧数
+    uint32_t crc_invalid;      // 中断来得太晚、嗅探器没有覆盖整帧的帧数
+    uint32_t full_resets;      // 快速重新同步失败后的捕获系统重启次数
+    uint32_t content_checked;  // 与合成源逐字节核对过的新帧数
+    uint32_t content_errors;   // 不等于任何最近发送的合成帧 (错位/撕裂) 的新帧数
+    uint32_t displayed;
+    uint64_t display_host_ns;  // 显示调用的真实CPU耗时
+    uint64_t display_sim_ns;   // 显示调用的模拟耗时 (含总线等待)
+    uint64_t sim_elapsed_ns;
+} pipeline_result_t;
+
+// 渲染帧必须等于最近发送的几帧之一 (消费者可能落后几帧，但不能拿到错位或拼接的帧)
+#define CONTENT_CHECK_HISTORY 4
+
+static void check_render_content(pipeline_result_t *result, const uint8_t *data, const synth_source_t *source)
+{
+    static uint8_t expected[FRAME_BYTES];
+    result->content_checked++;
+    for (uint32_t back = 0; back < CONTENT_CHECK_HISTORY && back <= source->last_index; back++)
+    {
+        synth_frame(source->last_index - back, expected);
+        if (memcmp(data, expected, FRAME_BYTES) == 0)
+            return;
+    }
+    result->content_errors++;
+}
+
+// 核对渲染帧的CRC (DMA嗅探器模型) 与软件CRC；source非NULL时再核对帧内容
+static void check_render_frame(pipeline_result_t *result, uint32_t *last_frame_id, const synth_source_t *source)
+{
+    lcd_framebuffer_t frame;
+    if (!lcd_framebuffer_get_render_frame(&frame) || frame.frame_id == *last_frame_id)
+        return;
+    *last_frame_id = frame.frame_id;
+    if (source != NULL)
+        check_render_content(result, frame.data, source);
+    if (!lcd_framebuffer_is_render_crc_valid())
+    {
+        result->crc_invalid++;
+        return;
+    }
+    result->crc_checked++;
+    if (lcd_framebuffer_get_render_crc() != lcd_framebuffer_crc32(frame.data, FRAME_BYTES))
+        result->crc_mismatches++;
+}
+
+static void pipeline_run(host_lcd_t lcd, pipeline_result_t *result, const synth_source_t *verify)
+{
+    memset(result, 0, sizeof(*result));
+    uint64_t sim_start = sim_now_ns();
+    uint32_t last_frame_id = 0;
+
+    while (sim_x3501_running() || lcd_framebuffer_get_frame_count() > result->displayed)
+    {
+        // 与 lcd_converter.c 的 display_frame_check 一致：快速重新同步连续失败才完整重启
+        if (lcd_framebuffer_capture_needs_reset())
+        {
+            lcd_framebuffer_reset_capture_system();
+            result->full_resets++;
+        }
+
+        bool changed = display_output_poll(lcd) && lcd_framebuffer_prepare_changed_frame();
+        check_render_frame(result, &last_frame_id, verify);
+        if (changed)
+        {
+            uint64_t t0 = host_ns();
+            uint64_t s0 = sim_now_ns();
+            display_render_frame(lcd);
+            result->display_host_ns += host_ns() - t0;
+            result->display_sim_ns += sim_now_ns() - s0;
+            result->displayed++;
+            continue;
+        }
+        // 信号源已结束 (之后不会再发布新帧)，也没有等待送显的帧：TE脉冲永远有下一个事件，不能等sim_idle
+        if (!sim_x3501_running() && !lcd_framebuffer_has_new_frame())
+            break;
+        // 没有新帧：直接跳到下一个模拟事件，而不是空转
+        if (lcd == HOST_LCD_ST7789 && spi_lcd_get_te_pacing())
+            te_poll_schedule();
+        if (!sim_idle())
+            break;
+    }
+    sim_cancel(te_poll_tick, NULL);
+    display_output_wait(lcd);
+
+    result->sim_elapsed_ns = sim_now_ns() - sim_start;
+}
+
+// 与 lcd_converter.c 的追帧送显一致：输出空闲就把正在捕获的帧里新落地的带直接送出
+static void beam_run(host_lcd_t lcd, pipeline_result_t *result)
+{
+    static lcd_dirty_rows_t band;
+    memset(result, 0, sizeof(*result));
+    uint64_t sim_start = sim_now_ns();
+    uint32_t shown_before;
+    lcd_framebuffer_get_dedup_stats(&shown_before, NULL);
+
+    while (true)
+    {
+        if (lcd_framebuffer_capture_needs_reset())
+        {
+            lcd_framebuffer_reset_capture_system();
+            result->full_resets++;
+        }
+
+        const uint8_t *data;
+        if (display_output_poll(lcd) && lcd_framebuffer_beam_next_band(&data, &band))
+        {
+            dirty_rows_total += lcd_framebuffer_count_dirty_rows(&band);
+            uint64_t t0 = host_ns();
+            uint64_t s0 = sim_now_ns();
+            if (lcd == HOST_LCD_ST75320)
+                lcd_submit_rows(data, &band);
+            else
+                spi_lcd_submit_rows(data, &band);
+            result->display_host_ns += host_ns() - t0;
+            result->display_sim_ns += sim_now_ns() - s0;
+            continue;
+        }
+        // 信号源已结束 (最后一帧在它停下之前就捕获完了)，最后的带也已经发完
+        if (!sim_x3501_running() && display_output_poll(lcd))
+            break;
+        if (!sim_idle())
+            break;
+    }
+    display_output_wait(lcd);
+
+    uint32_t shown;
+    lcd_framebuffer_get_dedup_stats(&shown, NULL);
+    result->displayed = shown - shown_before;
+    result->sim_elapsed_ns = sim_now_ns() - sim_start;
+}
+
+// =============================================================================
+// bench 子命令
+// =============================================================================
+static void print_spi_stats(const char *name, spi_inst_t *spi, uint32_t frames)
+{
+    sim_spi_stats_t s;
+    sim_spi_get_stats(spi, &s);
+    if (s.transactions == 0)
+        return;
+    uint32_t n = frames ? frames : 1;
+    printf("  %s: %llu 字节, %llu 次事务 (DMA %llu), 总线时间 %.3f ms\n", name,
+           (unsigned long long)s.bytes, (unsigned long long)s.transactions,
+           (unsigned long long)s.dma_transfers, s.bus_time_ns / 1e6);
+    printf("        每帧 %.1f 字节, %.1f 次事务, 总线 %.1f us\n",
+           (double)s.bytes / n, (double)s.transactions / n, s.bus_time_ns / 1e3 / n);
+}
+
+static void reset_bus_stats(void)
+{
+    sim_spi_reset_stats(spi0);
+    sim_spi_reset_stats(spi1);
+    sim_dma_reset_stats();
+}
+
+static void print_recovery_stats(void)
+{
+    lcd_capture_recovery_stats_t recovery;
+    lcd_framebuffer_get_recovery_stats(&recovery);
+    printf("  捕获恢复: 帧边沿对齐 %u, 等待下一帧 %u, 完整重启 %u, 恢复时间 最近 %u us / 最长 %u us\n",
+           recovery.edge_resyncs, recovery.wait_resyncs, recovery.full_resets, recovery.last_recovery_us,
+           recovery.max_recovery_us);
+}
+
+static void print_pipeline_result(const char *title, const host_options_t *opt, const pipeline_result_t *r)
+{
+    sim_dma_stats_t dma;
+    sim_dma_get_stats(&dma);
+    uint32_t n = r->displayed ? r->displayed : 1;
+
+    printf("\n========== %s ==========\n", title);
+    printf("显示器: %s, 时钟模式: %s\n", opt->lcd == HOST_LCD_ST75320 ? "ST75320" : "ST7789",
+           opt->time_mode == SIM_TIME_VIRTUAL ? "virtual" : "real");
+    printf("帧: 输入 %u, 显示 %u, 模拟时长 %.1f ms (%.1f FPS)\n",
+           lcd_framebuffer_get_frame_count(), r->displayed,
+           r->sim_elapsed_ns / 1e6, r->displayed * 1e9 / (r->sim_elapsed_ns ? r->sim_elapsed_ns : 1));
+    printf("显示调用: 主机CPU %.1f us/帧, 模拟 %.1f us/帧\n",
+           r->display_host_ns / 1e3 / n, r->display_sim_ns / 1e3 / n);
+    uint32_t shown, skipped;
+    lcd_framebuffer_get_dedup_stats(&shown, &skipped);
+    printf("帧去重: 送显 %u, CRC相同跳过 %u, 平均脏行 %.1f/240\n", shown, skipped,
+           (double)dirty_rows_total / n);
+    print_spi_stats("SPI0", spi0, r->displayed);
+    print_spi_stats("SPI1", spi1, r->displayed);
+    if (panel_scan.enabled)
+        printf("  ST7789面板扫描 (%.2f Hz): 撕裂 %u/%u 帧\n", 1e9 / ST7789_PANEL_PERIOD_NS, panel_scan.torn,
+               panel_scan.frames);
+    if (opt->lcd == HOST_LCD_ST7789 && spi_lcd_get_te_pacing())
+    {
+        spi_lcd_te_stats_t te;
+        spi_lcd_get_te_stats(&te);
+        printf("  TE节拍: 边沿 %u (周期 %u us), 送显 %u, 丢弃旧帧 %u, 迟到 %u, 开始窗口 %+d..%+d us, "
+               "开始发送 %+d..%+d us\n",
+               te.te_edges, te.period_us, te.frames, te.dropped, te.late, te.window_open_us, te.window_close_us,
+               te.min_start_us, te.max_start_us);
+    }
+    lcd_output_latency_stats_t latency;
+    lcd_framebuffer_get_latency_stats(&latency);
+    if (latency.frames > 0)
+        printf("  捕获到送显延迟 (帧捕获完 -> 最后的变化行发完): 平均 %.1f us, 最长 %u us (%u 帧)\n",
+               (double)latency.total_us / latency.frames, latency.max_us, latency.frames);
+    if (opt->beam)
+        printf("  追帧送显: %u 个带, 放弃 %u 帧\n", latency.bands, latency.overruns);
+    printf("  DMA: %llu 次传输, %llu 次总线事务, %llu 字节\n",
+           (unsigned long long)dma.transfers, (unsigned long long)dma.bus_transactions,
+           (unsigned long long)dma.bytes);
+}
+
+static int cmd_bench(const host_options_t *opt)
+{
+    if (opt->beam && opt->st7789_te)
+    {
+        printf("错误: --beam 与 --te 不能同时使用\n");
+        return 2;
+    }
+    sim_init(opt->time_mode);
+    if (!pipeline_init(opt))
+        return 1;
+
+    // 只统计稳态帧，不含初始化命令和清屏
+    reset_bus_stats();
+    sim_irq_set_latency_ns((uint64_t)opt->irq_latency_us * 1000);
+    // 追帧送显的带本来就在和扫描赛跑，不统计撕裂
+    if (opt->lcd == HOST_LCD_ST7789 && !opt->beam)
+        panel_scan_start(opt->color);
+
+    synth_source_t synth = {.limit = opt->frames, .fault_every = opt->fault_every};
+    sim_x3501_config_t source = {
+        .pio = LCD_CAPTURE_PIO,
+        .sm = LCD_CAPTURE_SM,
+        .frame_period_us = X3501_FRAME_PERIOD_US,
+        .active_us = X3501_ACTIVE_US,
+        .next_frame = synth_next_frame,
+        .fault = synth_fault,
+        .ctx = &synth,
+        .monitor_pio = LCD_MONITOR_PIO,
+        .line_sm = LCD_MONITOR_LINE_SM,
+        .clock_sm = LCD_MONITOR_CLOCK_SM,
+    };
+    sim_x3501_start(&source);
+
+    pipeline_result_t r;
+    if (opt->beam)
+        beam_run(opt->lcd, &r);
+    else
+        pipeline_run(opt->lcd, &r, NULL);
+    if (panel_scan.enabled)
+        panel_scan_stop();
+
+    print_pipeline_result("lcd_host bench", opt, &r);
+    printf("  X3501发送 %u 帧, PIO RX溢出: %llu\n", sim_x3501_frames_sent(),
+           (unsigned long long)sim_pio_rx_overflows(LCD_CAPTURE_PIO, LCD_CAPTURE_SM));
+    printf("  嗅探器CRC校验: %u 帧, 不一致 %u, 中断过晚CRC无效 %u\n", r.crc_checked, r.crc_mismatches,
+           r.crc_invalid);
+    lcd_frame_integrity_stats_t integrity;
+    lcd_framebuffer_get_integrity_stats(&integrity);
+    printf("  帧完整性: 有效 %u, 短帧 %u, 长帧 %u, 丢弃 %u\n", integrity.valid,
+           integrity.short_frames, integrity.long_frames, integrity.dropped);
+    print_recovery_stats();
+    return 0;
+}
+
+// =============================================================================
+// faults 子命令：注入信号故障，检查每个坏帧都被检出、快速重新同步的恢复时间不超过一个帧周期、
+// 显示的每一帧都与合成源一致 (纯模拟时钟，结果可重复)
+// =============================================================================
+#define FAULTS_DEFAULT_FRAMES 300
+#define FAULTS_DEFAULT_EVERY 7
+
+static int cmd_faults(const host_options_t *opt)
+{
+    sim_init(SIM_TIME_VIRTUAL);
+    if (!pipeline_init(opt))
+        return 1;
+    sim_irq_set_latency_ns((uint64_t)opt->irq_latency_us * 1000);
+
+    synth_source_t synth = {
+        .limit = opt->frames_set ? opt->frames : FAULTS_DEFAULT_FRAMES,
+        .fault_every = opt->fault_every ? opt->fault_every : FAULTS_DEFAULT_EVERY,
+    };
+    sim_x3501_config_t source = {
+        .pio = LCD_CAPTURE_PIO,
+        .sm = LCD_CAPTURE_SM,
+        .frame_period_us = X3501_FRAME_PERIOD_US,
+        .active_us = X3501_ACTIVE_US,
+        .next_frame = synth_next_frame,
+        .fault = synth_fault,
+        .ctx = &synth,
+        .monitor_pio = LCD_MONITOR_PIO,
+        .line_sm = LCD_MONITOR_LINE_SM,
+        .clock_sm = LCD_MONITOR_CLOCK_SM,
+    };
+    sim_x3501_start(&source);
+
+    pipeline_result_t r;
+    pipeline_run(opt->lcd, &r, &synth);
+
+    lcd_frame_integrity_stats_t integrity;
+    lcd_framebuffer_get_integrity_stats(&integrity);
+    lcd_capture_recovery_stats_t recovery;
+    lcd_framebuffer_get_recovery_stats(&recovery);
+    uint32_t detected = integrity.short_frames + integrity.long_frames;
+    uint32_t recoveries = recovery.edge_resyncs + recovery.wait_resyncs + recovery.full_resets;
+
+    printf("\n========== lcd_host faults ==========\n");
+    printf("X3501发送 %u 帧, 注入故障 %u, 检出 %u (短帧 %u, 长帧 %u), 有效 %u\n", sim_x3501_frames_sent(),
+           synth.injected, detected, integrity.short_frames, integrity.long_frames, integrity.valid);
+    print_recovery_stats();
+    printf("  显示帧内容核对: %u 帧, 错误 %u; 嗅探器CRC不一致 %u\n", r.content_checked, r.content_errors,
+           r.crc_mismatches);
+
+    bool ok = true;
+    if (detected != synth.injected)
+    {
+        printf("❌ 检出的坏帧数与注入的故障数不一致\n");
+        ok = false;
+    }
+    if (recoveries < detected || recovery.full_resets != 0)
+    {
+        printf("❌ 坏帧没有全部走快速重新同步\n");
+        ok = false;
+    }
+    // 帧边沿对齐几乎立即恢复；等待下一帧的路径从发现坏帧的FRAME中断到下一个FRAME边沿，最多一个帧周期
+    if (recovery.max_recovery_us > X3501_FRAME_PERIOD_US)
+    {
+        printf("❌ 最长恢复时间 %u us 超过一个帧周期 (%u us)\n", recovery.max_recovery_us, X3501_FRAME_PERIOD_US);
+        ok = false;
+    }
+    if (r.content_errors != 0 || r.crc_mismatches != 0 || r.content_checked == 0)
+    {
+        printf("❌ 显示了错位或损坏的帧\n");
+        ok = false;
+    }
+    if (ok)
+        printf("✅ 全部坏帧被检出，恢复时间不超过一个帧周期，显示帧无错位\n");
+    return ok ? 0 : 1;
+}
+
+// =============================================================================
+// verify 子命令：ST7789两个输出引擎 (CPU查表 / pio1展开) 与逐像素参考公式逐字节比较
+// 线上数据由spi0的sink在DC为高时收集，PIO引擎的数据由引脚波形解码得到 (纯模拟时钟)
+// =============================================================================
+#define VERIFY_PIN_DC 16 // 与 display_init 一致
+
+typedef struct {
+    uint8_t *data;
+    size_t len;
+    size_t cap;
+} wire_capture_t;
+
+static void wire_capture_sink(void *ctx, const void *data, size_t frames, uint data_bits)
+{
+    wire_capture_t *cap = (wire_capture_t *)ctx;
+    if (!gpio_get(VERIFY_PIN_DC))
+        return; // 只收集像素数据，不收集命令
+    for (size_t i = 0; i < frames; i++)
+    {
+        // 16位帧MSB先上线
+        uint8_t bytes[2];
+        size_t n = 1;
+        if (data_bits == 16)
+        {
+            uint16_t v = ((const uint16_t *)data)[i];
+            bytes[0] = (uint8_t)(v >> 8);
+            bytes[1] = (uint8_t)v;
+            n = 2;
+        }
+        else
+        {
+            bytes[0] = ((const uint8_t *)data)[i];
+        }
+        for (size_t b = 0; b < n && cap->len < cap->cap; b++)
+            cap->data[cap->len++] = bytes[b];
+    }
+}
+
+static uint32_t verify_wire_color(lcd_color_format_t format, uint16_t color)
+{
+    if (format == LCD_COLOR_RGB444)
+        return ((color >> 12) << 8) | (((color >> 7) & 0xF) << 4) | ((color >> 1) & 0xF);
+    return color;
+}
+
+// 参考模型：每个像素位直接选颜色，按位串接 (MSB先)
+static size_t verify_reference(const uint8_t *fb, lcd_color_format_t format, uint16_t fg, uint16_t bg,
+                               uint8_t *out)
+{
+    uint32_t bits = format == LCD_COLOR_RGB444 ? 12 : 16;
+    uint32_t fg_wire = verify_wire_color(format, fg);
+    uint32_t bg_wire = verify_wire_color(format, bg);
+    size_t len = 0;
+    uint32_t acc = 0;
+    uint32_t acc_bits = 0;
+    for (int y = 0; y < LCD_FB_HEIGHT; y++)
+    {
+        for (int x = 0; x < LCD_FB_WIDTH; x++)
+        {
+            bool on = (fb[y * ROW_BYTES + x / 8] >> (x % 8)) & 1u;
+            acc = (acc << bits) | (on ? fg_wire : bg_wire);
+            acc_bits += bits;
+            while (acc_bits >= 8)
+            {
+                acc_bits -= 8;
+                out[len++] = (uint8_t)(acc >> acc_bits);
+            }
+        }
+    }
+    return len;
+}
+
+// 用指定引擎整帧送显一次，返回收集到的像素字节数 (引擎不可用时为0)
+static size_t verify_engine(lcd_output_engine_t engine, wire_capture_t *cap, uint64_t *bus_ns)
+{
+    if (!spi_lcd_set_output_engine(engine))
+        return 0;
+    sim_spi_stats_t before, after;
+    sim_spi_get_stats(spi0, &before);
+    cap->len = 0;
+    spi_lcd_update_from_framebuffer();
+    sim_spi_get_stats(spi0, &after);
+    *bus_ns += after.bus_time_ns - before.bus_time_ns;
+    return cap->len;
+}
+
+// ST7789 GRAM模型：由spi0的sink按DC电平解析 2A(CASET) / 2B(RASET) / 2C(RAMWR)，
+// 像素按COLMOD宽度 (16/12位) 依次写进窗口：写完一行回到窗口左边界，写完窗口回到左上角
+typedef struct {
+    uint16_t gram[LCD_FB_HEIGHT][LCD_FB_WIDTH];
+    uint32_t pixel_bits;
+    uint8_t cmd;
+    uint32_t arg;
+    uint16_t xs, xe, ys, ye; // 窗口
+    uint16_t x, y;           // 写入地址
+    uint32_t acc, acc_bits;
+    uint32_t bytes;    // 线上字节数 (命令 + 参数 + 像素)
+    uint32_t odd, odd_bits; // 12位帧里还没凑成一个字节的线上位
+    uint32_t windows;  // RAMWR次数
+    uint32_t outside;  // 落在GRAM范围之外的像素数
+} st7789_model_t;
+
+// RAMWR：把线上的位串接进累加器，凑够一个像素就写进窗口
+static void st7789_model_pixel_bits(st7789_model_t *m, uint32_t v, uint32_t bits)
+{
+    m->acc = (m->acc << bits) | v;
+    m->acc_bits += bits;
+    while (m->acc_bits >= m->pixel_bits)
+    {
+        m->acc_bits -= m->pixel_bits;
+        uint16_t pixel = (uint16_t)((m->acc >> m->acc_bits) & ((1u << m->pixel_bits) - 1));
+        if (m->x < LCD_FB_WIDTH && m->y < LCD_FB_HEIGHT)
+            m->gram[m->y][m->x] = pixel;
+        else
+            m->outside++;
+        if (++m->x > m->xe)
+        {
+            m->x = m->xs;
+            if (++m->y > m->ye)
+                m->y = m->ys;
+        }
+    }
+}
+
+static void st7789_model_byte(st7789_model_t *m, uint8_t b)
+{
+    m->bytes++;
+    if (!gpio_get(VERIFY_PIN_DC))
+    {
+        m->cmd = b;
+        m->arg = 0;
+        if (b == 0x2C)
+        {
+            m->x = m->xs;
+            m->y = m->ys;
+            m->acc = 0;
+            m->acc_bits = 0;
+            m->windows++;
+        }
+        return;
+    }
+    switch (m->cmd)
+    {
+    case 0x2A:
+    case 0x2B:
+    {
+        uint16_t *v = (m->arg < 2) ? (m->cmd == 0x2A ? &m->xs : &m->ys) : (m->cmd == 0x2A ? &m->xe : &m->ye);
+        *v = (m->arg & 1) ? (uint16_t)((*v & 0xFF00) | b) : (uint16_t)(b << 8);
+        break;
+    }
+    case 0x2C:
+        st7789_model_pixel_bits(m, b, 8);
+        break;
+    default:
+        break;
+    }
+    m->arg++;
+}
+
+static void st7789_model_sink(void *ctx, const void *data, size_t frames, uint data_bits)
+{
+    st7789_model_t *m = (st7789_model_t *)ctx;
+    for (size_t i = 0; i < frames; i++)
+    {
+        // 控制器按字节锁存串行数据：驱动换回8/16位帧之前已经拉高CS，没凑满一个字节的位被丢掉
+        if (data_bits == 8 || data_bits == 16)
+            m->odd_bits = 0;
+        // 16位帧MSB先上线
+        if (data_bits == 16)
+        {
+            uint16_t v = ((const uint16_t *)data)[i];
+            st7789_model_byte(m, (uint8_t)(v >> 8));
+            st7789_model_byte(m, (uint8_t)v);
+        }
+        else if (data_bits == 8)
+        {
+            st7789_model_byte(m, ((const uint8_t *)data)[i]);
+        }
+        else
+        {
+            // 其他帧宽 (RGB444纯色填充的12位帧)：位串接起来，每凑满一个字节交给控制器
+            uint16_t v = ((const uint16_t *)data)[i];
+            m->odd = (m->odd << data_bits) | (v & ((1u << data_bits) - 1));
+            m->odd_bits += data_bits;
+            while (m->odd_bits >= 8)
+            {
+                m->odd_bits -= 8;
+                st7789_model_byte(m, (uint8_t)(m->odd >> m->odd_bits));
+            }
+        }
+    }
+}
+
+// GRAM与帧fb的参考像素不一致的像素数
+static uint32_t st7789_model_mismatches(const st7789_model_t *m, const uint8_t *fb, lcd_color_format_t format,
+                                        uint16_t fg, uint16_t bg)
+{
+    uint32_t fg_wire = verify_wire_color(format, fg);
+    uint32_t bg_wire = verify_wire_color(format, bg);
+    uint32_t mismatches = 0;
+    for (int y = 0; y < LCD_FB_HEIGHT; y++)
+    {
+        for (int x = 0; x < LCD_FB_WIDTH; x++)
+        {
+            bool on = (fb[y * ROW_BYTES + x / 8] >> (x % 8)) & 1u;
+            if (m->gram[y][x] != (on ? fg_wire : bg_wire))
+                mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+// 局部刷新：整帧 -> 一块读数 (16行) -> 零散的行 -> 隔行 -> 全部行，每次只送与上一帧不同的行，
+// 每一步之后GRAM必须等于当前帧；两个输出引擎各做一遍。wire_bytes记录读数那一步的线上字节数
+#define ST7789_PARTIAL_STEPS 5
+
+static uint32_t verify_st7789_partial(lcd_color_format_t format, uint32_t *checked, uint32_t wire_bytes[2],
+                                      uint32_t *full_bytes)
+{
+    static const uint16_t fg = 0xF81F, bg = 0x07E0;
+    static const char *step_names[ST7789_PARTIAL_STEPS] = {"整帧", "读数", "零散行", "隔行", "全部行"};
+    static const lcd_output_engine_t engines[2] = {LCD_OUTPUT_SPI_LUT, LCD_OUTPUT_PIO_EXPAND};
+    static st7789_model_t model;
+    static uint8_t frames[ST7789_PARTIAL_STEPS][FRAME_BYTES];
+    uint32_t failures = 0;
+
+    synth_frame(0, frames[0]);
+    memcpy(frames[1], frames[0], FRAME_BYTES);
+    for (uint32_t y = 100; y < 116; y++)
+        memset(&frames[1][y * ROW_BYTES + 4], (uint8_t)(y * 37), 12);
+    memcpy(frames[2], frames[1], FRAME_BYTES);
+    static const uint16_t scattered[] = {3, 5, 7, 40, 41, 42, 43, 120, 121, 200, 239};
+    for (size_t i = 0; i < sizeof(scattered) / sizeof(scattered[0]); i++)
+        frames[2][scattered[i] * ROW_BYTES + 9] ^= 0x5A;
+    memcpy(frames[3], frames[2], FRAME_BYTES);
+    for (uint32_t y = 0; y < LCD_FB_HEIGHT; y += 2)
+        frames[3][y * ROW_BYTES + 20] ^= 0xFF;
+    for (size_t i = 0; i < FRAME_BYTES; i++)
+        frames[4][i] = (uint8_t)~frames[3][i];
+
+    spi_lcd_set_colors(fg, bg);
+    for (int e = 0; e < 2; e++)
+    {
+        if (!spi_lcd_set_output_engine(engines[e]))
+            continue;
+        memset(&model, 0, sizeof(model));
+        model.pixel_bits = format == LCD_COLOR_RGB444 ? 12 : 16;
+        sim_spi_set_sink(spi0, st7789_model_sink, &model);
+        // 模型从连续传输窗口开始
+        spi_lcd_set_continuous_window(0, 0, LCD_FB_WIDTH - 1, LCD_FB_HEIGHT - 1);
+
+        for (uint32_t step = 0; step < ST7789_PARTIAL_STEPS; step++)
+        {
+            lcd_framebuffer_submit_frame(frames[step], 100 + e * ST7789_PARTIAL_STEPS + step, 0, 0);
+            if (!lcd_framebuffer_prepare_display_frame())
+            {
+                printf("❌ 局部刷新%s: 测试帧没有进入渲染缓冲区\n", step_names[step]);
+                failures++;
+                continue;
+            }
+            lcd_dirty_rows_t dirty;
+            memset(&dirty, 0, sizeof(dirty));
+            for (uint32_t y = 0; step > 0 && y < LCD_FB_HEIGHT; y++)
+            {
+                if (memcmp(&frames[step][y * ROW_BYTES], &frames[step - 1][y * ROW_BYTES], ROW_BYTES) != 0)
+                    lcd_dirty_row_set(&dirty, y);
+            }
+
+            // 异步提交：发送期间渲染缓冲区被占用，下一帧不能换进来；发完后释放
+            model.bytes = 0;
+            spi_lcd_submit_dirty_from_framebuffer(step == 0 ? NULL : &dirty);
+            if (spi_lcd_is_busy() && !lcd_framebuffer_is_render_held())
+            {
+                failures++;
+                printf("❌ 局部刷新%s: 发送期间渲染缓冲区没有被占用\n", step_names[step]);
+            }
+            if (step + 1 < ST7789_PARTIAL_STEPS && spi_lcd_is_busy() &&
+                lcd_framebuffer_submit_frame(frames[step + 1], 0, 0, 0) && lcd_framebuffer_prepare_display_frame())
+            {
+                failures++;
+                printf("❌ 局部刷新%s: 发送期间渲染缓冲区被换掉\n", step_names[step]);
+            }
+            spi_lcd_wait();
+            if (lcd_framebuffer_is_render_held())
+            {
+                failures++;
+                printf("❌ 局部刷新%s: 发送完成后渲染缓冲区仍被占用\n", step_names[step]);
+                lcd_framebuffer_release_render();
+            }
+            if (step == 0)
+                *full_bytes = model.bytes;
+            if (step == 1)
+                wire_bytes[e] = model.bytes;
+
+            (*checked)++;
+            uint32_t mismatches =
+                st7789_model_mismatches(&model, lcd_framebuffer_get_render_data(), format, fg, bg);
+            if (mismatches != 0 || model.outside != 0)
+            {
+                failures++;
+                printf("❌ 局部刷新%s (%s): GRAM有 %u 个像素与当前帧不一致 (越界 %u)\n", step_names[step],
+                       engines[e] == LCD_OUTPUT_SPI_LUT ? "LUT" : "PIO展开", mismatches, model.outside);
+            }
+        }
+    }
+    sim_spi_set_sink(spi0, NULL, NULL);
+    spi_lcd_set_output_engine(LCD_OUTPUT_SPI_LUT);
+    return failures;
+}
+
+// 纯色填充：整屏清屏 + 几个矩形 (含超出屏幕被裁掉的、空的)，两个输出引擎各做一遍，
+// 每次填完GRAM必须等于参考图；fill_bus_ns记录整屏清屏的总线时间
+static uint32_t verify_st7789_fill(lcd_color_format_t format, uint32_t *checked, uint64_t *fill_bus_ns)
+{
+    typedef struct {
+        uint16_t x, y, w, h, color;
+    } fill_case_t;
+    static const fill_case_t cases[] = {
+        {0, 0, LCD_FB_WIDTH, LCD_FB_HEIGHT, 0x1234}, // 清屏
+        {10, 20, 50, 30, 0xF800},
+        {200, 230, 100, 100, 0x07E0}, // 右下角裁剪
+        {0, 119, LCD_FB_WIDTH, 1, 0x001F},
+        {239, 0, 1, LCD_FB_HEIGHT, 0xFFFF},
+        {37, 41, 1, 1, 0xA5A5},
+        {100, 150, 3, 5, 0x0F0F}, // 奇数个像素：RGB444的最后一个像素不能停在半个字节上
+        {50, 50, 0, 10, 0x0000},           // 空矩形
+        {LCD_FB_WIDTH, 0, 10, 10, 0x0000}, // 完全在屏幕外
+    };
+    static const lcd_output_engine_t engines[2] = {LCD_OUTPUT_SPI_LUT, LCD_OUTPUT_PIO_EXPAND};
+    static st7789_model_t model;
+    static uint16_t expected[LCD_FB_HEIGHT][LCD_FB_WIDTH];
+    uint32_t failures = 0;
+
+    for (int e = 0; e < 2; e++)
+    {
+        if (!spi_lcd_set_output_engine(engines[e]))
+            continue;
+        memset(&model, 0, sizeof(model));
+        model.pixel_bits = format == LCD_COLOR_RGB444 ? 12 : 16;
+        sim_spi_set_sink(spi0, st7789_model_sink, &model);
+        // 驱动缓存了CASET/RASET，模型从连续传输窗口开始
+        spi_lcd_set_continuous_window(0, 0, LCD_FB_WIDTH - 1, LCD_FB_HEIGHT - 1);
+        memset(expected, 0, sizeof(expected));
+
+        for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+        {
+            const fill_case_t *c = &cases[i];
+            bool empty = c->w == 0 || c->h == 0 || c->x >= LCD_FB_WIDTH || c->y >= LCD_FB_HEIGHT;
+            sim_spi_stats_t before, after;
+            sim_spi_get_stats(spi0, &before);
+            uint32_t windows = model.windows;
+            bool started = spi_lcd_fill_rect(c->x, c->y, c->w, c->h, c->color);
+            spi_lcd_wait();
+            sim_spi_get_stats(spi0, &after);
+            if (e == 0 && i == 0)
+                *fill_bus_ns = after.bus_time_ns - before.bus_time_ns;
+
+            (*checked)++;
+            if (started == empty || model.windows - windows != (empty ? 0u : 1u))
+            {
+                failures++;
+                printf("❌ 填充 (%u,%u %ux%u): 返回 %d, 打开 %u 个窗口\n", c->x, c->y, c->w, c->h, started,
+                       model.windows - windows);
+            }
+            if (lcd_framebuffer_is_render_held())
+            {
+                failures++;
+                printf("❌ 填充 (%u,%u %ux%u): 占用了渲染缓冲区\n", c->x, c->y, c->w, c->h);
+                lcd_framebuffer_release_render();
+            }
+            for (uint32_t y = c->y; !empty && y < LCD_FB_HEIGHT && y < (uint32_t)c->y + c->h; y++)
+            {
+                for (uint32_t x = c->x; x < LCD_FB_WIDTH && x < (uint32_t)c->x + c->w; x++)
+                    expected[y][x] = (uint16_t)verify_wire_color(format, c->color);
+            }
+            uint32_t mismatches = 0;
+            for (int y = 0; y < LCD_FB_HEIGHT; y++)
+            {
+                for (int x = 0; x < LCD_FB_WIDTH; x++)
+                    mismatches += model.gram[y][x] != expected[y][x];
+            }
+            if (mismatches != 0 || model.outside != 0)
+            {
+                failures++;
+                printf("❌ 填充 (%u,%u %ux%u, %s): GRAM有 %u 个像素与参考不一致 (越界 %u)\n", c->x, c->y, c->w,
+                       c->h, engines[e] == LCD_OUTPUT_SPI_LUT ? "LUT" : "PIO展开", mismatches, model.outside);
+            }
+        }
+    }
+    sim_spi_set_sink(spi0, NULL, NULL);
+    spi_lcd_set_output_engine(LCD_OUTPUT_SPI_LUT);
+    return failures;
+}
+
+// ST75320显示RAM模型：由spi1的sink按A0电平解析 B1(页) / 13(列) / 1D(写数据) 命令
+// 写数据时列地址自动加1 (初始化设置的0x84列方向)，写完第319列进入下一页第0列；
+// 同时记录镜像命令 A0/A1 (列地址反向/正向)、C8/C0 (行扫描反向/正向)，比较的是屏上看到的图像
+#define VERIFY_PIN_A0 10 // 与 lcd_st75320.c 一致
+#define ST75320_RAM_PAGES 30
+#define ST75320_RAM_COLS 320
+
+typedef struct {
+    uint8_t ram[ST75320_RAM_PAGES][ST75320_RAM_COLS];
+    uint8_t cmd;
+    uint32_t arg;
+    uint32_t page;
+    uint32_t col;
+    uint32_t overflows; // 写到RAM范围之外的字节数
+    bool col_reverse;   // RAM第c列显示在第319-c列
+    bool row_reverse;   // RAM第r行显示在第239-r行
+} st75320_model_t;
+
+static void st75320_model_reset(st75320_model_t *m)
+{
+    memset(m, 0xA5, sizeof(*m));
+    m->cmd = 0;
+    m->overflows = 0;
+    m->col_reverse = false;
+    m->row_reverse = false;
+}
+
+// 屏上看到的图像 (按页格式：panel[P][C] 的bit r = 屏幕第8P+r行)
+static void st75320_model_panel(const st75320_model_t *m, uint8_t panel[ST75320_RAM_PAGES][ST75320_RAM_COLS])
+{
+    for (int page = 0; page < ST75320_RAM_PAGES; page++)
+    {
+        for (int col = 0; col < ST75320_RAM_COLS; col++)
+        {
+            int ram_page = m->row_reverse ? ST75320_RAM_PAGES - 1 - page : page;
+            int ram_col = m->col_reverse ? ST75320_RAM_COLS - 1 - col : col;
+            uint8_t b = m->ram[ram_page][ram_col];
+            if (m->row_reverse)
+            {
+                uint8_t r = 0;
+                for (int bit = 0; bit < 8; bit++)
+                    r |= ((b >> bit) & 1) << (7 - bit);
+                b = r;
+            }
+            panel[page][col] = b;
+        }
+    }
+}
+
+static void st75320_model_sink(void *ctx, const void *data, size_t frames, uint data_bits)
+{
+    st75320_model_t *m = (st75320_model_t *)ctx;
+    (void)data_bits;
+    bool is_data = gpio_get(VERIFY_PIN_A0);
+    for (size_t i = 0; i < frames; i++)
+    {
+        uint8_t b = ((const uint8_t *)data)[i];
+        if (!is_data)
+        {
+            m->cmd = b;
+            m->arg = 0;
+            if (b == 0xA0 || b == 0xA1)
+                m->col_reverse = (b == 0xA0);
+            else if (b == 0xC0 || b == 0xC8)
+                m->row_reverse = (b == 0xC8);
+            continue;
+        }
+        switch (m->cmd)
+        {
+        case 0xB1:
+            m->page = b;
+            break;
+        case 0x13:
+            m->col = m->arg == 0 ? (uint32_t)(b & 1) << 8 : (m->col & 0x100) | b;
+            break;
+        case 0x1D:
+            if (m->page < ST75320_RAM_PAGES && m->col < ST75320_RAM_COLS)
+                m->ram[m->page][m->col++] = b;
+            else
+                m->overflows++;
+            if (m->col == ST75320_RAM_COLS)
+            {
+                m->col = 0;
+                m->page++;
+            }
+            break;
+        default:
+            break;
+        }
+        m->arg++;
+    }
+}
+
+// 一组刷新 (旋转 -> 整屏 -> 局部) 分别用 转置内核+PIO链路 / 转置内核+SPI (连续页只寻址一次) /
+// 转置内核纯软件旋转+SPI / 逐位内核纯软件旋转+SPI逐页寻址 送显，屏上的图像必须一致
+// (逐位内核+纯软件旋转+SPI逐页寻址是原来的路径，作为参考；前两条借助硬件镜像)
+#define ST75320_VERIFY_PATHS 4
+
+static uint32_t verify_st75320(uint64_t bus_ns[ST75320_VERIFY_PATHS], uint32_t *checked)
+{
+    static const struct {
+        bool link;
+        bool contiguous;
+        bool hardware_mirroring;
+        lcd_convert_kernel_t kernel;
+        const char *name;
+    } paths[ST75320_VERIFY_PATHS] = {
+        {true, true, true, LCD_CONVERT_TRANSPOSE, "转置+硬件镜像+PIO链路"},
+        {false, true, true, LCD_CONVERT_TRANSPOSE, "转置+硬件镜像+SPI"},
+        {false, true, false, LCD_CONVERT_TRANSPOSE, "转置+纯软件旋转+SPI"},
+        {false, false, false, LCD_CONVERT_BITWISE, "逐位+纯软件旋转+SPI逐页寻址"},
+    };
+    static st75320_model_t models[ST75320_VERIFY_PATHS];
+    static uint8_t panels[ST75320_VERIFY_PATHS][ST75320_RAM_PAGES][ST75320_RAM_COLS];
+    static uint8_t frame_a[FRAME_BYTES], frame_b[FRAME_BYTES];
+    uint32_t failures = 0;
+
+    lcd_init();
+    if (!lcd_set_pio_link(true))
+    {
+        printf("❌ ST75320: PIO显示链路无法启用\n");
+        return 1;
+    }
+
+    lcd_dirty_rows_t dirty;
+    memset(&dirty, 0, sizeof(dirty));
+    for (uint32_t y = 37; y < 53; y++)
+        lcd_dirty_row_set(&dirty, y);
+    lcd_dirty_row_set(&dirty, 200);
+
+    srand(2);
+    for (uint32_t pattern = 0; pattern < 3; pattern++)
+    {
+        for (uint32_t rotation = LCD_ROTATION_0; rotation <= LCD_ROTATION_270; rotation++)
+        {
+            if (pattern == 0)
+            {
+                for (size_t i = 0; i < sizeof(frame_a); i++)
+                    frame_a[i] = (uint8_t)rand();
+            }
+            else if (pattern == 1)
+            {
+                synth_frame(rotation * 6, frame_a);
+            }
+            else
+            {
+                memset(frame_a, 0xFF, sizeof(frame_a));
+            }
+            memcpy(frame_b, frame_a, sizeof(frame_b));
+            for (uint32_t y = 0; y < LCD_FB_HEIGHT; y++)
+            {
+                if (lcd_dirty_row_test(&dirty, y))
+                    memset(&frame_b[y * ROW_BYTES], (uint8_t)(y * 7), ROW_BYTES);
+            }
+
+            for (int p = 0; p < ST75320_VERIFY_PATHS; p++)
+            {
+                st75320_model_t *model = &models[p];
+                st75320_model_reset(model);
+                lcd_set_pio_link(paths[p].link);
+                lcd_set_convert_kernel(paths[p].kernel);
+                lcd_set_contiguous_refresh(paths[p].contiguous);
+                sim_spi_set_sink(spi1, st75320_model_sink, model);
+
+                sim_spi_stats_t before, after;
+                sim_spi_get_stats(spi1, &before);
+                lcd_set_hardware_mirroring(paths[p].hardware_mirroring);
+                lcd_set_rotation((lcd_rotation_t)rotation);
+                lcd_update_from_1bit_framebuffer(frame_a);
+                lcd_update_dirty_from_1bit_framebuffer(frame_b, &dirty);
+                lcd_wait(); // 源帧读完就返回，等最后几页发完RAM模型才完整
+                lcd_set_pio_link(false);
+                sim_spi_get_stats(spi1, &after);
+                bus_ns[p] += after.bus_time_ns - before.bus_time_ns;
+                st75320_model_panel(model, panels[p]);
+            }
+            sim_spi_set_sink(spi1, NULL, NULL);
+
+            (*checked)++;
+            const uint8_t(*ref)[ST75320_RAM_COLS] = panels[ST75320_VERIFY_PATHS - 1];
+            for (int p = 0; p < ST75320_VERIFY_PATHS; p++)
+            {
+                if (memcmp(panels[p], ref, sizeof(panels[p])) == 0 && models[p].overflows == 0)
+                    continue;
+                failures++;
+                printf("❌ ST75320 图案%u 旋转%u度: %s显示的图像与%s不一致 (越界 %u 字节)\n", pattern,
+                       rotation * 90, paths[p].name, paths[ST75320_VERIFY_PATHS - 1].name, models[p].overflows);
+            }
+        }
+    }
+    lcd_set_convert_kernel(LCD_CONVERT_TRANSPOSE);
+    lcd_set_contiguous_refresh(true);
+    lcd_set_hardware_mirroring(true);
+    return failures;
+}
+
+// 录制帧：每个旋转角度下按录制顺序送显 (首帧整屏，之后只送与上一帧不同的行)，
+// 转置内核 (硬件镜像，连续页只寻址一次) 和逐位内核 (纯软件旋转，逐页寻址) 每帧之后屏上的图像必须一致
+// (只走SPI，PIO链路由上面的测试覆盖)。转置内核一路经 lcd_framebuffer 的渲染缓冲区异步提交，
+// 发完之后渲染缓冲区必须已经释放
+static uint64_t st75320_panel_hash(const st75320_model_t *m)
+{
+    static uint8_t panel[ST75320_RAM_PAGES][ST75320_RAM_COLS];
+    st75320_model_panel(m, panel);
+    uint64_t h = 1469598103934665603ull; // FNV-1a
+    const uint8_t *p = &panel[0][0];
+    for (size_t i = 0; i < sizeof(panel); i++)
+        h = (h ^ p[i]) * 1099511628211ull;
+    return h;
+}
+
+static uint32_t verify_st75320_recording(const char *path, uint32_t limit, uint32_t *checked)
+{
+    capture_reader_t reader;
+    if (!capture_reader_open(&reader, path))
+        return 1;
+    uint32_t total = reader.count;
+    if (limit != 0 && limit < total)
+        total = limit;
+
+    static st75320_model_t model;
+    uint64_t *hashes[2] = {malloc(total * sizeof(uint64_t)), malloc(total * sizeof(uint64_t))};
+    static const lcd_convert_kernel_t kernels[2] = {LCD_CONVERT_TRANSPOSE, LCD_CONVERT_BITWISE};
+    uint32_t failures = 0;
+
+    lcd_set_pio_link(false);
+    for (uint32_t rotation = LCD_ROTATION_0; rotation <= LCD_ROTATION_270; rotation++)
+    {
+        for (int k = 0; k < 2; k++)
+        {
+            st75320_model_reset(&model);
+            lcd_set_convert_kernel(kernels[k]);
+            lcd_set_contiguous_refresh(k == 0);
+            sim_spi_set_sink(spi1, st75320_model_sink, &model);
+            lcd_set_hardware_mirroring(k == 0);
+            lcd_set_rotation((lcd_rotation_t)rotation);
+            for (uint32_t i = 0; i < total; i++)
+            {
+                const uint8_t *data = capture_reader_record(&reader, i)->data;
+                lcd_dirty_rows_t dirty;
+                memset(&dirty, 0, sizeof(dirty));
+                if (i > 0)
+                {
+                    const uint8_t *prev = capture_reader_record(&reader, i - 1)->data;
+                    for (uint32_t y = 0; y < LCD_FB_HEIGHT; y++)
+                    {
+                        if (memcmp(&data[y * ROW_BYTES], &prev[y * ROW_BYTES], ROW_BYTES) != 0)
+                            lcd_dirty_row_set(&dirty, y);
+                    }
+                }
+
+                if (k == 0)
+                {
+                    lcd_framebuffer_submit_frame(data, i + 1, 0, 0);
+                    if (!lcd_framebuffer_prepare_display_frame() ||
+                        !lcd_submit_dirty_from_framebuffer(i == 0 ? NULL : &dirty))
+                    {
+                        failures++;
+                        printf("❌ 录制帧 %u: 异步提交失败\n", i);
+                    }
+                }
+                else
+                {
+                    lcd_update_dirty_from_1bit_framebuffer(data, i == 0 ? NULL : &dirty);
+                }
+                lcd_wait();
+                if (lcd_framebuffer_is_render_held())
+                {
+                    failures++;
+                    printf("❌ 录制帧 %u: 刷新完成后渲染缓冲区仍被占用\n", i);
+                    lcd_framebuffer_release_render();
+                }
+                hashes[k][i] = model.overflows != 0 ? 0 : st75320_panel_hash(&model);
+            }
+            sim_spi_set_sink(spi1, NULL, NULL);
+        }
+
+        for (uint32_t i = 0; i < total; i++)
+        {
+            (*checked)++;
+            if (hashes[0][i] != hashes[1][i] || hashes[0][i] == 0)
+            {
+                failures++;
+                printf("❌ 录制帧 %u 旋转%u度: 转置内核+硬件镜像与逐位内核+纯软件旋转显示的图像不一致\n", i,
+                       rotation * 90);
+            }
+        }
+    }
+    lcd_set_convert_kernel(LCD_CONVERT_TRANSPOSE);
+    lcd_set_contiguous_refresh(true);
+    lcd_set_hardware_mirroring(true);
+    free(hashes[0]);
+    free(hashes[1]);
+    capture_reader_close(&reader);
+    return failures;
+}
+
+// 追帧送显：捕获运行时按带送进ST7789 GRAM模型 (两个输出引擎) 和ST75320显示RAM模型 (0度/90度)，
+// 信号源停下后屏上必须是最后一帧 (ST75320与同一帧整屏同步刷新的图像比较)
+#define VERIFY_BEAM_FRAMES 12
+#define VERIFY_BEAM_RUNS 4
+
+static uint32_t verify_beam(lcd_color_format_t format, uint32_t *checked, uint32_t *bands)
+{
+    static const uint16_t fg = 0xF81F, bg = 0x07E0;
+    static const char *run_names[VERIFY_BEAM_RUNS] = {"ST7789 LUT", "ST7789 PIO展开", "ST75320 0度", "ST75320 90度"};
+    static st7789_model_t model;
+    static st75320_model_t ram, reference;
+    static uint8_t last[FRAME_BYTES];
+    uint32_t failures = 0;
+
+    init_capture_pio();
+    if (!lcd_framebuffer_init_auto_capture(LCD_CAPTURE_PIO, LCD_CAPTURE_SM) || !init_monitor_pio() ||
+        !lcd_framebuffer_start_auto_capture())
+    {
+        printf("❌ 追帧送显: 捕获初始化失败\n");
+        return 1;
+    }
+    lcd_capture_frame_irq_enable(LCD_CAPTURE_PIO);
+    synth_frame(VERIFY_BEAM_FRAMES - 1, last);
+    spi_lcd_set_colors(fg, bg);
+
+    for (int run = 0; run < VERIFY_BEAM_RUNS; run++)
+    {
+        host_lcd_t lcd = run < 2 ? HOST_LCD_ST7789 : HOST_LCD_ST75320;
+        if (lcd == HOST_LCD_ST7789)
+        {
+            if (!spi_lcd_set_output_engine(run == 0 ? LCD_OUTPUT_SPI_LUT : LCD_OUTPUT_PIO_EXPAND))
+                continue;
+            memset(&model, 0, sizeof(model));
+            model.pixel_bits = format == LCD_COLOR_RGB444 ? 12 : 16;
+            sim_spi_set_sink(spi0, st7789_model_sink, &model);
+            spi_lcd_set_continuous_window(0, 0, LCD_FB_WIDTH - 1, LCD_FB_HEIGHT - 1);
+        }
+        else
+        {
+            st75320_model_reset(&ram);
+            sim_spi_set_sink(spi1, st75320_model_sink, &ram);
+            lcd_set_rotation(run == 2 ? LCD_ROTATION_0 : LCD_ROTATION_90);
+        }
+        lcd_framebuffer_force_redraw();
+
+        lcd_output_latency_stats_t before, after;
+        lcd_framebuffer_get_latency_stats(&before);
+        synth_source_t synth = {.limit = VERIFY_BEAM_FRAMES};
+        sim_x3501_config_t source = {
+            .pio = LCD_CAPTURE_PIO,
+            .sm = LCD_CAPTURE_SM,
+            .frame_period_us = X3501_FRAME_PERIOD_US,
+            .active_us = X3501_ACTIVE_US,
+            .next_frame = synth_next_frame,
+            .ctx = &synth,
+            .monitor_pio = LCD_MONITOR_PIO,
+            .line_sm = LCD_MONITOR_LINE_SM,
+            .clock_sm = LCD_MONITOR_CLOCK_SM,
+        };
+        sim_x3501_start(&source);
+        pipeline_result_t r;
+        beam_run(lcd, &r);
+        lcd_framebuffer_get_latency_stats(&after);
+        *bands += after.bands - before.bands;
+
+        uint32_t mismatches;
+        if (lcd == HOST_LCD_ST7789)
+        {
+            sim_spi_set_sink(spi0, NULL, NULL);
+            mismatches = st7789_model_mismatches(&model, last, format, fg, bg) + model.outside;
+        }
+        else
+        {
+            // 参考：同一旋转角度下把最后一帧整屏同步刷新一次
+            st75320_model_reset(&reference);
+            sim_spi_set_sink(spi1, st75320_model_sink, &reference);
+            lcd_set_rotation(run == 2 ? LCD_ROTATION_0 : LCD_ROTATION_90);
+            lcd_update_from_1bit_framebuffer(last);
+            lcd_wait();
+            sim_spi_set_sink(spi1, NULL, NULL);
+            mismatches = (ram.overflows != 0 || st75320_panel_hash(&ram) != st75320_panel_hash(&reference)) ? 1 : 0;
+        }
+
+        (*checked)++;
+        if (mismatches != 0 || after.bands == before.bands || after.overruns != before.overruns)
+        {
+            failures++;
+            printf("❌ 追帧送显 (%s): 最后的画面与最后一帧不一致 %u, 带 %u, 放弃 %u 帧\n", run_names[run], mismatches,
+                   after.bands - before.bands, after.overruns - before.overruns);
+        }
+    }
+    spi_lcd_set_output_engine(LCD_OUTPUT_SPI_LUT);
+    lcd_set_rotation(LCD_ROTATION_0);
+    lcd_framebuffer_stop_auto_capture();
+    return failures;
+}
+
+static int cmd_verify(const host_options_t *opt)
+{
+    host_options_t display_opt = *opt;
+    display_opt.lcd = HOST_LCD_ST7789;
+    display_opt.engine = LCD_OUTPUT_SPI_LUT;
+    sim_init(SIM_TIME_VIRTUAL);
+    if (!display_init(&display_opt))
+        return 1;
+
+    static const uint16_t colors[][2] = {
+        {LCD_COLOR_WHITE, LCD_COLOR_BLACK},
+        {LCD_COLOR_BLACK, LCD_COLOR_WHITE},
+        {0xF81F, 0x07E0},
+        {0x1234, 0xFEDC},
+        {0xA5A5, 0xA5A5},
+    };
+    const uint32_t color_count = sizeof(colors) / sizeof(colors[0]);
+    const size_t frame_bytes = (size_t)LCD_FB_WIDTH * LCD_FB_HEIGHT * 2;
+    static uint8_t frame[FRAME_BYTES];
+    uint8_t *expected = malloc(frame_bytes);
+    wire_capture_t lut = {.data = malloc(frame_bytes), .cap = frame_bytes};
+    wire_capture_t pio = {.data = malloc(frame_bytes), .cap = frame_bytes};
+
+    uint32_t checked = 0;
+    uint32_t failures = 0;
+    uint64_t lut_bus_ns = 0;
+    uint64_t pio_bus_ns = 0;
+    srand(1);
+    for (uint32_t pattern = 0; pattern < 6; pattern++)
+    {
+        const char *name;
+        switch (pattern)
+        {
+        case 0:
+            memset(frame, 0x00, sizeof(frame));
+            name = "全0";
+            break;
+        case 1:
+            memset(frame, 0xFF, sizeof(frame));
+            name = "全1";
+            break;
+        case 2:
+            for (size_t i = 0; i < sizeof(frame); i++)
+                frame[i] = ((i / ROW_BYTES) & 1) ? 0xAA : 0x55;
+            name = "棋盘";
+            break;
+        case 3:
+            for (size_t i = 0; i < sizeof(frame); i++)
+                frame[i] = (uint8_t)rand();
+            name = "随机";
+            break;
+        default:
+            synth_frame(pattern, frame);
+            name = "合成帧";
+            break;
+        }
+        lcd_framebuffer_submit_frame(frame, pattern + 1, 0, 0);
+        if (!lcd_framebuffer_prepare_display_frame())
+        {
+            printf("❌ %s: 测试帧没有进入渲染缓冲区\n", name);
+            failures++;
+            continue;
+        }
+        const uint8_t *fb = lcd_framebuffer_get_render_data();
+
+        for (uint32_t c = 0; c < color_count; c++)
+        {
+            sim_spi_set_sink(spi0, wire_capture_sink, &lut);
+            spi_lcd_set_colors(colors[c][0], colors[c][1]);
+            size_t expected_len = verify_reference(fb, opt->color, colors[c][0], colors[c][1], expected);
+            size_t lut_len = verify_engine(LCD_OUTPUT_SPI_LUT, &lut, &lut_bus_ns);
+            sim_spi_set_sink(spi0, wire_capture_sink, &pio);
+            size_t pio_len = verify_engine(LCD_OUTPUT_PIO_EXPAND, &pio, &pio_bus_ns);
+
+            bool lut_ok = lut_len == expected_len && memcmp(lut.data, expected, expected_len) == 0;
+            bool pio_ok = pio_len == expected_len && memcmp(pio.data, expected, expected_len) == 0;
+            checked++;
+            if (!lut_ok || !pio_ok)
+            {
+                failures++;
+                printf("❌ %s 前景0x%04X 背景0x%04X: 参考 %zu 字节, LUT %zu 字节%s, PIO %zu 字节%s\n", name,
+                       colors[c][0], colors[c][1], expected_len, lut_len, lut_ok ? "" : " (不一致)", pio_len,
+                       pio_ok ? "" : " (不一致)");
+            }
+        }
+    }
+    sim_spi_set_sink(spi0, NULL, NULL);
+    spi_lcd_set_output_engine(LCD_OUTPUT_SPI_LUT);
+    free(expected);
+
+    uint32_t partial_checked = 0;
+    uint32_t partial_wire_bytes[2] = {0};
+    uint32_t partial_full_bytes = 0;
+    uint32_t partial_failures =
+        verify_st7789_partial(opt->color, &partial_checked, partial_wire_bytes, &partial_full_bytes);
+    uint32_t fill_checked = 0;
+    uint64_t fill_bus_ns = 0;
+    uint32_t fill_failures = verify_st7789_fill(opt->color, &fill_checked, &fill_bus_ns);
+    free(lut.data);
+    free(pio.data);
+
+    uint64_t st75320_bus_ns[ST75320_VERIFY_PATHS] = {0};
+    uint32_t st75320_checked = 0;
+    uint32_t st75320_failures = verify_st75320(st75320_bus_ns, &st75320_checked);
+    uint32_t recorded_checked = 0;
+    uint32_t recorded_failures = 0;
+    if (opt->arg_count >= 1)
+        recorded_failures = verify_st75320_recording(opt->args[0], opt->frames_set ? opt->frames : 0,
+                                                     &recorded_checked);
+    uint32_t beam_checked = 0;
+    uint32_t beam_bands = 0;
+    uint32_t beam_failures = verify_beam(opt->color, &beam_checked, &beam_bands);
+
+    printf("=== lcd_host verify (%s) ===\n", opt->color == LCD_COLOR_RGB444 ? "RGB444" : "RGB565");
+    printf("  ST7789: 比较 %u 帧 (6种图案 x %u组颜色), 不一致 %u\n", checked, color_count, failures);
+    if (checked > 0)
+        printf("  平均整帧总线时间: LUT %.3f ms, PIO展开 %.3f ms\n", lut_bus_ns / 1e6 / checked,
+               pio_bus_ns / 1e6 / checked);
+    printf("  ST7789局部刷新: 比较 %u 次 (2个引擎 x 整帧/读数/零散行/隔行/全部行), 不一致 %u\n", partial_checked,
+           partial_failures);
+    printf("  16行读数更新线上字节: LUT %u, PIO展开 %u (整帧 %u)\n", partial_wire_bytes[0], partial_wire_bytes[1],
+           partial_full_bytes);
+    printf("  ST7789纯色填充: 比较 %u 次 (2个引擎 x 清屏/矩形/裁剪/奇数像素/空矩形), 不一致 %u, 整屏清屏总线时间 %.3f ms\n",
+           fill_checked, fill_failures, fill_bus_ns / 1e6);
+    printf("  ST75320: 比较 %u 组刷新 (3种图案 x 4个旋转角度，整屏+局部), 不一致 %u\n", st75320_checked,
+           st75320_failures);
+    if (st75320_checked > 0)
+        printf("  平均每组总线时间: PIO链路 %.3f ms, SPI %.3f ms, SPI纯软件旋转 %.3f ms, SPI逐页寻址 %.3f ms\n",
+               st75320_bus_ns[0] / 1e6 / st75320_checked, st75320_bus_ns[1] / 1e6 / st75320_checked,
+               st75320_bus_ns[2] / 1e6 / st75320_checked, st75320_bus_ns[3] / 1e6 / st75320_checked);
+    if (opt->arg_count >= 1)
+        printf("  ST75320录制帧 (%s): 比较 %u 帧 (4个旋转角度), 不一致 %u\n", opt->args[0], recorded_checked,
+               recorded_failures);
+    printf("  追帧送显: 比较 %u 次 (ST7789 LUT/PIO展开, ST75320 0度/90度，每次%u帧共%u个带), 不一致 %u\n", beam_checked,
+           VERIFY_BEAM_FRAMES, beam_bands, beam_failures);
+    if (failures != 0 || partial_failures != 0 || fill_failures != 0 || st75320_failures != 0 ||
+        recorded_failures != 0 || beam_failures != 0)
+        return 1;
+    printf("✅ LUT与PIO展开输出和参考模型逐字节一致，异步局部刷新后GRAM与当前帧一致、渲染缓冲区按时释放，DMA纯色填充与参考一致，ST75320 转置/逐位内核、硬件镜像/纯软件旋转、PIO链路/SPI显示的图像一致，追帧送显的最终画面正确\n");
+    return 0;
+}
+
+// =============================================================================
+// synth 子命令：合成帧写成 .cap (没有硬件时的回放素材)
+// =============================================================================
+static int cmd_synth(const host_options_t *opt)
+{
+    if (opt->arg_count != 1)
+        return 2;
+
+    capture_writer_t writer;
+    if (!capture_writer_open(&writer, opt->args[0]))
+        return 1;
+
+    static capture_record_t record;
+    for (uint32_t i = 0; i < opt->frames; i++)
+    {
+        synth_frame(i, record.data);
+        record.frame_id = i + 1;
+        record.timestamp_us = (uint64_t)i * X3501_FRAME_PERIOD_US;
+        record.frame_to_dma_interval_us = X3501_ACTIVE_US;
+        if (!capture_writer_append(&writer, &record))
+        {
+            perror(opt->args[0]);
+            capture_writer_close(&writer);
+            return 1;
+        }
+    }
+    capture_writer_close(&writer);
+    printf("写入 %u 帧到 %s\n", writer.count, opt->args[0]);
+    return 0;
+}
+
+// =============================================================================
+// import 子命令：设备串口日志 (ENABLE_CAPTURE_DUMP 输出的 @CAP 行) -> .cap
+// =============================================================================
+static int cmd_import(const host_options_t *opt)
+{
+    if (opt->arg_count != 2)
+        return 2;
+
+    FILE *in = fopen(opt->args[0], "r");
+    if (in == NULL)
+    {
+        perror(opt->args[0]);
+        return 1;
+    }
+    capture_writer_t writer;
+    if (!capture_writer_open(&writer, opt->args[1]))
+    {
+        fclose(in);
+        return 1;
+    }
+
+    static char line[CAPTURE_LINE_MAX + 256];
+    static capture_record_t record;
+    uint32_t skipped = 0;
+    int rc = 0;
+
+    while (fgets(line, sizeof(line), in) != NULL)
+    {
+        if (strstr(line, CAPTURE_LINE_PREFIX) == NULL)
+            continue;
+        if (!capture_record_parse_line(line, &record))
+        {
+            skipped++; // 串口丢字节导致的残缺行
+            continue;
+        }
+        if (!capture_writer_append(&writer, &record))
+        {
+            perror(opt->args[1]);
+            rc = 1;
+            break;
+        }
+    }
+
+    fclose(in);
+    capture_writer_close(&writer);
+    printf("导入 %u 帧到 %s (跳过 %u 条残缺记录)\n", writer.count, opt->args[1], skipped);
+    return rc;
+}
+
+// =============================================================================
+// replay 子命令：.cap -> 三重缓冲 -> 显示驱动
+// =============================================================================
+typedef struct {
+    const capture_reader_t *reader;
+    uint32_t next;
+    uint64_t base_ns;
+} replay_state_t;
+
+static void replay_submit(const capture_record_t *record)
+{
+    lcd_framebuffer_submit_frame(record->data, record->frame_id, record->timestamp_us,
+                                 record->frame_to_dma_interval_us);
+}
+
+// 原速回放：每条记录作为一个模拟事件，在记录的相对时间点提交
+static void replay_event(void *ctx)
+{
+    replay_state_t *st = (replay_state_t *)ctx;
+    const capture_record_t *record = capture_reader_record(st->reader, st->next);
+    replay_submit(record);
+
+    if (++st->next < st->reader->count)
+    {
+        uint64_t t0 = capture_reader_record(st->reader, 0)->timestamp_us;
+        uint64_t t = capture_reader_record(st->reader, st->next)->timestamp_us;
+        sim_schedule(st->base_ns + (t > t0 ? t - t0 : 0) * 1000, replay_event, st);
+    }
+}
+
+static int cmd_replay(const host_options_t *opt)
+{
+    if (opt->arg_count != 1)
+        return 2;
+
+    capture_reader_t reader;
+    if (!capture_reader_open(&reader, opt->args[0]))
+        return 1;
+    if (reader.count == 0)
+    {
+        printf("%s: 没有记录\n", opt->args[0]);
+        capture_reader_close(&reader);
+        return 1;
+    }
+
+    sim_init(opt->time_mode);
+    if (!display_init(opt))
+    {
+        capture_reader_close(&reader);
+        return 1;
+    }
+    reset_bus_stats();
+
+    uint32_t total = reader.count;
+    if (opt->frames_set && opt->frames < total)
+        total = opt->frames;
+    reader.count = total;
+
+    pipeline_result_t r;
+    memset(&r, 0, sizeof(r));
+
+    if (opt->speed == REPLAY_SPEED_ORIGINAL)
+    {
+        replay_state_t st = {.reader = &reader, .next = 0, .base_ns = sim_now_ns()};
+        sim_schedule(st.base_ns, replay_event, &st);
+        uint64_t sim_start = sim_now_ns();
+
+        // 与固件主循环一致：输出空闲且有新帧就提交，否则等待下一个事件 (帧到达或发送完成)
+        for (;;)
+        {
+            if (display_output_poll(opt->lcd) && lcd_framebuffer_prepare_changed_frame())
+            {
+                uint64_t t0 = host_ns();
+                uint64_t s0 = sim_now_ns();
+                display_render_frame(opt->lcd);
+                r.display_host_ns += host_ns() - t0;
+                r.display_sim_ns += sim_now_ns() - s0;
+                r.displayed++;
+                if (st.next >= reader.count && lcd_framebuffer_get_frame_count() >= reader.count)
+                    break;
+            }
+            else if (!sim_idle())
+            {
+                break;
+            }
+        }
+        display_output_wait(opt->lcd);
+        r.sim_elapsed_ns = sim_now_ns() - sim_start;
+    }
+    else
+    {
+        uint64_t sim_start = sim_now_ns();
+        for (uint32_t i = 0; i < reader.count; i++)
+        {
+            replay_submit(capture_reader_record(&reader, i));
+            display_output_wait(opt->lcd); // 每一帧都送显：等上一帧发完、渲染缓冲区释放
+            if (!lcd_framebuffer_prepare_changed_frame())
+                continue;
+            uint64_t t0 = host_ns();
+            uint64_t s0 = sim_now_ns();
+            display_render_frame(opt->lcd);
+            r.display_host_ns += host_ns() - t0;
+            r.display_sim_ns += sim_now_ns() - s0;
+            r.displayed++;
+        }
+        display_output_wait(opt->lcd);
+        r.sim_elapsed_ns = sim_now_ns() - sim_start;
+    }
+
+    const capture_record_t *first = capture_reader_record(&reader, 0);
+    const capture_record_t *last = capture_reader_record(&reader, reader.count - 1);
+    print_pipeline_result("lcd_host replay", opt, &r);
+    printf("  文件: %s, %u 帧 (frame_id %u..%u, 原始时长 %.1f ms), 速度: %s\n", opt->args[0],
+           reader.count, first->frame_id, last->frame_id,
+           (last->timestamp_us - first->timestamp_us) / 1e3,
+           opt->speed == REPLAY_SPEED_MAX ? "max" : "original");
+
+    capture_reader_close(&reader);
+    return 0;
+}
+
+// =============================================================================
+// kernels 子命令：ST75320 1-bit -> 页格式转换内核的微基准 (主机CPU耗时)
+// 整屏更新 = 转换 + SPI发送；发送部分与内核无关，单独用 lcd_clear (30个全0页) 测出后扣除
+// (页流水线模式下逐页计时、清零页缓冲的开销留在转换时间里)。
+// 逐位/转置两列借助硬件镜像 (默认)，最后一列是转置内核关闭硬件镜像、全部软件重映射的耗时
+// =============================================================================
+#define KERNELS_BATCHES 5
+
+// n次整屏更新 (frame为NULL时只发送30个全0页) 的每帧耗时，取若干批中最快的一批
+static double kernels_time_ns(const uint8_t *frame, uint32_t n)
+{
+    double best = 0;
+    for (int batch = 0; batch < KERNELS_BATCHES; batch++)
+    {
+        uint64_t start = host_ns();
+        for (uint32_t i = 0; i < n; i++)
+        {
+            if (frame != NULL)
+                lcd_update_from_1bit_framebuffer(frame);
+            else
+                lcd_clear();
+        }
+        double ns = (double)(host_ns() - start) / n;
+        if (batch == 0 || ns < best)
+            best = ns;
+    }
+    return best;
+}
+
+static int cmd_kernels(const host_options_t *opt)
+{
+    sim_init(SIM_TIME_VIRTUAL);
+    lcd_init();
+    lcd_set_pio_link(false);
+
+    static const struct {
+        lcd_convert_kernel_t kernel;
+        bool hardware_mirroring;
+        const char *name;
+    } kernels[3] = {
+        {LCD_CONVERT_BITWISE, true, "逐位"},
+        {LCD_CONVERT_TRANSPOSE, true, "转置"},
+        {LCD_CONVERT_TRANSPOSE, false, "纯软件"},
+    };
+    static const char *pattern_names[3] = {"稀疏(合成帧)", "密集(随机)", "全亮"};
+    static uint8_t frames[3][FRAME_BYTES];
+    synth_frame(0, frames[0]);
+    srand(3);
+    for (size_t i = 0; i < FRAME_BYTES; i++)
+        frames[1][i] = (uint8_t)rand();
+    memset(frames[2], 0xFF, FRAME_BYTES);
+
+    uint32_t n = opt->frames ? opt->frames : 1;
+    double send_ns = kernels_time_ns(NULL, n);
+
+    double result[4][3][3];
+    for (uint32_t rotation = LCD_ROTATION_0; rotation <= LCD_ROTATION_270; rotation++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            lcd_set_convert_kernel(kernels[k].kernel);
+            lcd_set_hardware_mirroring(kernels[k].hardware_mirroring);
+            lcd_set_rotation((lcd_rotation_t)rotation);
+            for (int p = 0; p < 3; p++)
+                result[rotation][p][k] = kernels_time_ns(frames[p], n);
+        }
+    }
+    lcd_set_convert_kernel(LCD_CONVERT_TRANSPOSE);
+    lcd_set_hardware_mirroring(true);
+
+    // 第一次测量可能赶上冷缓存，发送基线前后各测一次取较快的
+    double send_after_ns = kernels_time_ns(NULL, n);
+    if (send_after_ns < send_ns)
+        send_ns = send_after_ns;
+    for (uint32_t rotation = LCD_ROTATION_0; rotation <= LCD_ROTATION_270; rotation++)
+    {
+        for (int p = 0; p < 3; p++)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                double ns = result[rotation][p][k] - send_ns;
+                result[rotation][p][k] = ns > 0 ? ns : 0;
+            }
+        }
+    }
+
+    printf("\n========== lcd_host kernels ==========\n");
+    printf("每种组合整屏转换 %u 次 x %d 批取最快，主机CPU us/帧 (已扣除SPI发送 %.1f us/帧，转换含逐页流水线开销)\n", n,
+           KERNELS_BATCHES, send_ns / 1e3);
+    printf("  旋转      %s      %s    加速   %s  图案\n", kernels[0].name, kernels[1].name, kernels[2].name);
+    for (uint32_t rotation = LCD_ROTATION_0; rotation <= LCD_ROTATION_270; rotation++)
+    {
+        for (int p = 0; p < 3; p++)
+        {
+            double bitwise = result[rotation][p][0];
+            double transpose = result[rotation][p][1];
+            printf("  %4u° %8.1f %8.1f %6.1fx %8.1f  %s\n", rotation * 90, bitwise / 1e3, transpose / 1e3,
+                   transpose > 0 ? bitwise / transpose : 0.0, result[rotation][p][2] / 1e3, pattern_names[p]);
+        }
+    }
+    return 0;
+}
+
+// =============================================================================
+// stress 子命令：两个真实线程压测无锁三重缓冲 (不经过模拟HAL)
+// 生产者按序号填满缓冲区后发布，消费者检查每次取到的缓冲区没有被撕裂、序号单调递增
+// =============================================================================
+#define STRESS_WORDS 64
+#define STRESS_DEFAULT_SWAPS 5000000u
+
+typedef struct {
+    lcd_triple_buffer_t tb;
+    uint32_t buffers[3][STRESS_WORDS];
+    uint32_t swaps;
+    atomic_bool producer_done;
+    uint64_t acquired;
+    uint64_t torn;
+    uint64_t out_of_order;
+    uint32_t last_seq;
+} stress_state_t;
+
+static uint32_t stress_word(uint32_t seq, uint32_t w)
+{
+    return seq * 2654435761u + w;
+}
+
+static void *stress_producer(void *arg)
+{
+    stress_state_t *st = arg;
+    uint32_t active = lcd_triple_buffer_active(&st->tb);
+    for (uint32_t seq = 1; seq <= st->swaps; seq++)
+    {
+        uint32_t *buf = st->buffers[active];
+        for (uint32_t w = 0; w < STRESS_WORDS; w++)
+            buf[w] = stress_word(seq, w);
+        active = lcd_triple_buffer_publish(&st->tb);
+        // 单核主机上线程只在时间片边界交错，定期让出CPU增加交错点
+        if ((seq & 15) == 0)
+            sched_yield();
+    }
+    atomic_store(&st->producer_done, true);
+    return NULL;
+}
+
+static void stress_check(stress_state_t *st)
+{
+    const uint32_t *buf = st->buffers[lcd_triple_buffer_render(&st->tb)];
+    // 第0个字 = seq * 2654435761，乘数是奇数，乘以它的模2^32逆元即可反推序号
+    uint32_t seq = buf[0] * 244002641u;
+    st->acquired++;
+    for (uint32_t w = 1; w < STRESS_WORDS; w++)
+    {
+        if (buf[w] != stress_word(seq, w))
+        {
+            st->torn++;
+            break;
+        }
+    }
+    if (seq <= st->last_seq)
+        st->out_of_order++;
+    st->last_seq = seq;
+}
+
+static void *stress_consumer(void *arg)
+{
+    stress_state_t *st = arg;
+    for (;;)
+    {
+        // 先读完成标志再取帧：标志置位后的最后一次获取一定能拿到最后一帧
+        bool done = atomic_load(&st->producer_done);
+        if (lcd_triple_buffer_acquire(&st->tb))
+            stress_check(st);
+        else if (done)
+            break;
+        else
+            sched_yield();
+    }
+    return NULL;
+}
+
+static int cmd_stress(const host_options_t *opt)
+{
+    static stress_state_t st;
+    memset(&st, 0, sizeof(st));
+    lcd_triple_buffer_init(&st.tb);
+    st.swaps = opt->frames_set ? opt->frames : STRESS_DEFAULT_SWAPS;
+
+    uint64_t t0 = host_ns();
+    pthread_t producer, consumer;
+    pthread_create(&consumer, NULL, stress_consumer, &st);
+    pthread_create(&producer, NULL, stress_producer, &st);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+    double seconds = (host_ns() - t0) / 1e9;
+
+    bool ok = st.torn == 0 && st.out_of_order == 0 && st.last_seq == st.swaps;
+    printf("\n========== lcd_host stress ==========\n");
+    printf("发布 %u 帧, 获取 %llu 帧 (%.1f%%), 用时 %.2f s (%.1f M次发布/s)\n", st.swaps,
+           (unsigned long long)st.acquired, st.swaps ? 100.0 * st.acquired / st.swaps : 0.0,
+           seconds, st.swaps / seconds / 1e6);
+    printf("撕裂 %llu, 乱序 %llu, 最后一帧 %u/%u\n", (unsigned long long)st.torn,
+           (unsigned long long)st.out_of_order, st.last_seq, st.swaps);
+    printf("%s\n", ok ? "✅ 三重缓冲无锁交换正常" : "❌ 三重缓冲交换出错");
+    return ok ? 0 : 1;
+}
+
+// =============================================================================
+// 命令行
+// =============================================================================
+static void usage(void)
+{
+    printf("用法: lcd_host <命令> [选项]\n");
+    printf("命令:\n");
+    printf("  bench                       合成帧跑完整流水线并打印SPI/DMA计数\n");
+    printf("  synth <out.cap>             生成合成帧捕获文件\n");
+    printf("  import <serial.log> <out.cap>  把设备串口输出的@CAP记录转成捕获文件\n");
+    printf("  replay <in.cap>             回放捕获文件到显示驱动\n");
+    printf("  stress                      生产者/消费者线程压测无锁三重缓冲\n");
+    printf("  faults                      注入信号故障，检查检出、快速恢复和显示内容\n");
+    printf("  verify [in.cap]             ST7789的LUT/PIO展开输出与参考模型逐字节比较，ST75320内核/链路写入比较\n");
+    printf("  kernels                     ST75320转换内核微基准 (逐位 vs 8x8转置，稀疏/密集帧)\n");
+    printf("选项:\n");
+    printf("  --lcd st7789|st75320   输出显示器 (默认 st75320)\n");
+    printf("  --color rgb565|rgb444  ST7789像素格式 (默认 rgb565)\n");
+    printf("  --engine lut|pio       ST7789输出引擎：CPU查表或pio1展开 (默认 lut)\n");
+    printf("  --te                   bench: ST7789按面板TE节拍送显 (默认帧到即发)\n");
+    printf("  --beam                 bench: 追帧送显，每捕获24行就送出其中变化的行 (默认整帧捕获完再送)\n");
+    printf("  --link pio|spi         ST75320输出链路：pio1显示链路或SPI控制器 (默认 pio)\n");
+    printf("  --address once|page    ST75320整页宽度的连续页只寻址一次或逐页寻址 (默认 once)\n");
+    printf("  --frames N             帧数 (默认 200；replay默认全部，stress默认500万，faults默认300)\n");
+    printf("  --speed original|max   回放速度 (默认 original)\n");
+    printf("  --virtual              纯模拟时钟 (结果可重复)\n");
+    printf("  --irq-latency US       bench/faults: 中断响应延迟 (模拟其它中断占用CPU)\n");
+    printf("  --fault-every N        bench/faults: 每N帧注入一次行数/DATACLK数故障 (faults默认7)\n");
+}
+
+static bool parse_options(int argc, char **argv, host_options_t *opt)
+{
+    opt->lcd = HOST_LCD_ST75320;
+    opt->color = LCD_COLOR_RGB565;
+    opt->engine = LCD_OUTPUT_SPI_LUT;
+    opt->st7789_te = false;
+    opt->beam = false;
+    opt->st75320_pio_link = true;
+    opt->st75320_contiguous = true;
+    opt->frames = 200;
+    opt->time_mode = SIM_TIME_REAL;
+    opt->irq_latency_us = 0;
+    opt->fault_every = 0;
+    opt->speed = REPLAY_SPEED_ORIGINAL;
+    opt->frames_set = false;
+    opt->arg_count = 0;
+
+    for (int i = 2; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--lcd") == 0 && i + 1 < argc)
+        {
+            const char *name = argv[++i];
+            if (strcmp(name, "st7789") == 0)
+                opt->lcd = HOST_LCD_ST7789;
+            else if (strcmp(name, "st75320") == 0)
+                opt->lcd = HOST_LCD_ST75320;
+            else
+                return false;
+        }
+        else if (strcmp(argv[i], "--color") == 0 && i + 1 < argc)
+        {
+            const char *color = argv[++i];
+            if (strcmp(color, "rgb565") == 0)
+                opt->color = LCD_COLOR_RGB565;
+            else if (strcmp(color, "rgb444") == 0)
+                opt->color = LCD_COLOR_RGB444;
+            else
+                return false;
+        }
+        else if (strcmp(argv[i], "--engine") == 0 && i + 1 < argc)
+        {
+            const char *engine = argv[++i];
+            if (strcmp(engine, "lut") == 0)
+                opt->engine = LCD_OUTPUT_SPI_LUT;
+            else if (strcmp(engine, "pio") == 0)
+                opt->engine = LCD_OUTPUT_PIO_EXPAND;
+            else
+                return false;
+        }
+        else if (strcmp(argv[i], "--link") == 0 && i + 1 < argc)
+        {
+            const char *link = argv[++i];
+            if (strcmp(link, "pio") == 0)
+                opt->st75320_pio_link = true;
+            else if (strcmp(link, "spi") == 0)
+                opt->st75320_pio_link = false;
+            else
+                return false;
+        }
+        else if (strcmp(argv[i], "--address") == 0 && i + 1 < argc)
+        {
+            const char *address = argv[++i];
+            if (strcmp(address, "once") == 0)
+                opt->st75320_contiguous = true;
+            else if (strcmp(address, "page") == 0)
+                opt->st75320_contiguous = false;
+            else
+                return false;
+        }
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+        {
+            opt->frames = (uint32_t)strtoul(argv[++i], NULL, 0);
+            opt->frames_set = true;
+        }
+        else if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc)
+        {
+            const char *speed = argv[++i];
+            if (strcmp(speed, "original") == 0)
+                opt->speed = REPLAY_SPEED_ORIGINAL;
+            else if (strcmp(speed, "max") == 0)
+                opt->speed = REPLAY_SPEED_MAX;
+            else
+                return false;
+        }
+        else if (strcmp(argv[i], "--irq-latency") == 0 && i + 1 < argc)
+        {
+            opt->irq_latency_us = (uint32_t)strtoul(argv[++i], NULL, 0);
+        }
+        else if (strcmp(argv[i], "--fault-every") == 0 && i + 1 < argc)
+        {
+            opt->fault_every = (uint32_t)strtoul(argv[++i], NULL, 0);
+        }
+        else if (strcmp(argv[i], "--te") == 0)
+        {
+            opt->st7789_te = true;
+        }
+        else if (strcmp(argv[i], "--beam") == 0)
+        {
+            opt->beam = true;
+        }
+        else if (strcmp(argv[i], "--virtual") == 0)
+        {
+            opt->time_mode = SIM_TIME_VIRTUAL;
+        }
+        else if (argv[i][0] != '-' && opt->arg_count < HOST_MAX_ARGS)
+        {
+            opt->args[opt->arg_count++] = argv[i];
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    host_options_t opt;
+    if (argc < 2 || !parse_options(argc, argv, &opt))
+    {
+        usage();
+        return 2;
+    }
+
+    int rc = 2;
+    if (strcmp(argv[1], "bench") == 0)
+        rc = cmd_bench(&opt);
+    else if (strcmp(argv[1], "synth") == 0)
+        rc = cmd_synth(&opt);
+    else if (strcmp(argv[1], "import") == 0)
+        rc = cmd_import(&opt);
+    else if (strcmp(argv[1], "replay") == 0)
+        rc = cmd_replay(&opt);
+    else if (strcmp(argv[1], "stress") == 0)
+        rc = cmd_stress(&opt);
+    else if (strcmp(argv[1], "faults") == 0)
+        rc = cmd_faults(&opt);
+    else if (strcmp(argv[1], "verify") == 0)
+        rc = cmd_verify(&opt);
+    else if (strcmp(argv[1], "kernels") == 0)
+        rc = cmd_kernels(&opt);
+
+    if (rc == 2)
+        usage();
+    return rc;
+}
@@ -0,0 +1,45 @@
+// =============================================================================
+// 主机端替身：内容与 pioasm 从 ../lcd_link.pio 生成的头文件一致 (指令手工汇编)。
+// 主机没有pioasm；sim_pio.c 的指令解释器执行这些编码，修改 .pio 时必须同步修改这里。
+// =============================================================================
+#pragma once
+
+#include "hardware/pio.h"
+
+#define lcd_link_wrap_target 0
+#define lcd_link_wrap 13
+#define lcd_link_pio_version 0
+
+static const uint16_t lcd_link_program_instructions[] = {
+            //     .wrap_target
+    0xe006, //  0: set    pins, 6         side 0
+    0x80a0, //  1: pull   block           side 0
+    0x6041, //  2: out    y, 1            side 0
+    0xe000, //  3: set    pins, 0         side 0
+    0x0066, //  4: jmp    !y, 6           side 0
+    0xe001, //  5: set    pins, 1         side 0
+    0x6027, //  6: out    x, 7            side 0
+    0x80a0, //  7: pull   block           side 0
+    0xe047, //  8: set    y, 7            side 0
+    0x6301, //  9: out    pins, 1         side 0 [3]
+    0x1389, // 10: jmp    y--, 9          side 1 [3]
+    0x0047, // 11: jmp    x--, 7          side 0
+    0xa025, // 12: mov    x, status       side 0
+    0x0021, // 13: jmp    !x, 1           side 0
+            //     .wrap
+};
+
+static const pio_program_t lcd_link_program = {
+    .instructions = lcd_link_program_instructions,
+    .length = 14,
+    .origin = -1,
+    .pio_version = 0,
+};
+
+static inline pio_sm_config lcd_link_program_get_default_config(uint offset)
+{
+    pio_sm_config c = pio_get_default_sm_config();
+    sm_config_set_wrap(&c, offset + lcd_link_wrap_target, offset + lcd_link_wrap);
+    sm_config_set_sideset(&c, 1, false, false);
+    return c;
+}
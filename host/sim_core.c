@@ -0,0 +1,550 @@
+// =============================================================================
+// 主机模拟HAL：时钟、事件、中断、GPIO、PWM、临界区
+// =============================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include "pico/stdlib.h"
+#include "pico/sync.h"
+#include "hardware/irq.h"
+#include "hardware/pwm.h"
+#include "hardware/sync.h"
+#include "sim_hal.h"
+
+// =============================================================================
+// 模拟时钟
+// =============================================================================
+static sim_time_mode_t time_mode = SIM_TIME_REAL;
+static uint64_t host_epoch_ns = 0;
+static uint64_t offset_ns = 0;
+
+static uint64_t host_monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+uint64_t sim_now_ns(void)
+{
+    if (time_mode == SIM_TIME_VIRTUAL)
+        return offset_ns;
+    return host_monotonic_ns() - host_epoch_ns + offset_ns;
+}
+
+void sim_advance_ns(uint64_t ns)
+{
+    offset_ns += ns;
+}
+
+void sim_advance_to_ns(uint64_t t_ns)
+{
+    uint64_t now = sim_now_ns();
+    if (t_ns > now)
+        offset_ns += t_ns - now;
+}
+
+uint64_t time_us_64(void)
+{
+    sim_poll();
+    return sim_now_ns() / 1000;
+}
+
+void busy_wait_us(uint64_t delay_us)
+{
+    sim_advance_ns(delay_us * 1000);
+    sim_poll();
+}
+
+void sleep_us(uint64_t us)
+{
+    busy_wait_us(us);
+}
+
+void sleep_ms(uint32_t ms)
+{
+    busy_wait_us((uint64_t)ms * 1000);
+}
+
+bool stdio_init_all(void)
+{
+    return true;
+}
+
+void panic(const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    fputc('\n', stderr);
+    abort();
+}
+
+// =============================================================================
+// 定时事件
+// =============================================================================
+#define SIM_MAX_EVENTS 64
+
+typedef struct {
+    bool used;
+    uint64_t at_ns;
+    sim_event_fn fn;
+    void *ctx;
+} sim_event_t;
+
+static sim_event_t events[SIM_MAX_EVENTS];
+
+bool sim_schedule(uint64_t at_ns, sim_event_fn fn, void *ctx)
+{
+    for (int i = 0; i < SIM_MAX_EVENTS; i++)
+    {
+        if (!events[i].used)
+        {
+            events[i].used = true;
+            events[i].at_ns = at_ns;
+            events[i].fn = fn;
+            events[i].ctx = ctx;
+            return true;
+        }
+    }
+    return false;
+}
+
+void sim_cancel(sim_event_fn fn, void *ctx)
+{
+    for (int i = 0; i < SIM_MAX_EVENTS; i++)
+    {
+        if (events[i].used && events[i].fn == fn && events[i].ctx == ctx)
+            events[i].used = false;
+    }
+}
+
+static int next_event_index(void)
+{
+    int best = -1;
+    for (int i = 0; i < SIM_MAX_EVENTS; i++)
+    {
+        if (events[i].used && (best < 0 || events[i].at_ns < events[best].at_ns))
+            best = i;
+    }
+    return best;
+}
+
+// =============================================================================
+// 中断
+// =============================================================================
+#define SIM_MAX_SHARED_HANDLERS 4
+
+static irq_handler_t irq_handlers[NUM_IRQS][SIM_MAX_SHARED_HANDLERS];
+static bool irq_enabled[NUM_IRQS];
+static bool irq_pending[NUM_IRQS];
+static uint64_t irq_ready_at_ns[NUM_IRQS]; // 挂起后最早可分发的时刻 (模拟中断延迟)
+static uint64_t irq_latency_ns = 0;
+static uint32_t irq_mask_depth = 0; // 临界区/关中断嵌套深度
+static bool in_irq = false;
+static bool polling = false;
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler)
+{
+    if (irq_handlers[num][0] != NULL && irq_handlers[num][0] != handler)
+        panic("irq %u: exclusive handler already set", num);
+    memset(irq_handlers[num], 0, sizeof(irq_handlers[num]));
+    irq_handlers[num][0] = handler;
+}
+
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority)
+{
+    (void)order_priority;
+    for (int i = 0; i < SIM_MAX_SHARED_HANDLERS; i++)
+    {
+        if (irq_handlers[num][i] == handler)
+            return;
+        if (irq_handlers[num][i] == NULL)
+        {
+            irq_handlers[num][i] = handler;
+            return;
+        }
+    }
+    panic("irq %u: too many shared handlers", num);
+}
+
+void irq_remove_handler(uint num, irq_handler_t handler)
+{
+    for (int i = 0; i < SIM_MAX_SHARED_HANDLERS; i++)
+    {
+        if (irq_handlers[num][i] == handler)
+        {
+            memmove(&irq_handlers[num][i], &irq_handlers[num][i + 1],
+                    (SIM_MAX_SHARED_HANDLERS - i - 1) * sizeof(irq_handler_t));
+            irq_handlers[num][SIM_MAX_SHARED_HANDLERS - 1] = NULL;
+            return;
+        }
+    }
+}
+
+void irq_set_enabled(uint num, bool enabled)
+{
+    irq_enabled[num] = enabled;
+    sim_poll();
+}
+
+bool irq_is_enabled(uint num)
+{
+    return irq_enabled[num];
+}
+
+void irq_set_priority(uint num, uint8_t hardware_priority)
+{
+    (void)num;
+    (void)hardware_priority;
+}
+
+static void irq_latency_elapsed(void *ctx)
+{
+    (void)ctx; // 只为让 sim_idle 在延迟结束时醒来，分发在 sim_poll 中进行
+}
+
+void sim_irq_set_pending(uint num)
+{
+    if (!irq_pending[num])
+    {
+        irq_ready_at_ns[num] = sim_now_ns() + irq_latency_ns;
+        if (irq_latency_ns > 0)
+            sim_schedule(irq_ready_at_ns[num], irq_latency_elapsed, NULL);
+    }
+    irq_pending[num] = true;
+}
+
+void sim_irq_set_latency_ns(uint64_t ns)
+{
+    irq_latency_ns = ns;
+}
+
+bool sim_irq_masked(void)
+{
+    return irq_mask_depth > 0 || in_irq;
+}
+
+// 分发挂起中断 (不嵌套：中断处理中或临界区内只挂起)
+static void dispatch_irqs(void)
+{
+    if (sim_irq_masked())
+        return;
+
+    bool again = true;
+    int rounds = 0;
+    while (again && rounds++ < 64)
+    {
+        again = false;
+        for (uint num = 0; num < NUM_IRQS; num++)
+        {
+            if (!irq_pending[num] || !irq_enabled[num] || irq_ready_at_ns[num] > sim_now_ns())
+                continue;
+            irq_pending[num] = false;
+            in_irq = true;
+            for (int i = 0; i < SIM_MAX_SHARED_HANDLERS && irq_handlers[num][i]; i++)
+                irq_handlers[num][i]();
+            in_irq = false;
+            again = true;
+        }
+    }
+}
+
+void sim_poll(void)
+{
+    if (polling)
+        return;
+    polling = true;
+
+    for (;;)
+    {
+        uint64_t now = sim_now_ns();
+        sim_dma_poll(now);
+
+        int idx = next_event_index();
+        if (idx >= 0 && events[idx].at_ns <= now)
+        {
+            // 事件代表外部硬件行为，不受CPU关中断影响
+            sim_event_t ev = events[idx];
+            events[idx].used = false;
+            ev.fn(ev.ctx);
+            dispatch_irqs();
+            continue;
+        }
+        dispatch_irqs();
+        break;
+    }
+
+    polling = false;
+}
+
+bool sim_idle(void)
+{
+    uint64_t next = UINT64_MAX;
+    int idx = next_event_index();
+    if (idx >= 0)
+        next = events[idx].at_ns;
+    uint64_t dma_next = sim_dma_next_completion_ns();
+    if (dma_next < next)
+        next = dma_next;
+    if (next == UINT64_MAX)
+        return false;
+
+    sim_advance_to_ns(next);
+    sim_poll();
+    return true;
+}
+
+// 自旋等待：虚拟时钟只被模拟等待推进，每次自旋推进到下一个事件 (否则等中断的自旋永远不会结束)
+void tight_loop_contents(void)
+{
+    if (time_mode == SIM_TIME_VIRTUAL && sim_idle())
+        return;
+    sim_poll();
+}
+
+void __wfi(void)
+{
+    sim_idle();
+}
+
+uint32_t save_and_disable_interrupts(void)
+{
+    irq_mask_depth++;
+    return 0;
+}
+
+void restore_interrupts(uint32_t status)
+{
+    (void)status;
+    if (irq_mask_depth > 0)
+        irq_mask_depth--;
+    sim_poll();
+}
+
+// =============================================================================
+// 临界区 (屏蔽模拟中断分发)
+// =============================================================================
+void critical_section_init(critical_section_t *crit_sec)
+{
+    crit_sec->depth = 0;
+}
+
+void critical_section_enter_blocking(critical_section_t *crit_sec)
+{
+    crit_sec->depth++;
+    irq_mask_depth++;
+}
+
+void critical_section_exit(critical_section_t *crit_sec)
+{
+    if (crit_sec->depth > 0)
+        crit_sec->depth--;
+    if (irq_mask_depth > 0)
+        irq_mask_depth--;
+    sim_poll();
+}
+
+void critical_section_deinit(critical_section_t *crit_sec)
+{
+    crit_sec->depth = 0;
+}
+
+// =============================================================================
+// GPIO
+// =============================================================================
+static bool gpio_level[NUM_BANK0_GPIOS];
+static bool gpio_is_out[NUM_BANK0_GPIOS];
+static enum gpio_function gpio_func[NUM_BANK0_GPIOS];
+
+void gpio_init(uint gpio)
+{
+    gpio_is_out[gpio] = false;
+    gpio_level[gpio] = false;
+    gpio_func[gpio] = GPIO_FUNC_SIO;
+}
+
+void gpio_set_dir(uint gpio, bool out)
+{
+    gpio_is_out[gpio] = out;
+}
+
+void gpio_put(uint gpio, bool value)
+{
+    if (gpio_is_out[gpio])
+        gpio_level[gpio] = value;
+}
+
+bool gpio_get(uint gpio)
+{
+    if (gpio_func[gpio] >= GPIO_FUNC_PIO0 && gpio_func[gpio] <= GPIO_FUNC_PIO2)
+        return sim_pio_pin_level(gpio_func[gpio] - GPIO_FUNC_PIO0, gpio);
+    return gpio_level[gpio];
+}
+
+void gpio_set_pulls(uint gpio, bool up, bool down)
+{
+    (void)gpio;
+    (void)up;
+    (void)down;
+}
+
+void gpio_set_function(uint gpio, enum gpio_function fn)
+{
+    gpio_func[gpio] = fn;
+    sim_spi_pin_function(gpio, fn);
+}
+
+enum gpio_function gpio_get_function(uint gpio)
+{
+    return gpio_func[gpio];
+}
+
+// 边沿中断：输入电平变化时锁存边沿事件，使能的事件挂起IO_IRQ_BANK0，由处理函数确认清除
+static uint32_t gpio_irq_mask[NUM_BANK0_GPIOS];
+static uint32_t gpio_irq_events[NUM_BANK0_GPIOS];
+
+void gpio_set_irq_enabled(uint gpio, uint32_t event_mask, bool enabled)
+{
+    gpio_acknowledge_irq(gpio, event_mask); // 与SDK一致：先清掉旧的边沿事件
+    if (enabled)
+        gpio_irq_mask[gpio] |= event_mask;
+    else
+        gpio_irq_mask[gpio] &= ~event_mask;
+}
+
+void gpio_add_raw_irq_handler(uint gpio, irq_handler_t handler)
+{
+    (void)gpio;
+    irq_add_shared_handler(IO_IRQ_BANK0, handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+}
+
+void gpio_remove_raw_irq_handler(uint gpio, irq_handler_t handler)
+{
+    (void)gpio;
+    irq_remove_handler(IO_IRQ_BANK0, handler);
+}
+
+uint32_t gpio_get_irq_event_mask(uint gpio)
+{
+    return gpio_irq_events[gpio] & gpio_irq_mask[gpio];
+}
+
+void gpio_acknowledge_irq(uint gpio, uint32_t event_mask)
+{
+    gpio_irq_events[gpio] &= ~(event_mask & (GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE));
+}
+
+void sim_gpio_set_input(uint gpio, bool level)
+{
+    if (gpio_is_out[gpio] || gpio_level[gpio] == level)
+        return;
+    gpio_level[gpio] = level;
+    gpio_irq_events[gpio] |= level ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+    if (gpio_get_irq_event_mask(gpio))
+        sim_irq_set_pending(IO_IRQ_BANK0);
+}
+
+// 周期脉冲：每个周期先高 high_ns 再低 (例如ST7789的TE输出)
+static struct {
+    uint gpio;
+    uint64_t period_ns;
+    uint64_t high_ns;
+    uint64_t next_rise_ns;
+} pulse_train;
+
+static void pulse_train_edge(void *ctx)
+{
+    bool rise = ctx != NULL;
+    sim_gpio_set_input(pulse_train.gpio, rise);
+    if (rise)
+    {
+        sim_schedule(pulse_train.next_rise_ns + pulse_train.high_ns, pulse_train_edge, NULL);
+        pulse_train.next_rise_ns += pulse_train.period_ns;
+        sim_schedule(pulse_train.next_rise_ns, pulse_train_edge, &pulse_train);
+    }
+}
+
+void sim_gpio_start_pulses(uint gpio, uint64_t first_rise_ns, uint64_t period_ns, uint64_t high_ns)
+{
+    sim_gpio_stop_pulses();
+    pulse_train.gpio = gpio;
+    pulse_train.period_ns = period_ns;
+    pulse_train.high_ns = high_ns;
+    pulse_train.next_rise_ns = first_rise_ns;
+    sim_schedule(first_rise_ns, pulse_train_edge, &pulse_train);
+}
+
+void sim_gpio_stop_pulses(void)
+{
+    sim_cancel(pulse_train_edge, &pulse_train);
+    sim_cancel(pulse_train_edge, NULL);
+}
+
+void sim_gpio_reset(void)
+{
+    memset(gpio_level, 0, sizeof(gpio_level));
+    memset(gpio_is_out, 0, sizeof(gpio_is_out));
+    memset(gpio_irq_mask, 0, sizeof(gpio_irq_mask));
+    memset(gpio_irq_events, 0, sizeof(gpio_irq_events));
+    for (int i = 0; i < NUM_BANK0_GPIOS; i++)
+        gpio_func[i] = GPIO_FUNC_NULL;
+}
+
+// =============================================================================
+// PWM (只保存寄存器值)
+// =============================================================================
+static pwm_hw_t pwm_regs;
+pwm_hw_t *const pwm_hw = &pwm_regs;
+
+pwm_config pwm_get_default_config(void)
+{
+    pwm_config c = {0};
+    c.div = 1.0f;
+    c.top = 0xffff;
+    return c;
+}
+
+void pwm_init(uint slice_num, pwm_config *c, bool start)
+{
+    pwm_regs.slice[slice_num].top = c->top;
+    pwm_regs.slice[slice_num].csr = start ? 1u : 0u;
+}
+
+void pwm_set_chan_level(uint slice_num, uint chan, uint16_t level)
+{
+    uint32_t cc = pwm_regs.slice[slice_num].cc;
+    if (chan)
+        cc = (cc & 0x0000ffffu) | ((uint32_t)level << 16);
+    else
+        cc = (cc & 0xffff0000u) | level;
+    pwm_regs.slice[slice_num].cc = cc;
+}
+
+// =============================================================================
+// 整体复位
+// =============================================================================
+void sim_init(sim_time_mode_t mode)
+{
+    time_mode = mode;
+    host_epoch_ns = host_monotonic_ns();
+    offset_ns = 0;
+
+    memset(events, 0, sizeof(events));
+    memset(irq_handlers, 0, sizeof(irq_handlers));
+    memset(irq_enabled, 0, sizeof(irq_enabled));
+    memset(irq_pending, 0, sizeof(irq_pending));
+    memset(irq_ready_at_ns, 0, sizeof(irq_ready_at_ns));
+    irq_latency_ns = 0;
+    irq_mask_depth = 0;
+    in_irq = false;
+    memset(&pwm_regs, 0, sizeof(pwm_regs));
+
+    sim_gpio_reset();
+    sim_dma_reset();
+    sim_spi_reset();
+    sim_pio_reset();
+}
@@ -0,0 +1,578 @@
+// =============================================================================
+// 主机模拟HAL：DMA控制器
+//
+// - DREQ为SPI TX：触发时一次性把数据交给SPI模型，按波特率计算完成时刻
+// - DREQ为PIO TX：触发时一次性把数据交给PIO指令解释器，完成时刻为状态机移完最后一位
+// - DREQ为PIO RX：通道进入等待，数据由 sim_dma_feed (PIO模型) 推送
+// - DREQ_FORCE  ：立即完成内存拷贝 (支持写环绕；写到其它通道的AL3别名时按控制块触发该通道)
+// - 嗅探器：对sniff通道搬运的每个字节计算CRC-32 (MSB优先) 或求和
+// 完成时置位INTR、按INTE0/INTE1挂起DMA_IRQ_0/1，并触发chain_to通道
+// =============================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/spi.h"
+#include "sim_hal.h"
+
+#define SIM_WAITING UINT64_MAX
+
+typedef struct {
+    bool claimed;
+    bool busy;
+    dma_channel_config cfg;
+    uint32_t reload_count;
+    uint64_t complete_at_ns;
+} sim_dma_channel_t;
+
+static dma_hw_t dma_regs;
+dma_hw_t *const dma_hw = &dma_regs;
+
+static sim_dma_channel_t channels[NUM_DMA_CHANNELS];
+static sim_dma_stats_t stats;
+
+typedef struct {
+    bool enabled;
+    uint channel;
+    uint mode;
+    bool invert;
+    bool reverse;
+} sim_sniffer_t;
+
+static sim_sniffer_t sniffer;
+
+static inline uint element_bytes(const dma_channel_config *cfg)
+{
+    return 1u << cfg->data_size;
+}
+
+void sim_dma_reset(void)
+{
+    memset(&dma_regs, 0, sizeof(dma_regs));
+    memset(channels, 0, sizeof(channels));
+    memset(&stats, 0, sizeof(stats));
+    memset(&sniffer, 0, sizeof(sniffer));
+}
+
+void sim_dma_get_stats(sim_dma_stats_t *out)
+{
+    *out = stats;
+}
+
+void sim_dma_reset_stats(void)
+{
+    memset(&stats, 0, sizeof(stats));
+}
+
+// =============================================================================
+// 通道分配
+// =============================================================================
+int dma_claim_unused_channel(bool required)
+{
+    for (uint ch = 0; ch < NUM_DMA_CHANNELS; ch++)
+    {
+        if (!channels[ch].claimed)
+        {
+            channels[ch].claimed = true;
+            return (int)ch;
+        }
+    }
+    if (required)
+        panic("No DMA channels are available");
+    return -1;
+}
+
+void dma_channel_claim(uint channel)
+{
+    if (channels[channel].claimed)
+        panic("DMA channel %u is already claimed", channel);
+    channels[channel].claimed = true;
+}
+
+void dma_channel_unclaim(uint channel)
+{
+    channels[channel].claimed = false;
+}
+
+bool dma_channel_is_claimed(uint channel)
+{
+    return channels[channel].claimed;
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel)
+{
+    dma_channel_config c;
+    memset(&c, 0, sizeof(c));
+    c.data_size = DMA_SIZE_32;
+    c.dreq = DREQ_FORCE;
+    c.chain_to = channel;
+    c.read_increment = true;
+    c.write_increment = false;
+    c.enable = true;
+    return c;
+}
+
+dma_channel_config dma_get_channel_config(uint channel)
+{
+    return channels[channel].cfg;
+}
+
+// =============================================================================
+// 嗅探器
+// =============================================================================
+static void sniff_bytes(uint ch, const dma_channel_config *cfg, const uint8_t *data, size_t len)
+{
+    if (!sniffer.enabled || sniffer.channel != ch || !cfg->sniff_enable)
+        return;
+
+    uint32_t acc = dma_regs.sniff_data;
+    switch (sniffer.mode)
+    {
+    case DMA_SNIFF_CTRL_CALC_VALUE_CRC32:
+        for (size_t i = 0; i < len; i++)
+        {
+            acc ^= (uint32_t)data[i] << 24;
+            for (int bit = 0; bit < 8; bit++)
+                acc = (acc & 0x80000000u) ? (acc << 1) ^ 0x04C11DB7u : (acc << 1);
+        }
+        break;
+    case DMA_SNIFF_CTRL_CALC_VALUE_SUM:
+        for (size_t i = 0; i < len; i++)
+            acc += data[i];
+        break;
+    default:
+        panic("sniffer mode %u is not simulated", sniffer.mode);
+    }
+    dma_regs.sniff_data = acc;
+}
+
+// =============================================================================
+// 传输完成与中断
+// =============================================================================
+static void start_transfer(uint ch);
+
+static void update_irq_lines(void)
+{
+    dma_regs.ints0 = dma_regs.intr & dma_regs.inte0;
+    dma_regs.ints1 = dma_regs.intr & dma_regs.inte1;
+    if (dma_regs.ints0)
+        sim_irq_set_pending(DMA_IRQ_0);
+    if (dma_regs.ints1)
+        sim_irq_set_pending(DMA_IRQ_1);
+}
+
+static void complete_transfer(uint ch)
+{
+    sim_dma_channel_t *c = &channels[ch];
+    c->busy = false;
+    c->complete_at_ns = 0;
+    dma_regs.ch[ch].transfer_count = 0;
+    stats.transfers++;
+
+    if (!c->cfg.irq_quiet)
+    {
+        dma_regs.intr |= 1u << ch;
+        update_irq_lines();
+    }
+
+    if (c->cfg.chain_to != ch)
+        start_transfer(c->cfg.chain_to);
+}
+
+void sim_dma_poll(uint64_t now_ns)
+{
+    for (uint ch = 0; ch < NUM_DMA_CHANNELS; ch++)
+    {
+        if (channels[ch].busy && channels[ch].complete_at_ns != SIM_WAITING &&
+            channels[ch].complete_at_ns <= now_ns)
+        {
+            complete_transfer(ch);
+        }
+    }
+    update_irq_lines();
+}
+
+uint64_t sim_dma_next_completion_ns(void)
+{
+    uint64_t next = UINT64_MAX;
+    for (uint ch = 0; ch < NUM_DMA_CHANNELS; ch++)
+    {
+        if (channels[ch].busy && channels[ch].complete_at_ns != SIM_WAITING &&
+            channels[ch].complete_at_ns < next)
+        {
+            next = channels[ch].complete_at_ns;
+        }
+    }
+    return next;
+}
+
+// 内存拷贝写到DMA通道寄存器：AL3_TRANS_COUNT设置重载计数，AL3_READ_ADDR_TRIG写完最后一个字节时触发
+static void register_written(uintptr_t addr, uint size)
+{
+    uintptr_t base = (uintptr_t)&dma_regs.ch[0];
+    uintptr_t end = (uintptr_t)&dma_regs.ch[NUM_DMA_CHANNELS];
+    if (addr < base || addr >= end)
+        return;
+
+    uint ch = (uint)((addr - base) / sizeof(dma_channel_hw_t));
+    dma_channel_hw_t *hw = &dma_regs.ch[ch];
+    uintptr_t count_reg = (uintptr_t)&hw->al3_transfer_count;
+    uintptr_t trig_reg = (uintptr_t)&hw->al3_read_addr_trig;
+    if (addr == count_reg)
+    {
+        channels[ch].reload_count = hw->al3_transfer_count;
+        if (!channels[ch].busy)
+            hw->transfer_count = hw->al3_transfer_count;
+    }
+    else if (addr + size == trig_reg + sizeof(hw->al3_read_addr_trig))
+    {
+        hw->read_addr = hw->al3_read_addr_trig;
+        if (hw->read_addr != 0)
+        {
+            start_transfer(ch);
+        }
+        else if (channels[ch].cfg.irq_quiet)
+        {
+            // 空触发：IRQ_QUIET通道在控制块表结束时产生一次中断
+            dma_regs.intr |= 1u << ch;
+            update_irq_lines();
+        }
+    }
+}
+
+static spi_inst_t *spi_for_dreq(uint dreq)
+{
+    if (dreq == DREQ_SPI0_TX)
+        return spi0;
+    if (dreq == DREQ_SPI1_TX)
+        return spi1;
+    return NULL;
+}
+
+static void start_transfer(uint ch)
+{
+    sim_dma_channel_t *c = &channels[ch];
+    dma_channel_hw_t *hw = &dma_regs.ch[ch];
+    uint size = element_bytes(&c->cfg);
+    uint32_t count = c->reload_count;
+
+    if (!c->cfg.enable)
+        return;
+
+    c->busy = true;
+    hw->transfer_count = count;
+
+    if (count == 0)
+    {
+        // 零长度传输立即完成
+        complete_transfer(ch);
+        return;
+    }
+
+    spi_inst_t *spi = spi_for_dreq(c->cfg.dreq);
+    if (spi != NULL)
+    {
+        // 内存 -> SPI：数据立即交给SPI模型，完成时刻由总线时间决定
+        const uint8_t *src = (const uint8_t *)hw->read_addr;
+        uint8_t *repeated = NULL;
+        if (!c->cfg.read_increment)
+        {
+            repeated = malloc((size_t)count * size);
+            for (uint32_t i = 0; i < count; i++)
+                memcpy(repeated + (size_t)i * size, src, size);
+            src = repeated;
+        }
+
+        sniff_bytes(ch, &c->cfg, src, (size_t)count * size);
+        c->complete_at_ns = sim_spi_transfer(spi, src, count, size, true);
+        free(repeated);
+
+        if (c->cfg.read_increment)
+            hw->read_addr += (uintptr_t)count * size;
+        stats.bus_transactions += count;
+        stats.bytes += (uint64_t)count * size;
+        return;
+    }
+
+    if (sim_pio_is_tx_dreq(c->cfg.dreq))
+    {
+        // 内存 -> PIO TX FIFO：窄写入与硬件一样在32位总线上复制到各字节通道
+        const uint8_t *src = (const uint8_t *)hw->read_addr;
+        uint32_t *words = malloc((size_t)count * sizeof(uint32_t));
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const uint8_t *p = src + (c->cfg.read_increment ? (size_t)i * size : 0);
+            uint32_t v = 0;
+            memcpy(&v, p, size);
+            if (size == 1)
+                v *= 0x01010101u;
+            else if (size == 2)
+                v *= 0x00010001u;
+            words[i] = v;
+            sniff_bytes(ch, &c->cfg, p, size);
+        }
+        c->complete_at_ns = sim_pio_tx_transfer(c->cfg.dreq, words, count, true);
+        free(words);
+
+        if (c->cfg.read_increment)
+            hw->read_addr += (uintptr_t)count * size;
+        stats.bus_transactions += count;
+        stats.bytes += (uint64_t)count * size;
+        return;
+    }
+
+    if (c->cfg.dreq == DREQ_FORCE)
+    {
+        uintptr_t dst = hw->write_addr;
+        uintptr_t src = hw->read_addr;
+        uintptr_t ring_mask = c->cfg.ring_size_bits ? (1u << c->cfg.ring_size_bits) - 1u : 0;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            memcpy((void *)dst, (const void *)src, size);
+            sniff_bytes(ch, &c->cfg, (const uint8_t *)src, size);
+            register_written(dst, size);
+            if (c->cfg.read_increment)
+                src = (ring_mask && !c->cfg.ring_write) ? (src & ~ring_mask) | ((src + size) & ring_mask) : src + size;
+            if (c->cfg.write_increment)
+                dst = (ring_mask && c->cfg.ring_write) ? (dst & ~ring_mask) | ((dst + size) & ring_mask) : dst + size;
+        }
+        hw->read_addr = src;
+        hw->write_addr = dst;
+        stats.bus_transactions += count;
+        stats.bytes += (uint64_t)count * size;
+        complete_transfer(ch);
+        return;
+    }
+
+    // 外设 -> 内存：等待外设按DREQ推送
+    c->complete_at_ns = SIM_WAITING;
+    sim_pio_dma_ready(c->cfg.dreq);
+}
+
+uint sim_dma_feed(uint dreq, const uint32_t *words, uint count)
+{
+    uint consumed = 0;
+
+    while (consumed < count)
+    {
+        int ch = -1;
+        for (uint i = 0; i < NUM_DMA_CHANNELS; i++)
+        {
+            if (channels[i].busy && channels[i].cfg.dreq == dreq && channels[i].complete_at_ns == SIM_WAITING)
+            {
+                ch = (int)i;
+                break;
+            }
+        }
+        if (ch < 0)
+            break;
+
+        sim_dma_channel_t *c = &channels[ch];
+        dma_channel_hw_t *hw = &dma_regs.ch[ch];
+        uint size = element_bytes(&c->cfg);
+
+        while (consumed < count && hw->transfer_count > 0)
+        {
+            uint32_t word = words[consumed++];
+            memcpy((void *)hw->write_addr, &word, size);
+            sniff_bytes((uint)ch, &c->cfg, (const uint8_t *)&word, size);
+            if (c->cfg.write_increment)
+                hw->write_addr += size;
+            hw->transfer_count--;
+            stats.bus_transactions++;
+            stats.bytes += size;
+        }
+
+        if (hw->transfer_count == 0)
+            complete_transfer((uint)ch);
+    }
+
+    return consumed;
+}
+
+// =============================================================================
+// SDK接口
+// =============================================================================
+void dma_channel_set_config(uint channel, const dma_channel_config *config, bool trigger)
+{
+    channels[channel].cfg = *config;
+    if (trigger)
+        start_transfer(channel);
+}
+
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr, bool trigger)
+{
+    dma_regs.ch[channel].read_addr = (uintptr_t)read_addr;
+    if (trigger)
+        start_transfer(channel);
+}
+
+void dma_channel_set_write_addr(uint channel, volatile void *write_addr, bool trigger)
+{
+    dma_regs.ch[channel].write_addr = (uintptr_t)write_addr;
+    if (trigger)
+        start_transfer(channel);
+}
+
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger)
+{
+    channels[channel].reload_count = trans_count;
+    if (!channels[channel].busy)
+        dma_regs.ch[channel].transfer_count = trans_count;
+    if (trigger)
+        start_transfer(channel);
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trigger)
+{
+    dma_channel_set_read_addr(channel, read_addr, false);
+    dma_channel_set_write_addr(channel, write_addr, false);
+    dma_channel_set_trans_count(channel, transfer_count, false);
+    dma_channel_set_config(channel, config, trigger);
+}
+
+void dma_channel_transfer_from_buffer_now(uint channel, const volatile void *read_addr, uint32_t transfer_count)
+{
+    dma_regs.ch[channel].read_addr = (uintptr_t)read_addr;
+    channels[channel].reload_count = transfer_count;
+    start_transfer(channel);
+}
+
+void dma_channel_transfer_to_buffer_now(uint channel, volatile void *write_addr, uint32_t transfer_count)
+{
+    dma_regs.ch[channel].write_addr = (uintptr_t)write_addr;
+    channels[channel].reload_count = transfer_count;
+    start_transfer(channel);
+}
+
+void dma_channel_start(uint channel)
+{
+    start_transfer(channel);
+}
+
+void dma_start_channel_mask(uint32_t chan_mask)
+{
+    for (uint ch = 0; ch < NUM_DMA_CHANNELS; ch++)
+    {
+        if (chan_mask & (1u << ch))
+            start_transfer(ch);
+    }
+}
+
+void dma_channel_abort(uint channel)
+{
+    channels[channel].busy = false;
+    channels[channel].complete_at_ns = 0;
+}
+
+bool dma_channel_is_busy(uint channel)
+{
+    sim_poll();
+    return channels[channel].busy;
+}
+
+void dma_channel_wait_for_finish_blocking(uint channel)
+{
+    while (channels[channel].busy)
+    {
+        if (channels[channel].complete_at_ns != SIM_WAITING)
+        {
+            sim_advance_to_ns(channels[channel].complete_at_ns);
+            sim_poll();
+        }
+        else if (!sim_idle())
+        {
+            panic("DMA channel %u waits for a peripheral that never sends data", channel);
+        }
+    }
+}
+
+void dma_channel_set_irq0_enabled(uint channel, bool enabled)
+{
+    if (enabled)
+        dma_regs.inte0 |= 1u << channel;
+    else
+        dma_regs.inte0 &= ~(1u << channel);
+    update_irq_lines();
+}
+
+void dma_channel_set_irq1_enabled(uint channel, bool enabled)
+{
+    if (enabled)
+        dma_regs.inte1 |= 1u << channel;
+    else
+        dma_regs.inte1 &= ~(1u << channel);
+    update_irq_lines();
+}
+
+bool dma_channel_get_irq0_status(uint channel)
+{
+    return (dma_regs.ints0 >> channel) & 1u;
+}
+
+bool dma_channel_get_irq1_status(uint channel)
+{
+    return (dma_regs.ints1 >> channel) & 1u;
+}
+
+void dma_channel_acknowledge_irq0(uint channel)
+{
+    dma_regs.intr &= ~(1u << channel);
+    dma_regs.ints0 = dma_regs.intr & dma_regs.inte0;
+    dma_regs.ints1 = dma_regs.intr & dma_regs.inte1;
+}
+
+void dma_channel_acknowledge_irq1(uint channel)
+{
+    dma_channel_acknowledge_irq0(channel);
+}
+
+void dma_sniffer_enable(uint channel, uint mode, bool force_channel_enable)
+{
+    sniffer.enabled = true;
+    sniffer.channel = channel;
+    sniffer.mode = mode;
+    if (force_channel_enable)
+        channels[channel].cfg.sniff_enable = true;
+}
+
+void dma_sniffer_disable(void)
+{
+    memset(&sniffer, 0, sizeof(sniffer));
+}
+
+void dma_sniffer_set_byte_swap_enabled(bool swap)
+{
+    (void)swap;
+}
+
+void dma_sniffer_set_output_invert_enabled(bool invert)
+{
+    sniffer.invert = invert;
+}
+
+void dma_sniffer_set_output_reverse_enabled(bool reverse)
+{
+    sniffer.reverse = reverse;
+}
+
+void dma_sniffer_set_data_accumulator(uint32_t seed_value)
+{
+    dma_regs.sniff_data = seed_value;
+}
+
+uint32_t dma_sniffer_get_data_accumulator(void)
+{
+    uint32_t v = dma_regs.sniff_data;
+    if (sniffer.reverse)
+    {
+        uint32_t r = 0;
+        for (int i = 0; i < 32; i++)
+            r |= ((v >> i) & 1u) << (31 - i);
+        v = r;
+    }
+    return sniffer.invert ? ~v : v;
+}
@@ -0,0 +1,172 @@
+// =============================================================================
+// 主机模拟HAL控制接口
+//
+// host/include 下的头文件以Pico SDK的接口形式提供 DMA/SPI/PIO/定时器/GPIO，
+// 使 lcd_framebuffer.c、spi_lcd.c、lcd_st75320.c、frame_stats.c 可以不做修改
+// 地编译成Linux程序。本头文件只给主机程序(lcd_host.c等)使用：驱动模拟时钟、
+// 注入X3501捕获数据、读取总线计数器。
+//
+// 模拟时钟 = 主机单调时钟(REAL模式) + 累计的模拟等待时间。
+// SPI/DMA传输不真正等待，而是按波特率计算总线占用时间并推进模拟时钟，
+// 因此frame_stats中的"转换时间"是真实CPU耗时，"传输时间"是模拟总线时间。
+// =============================================================================
+#ifndef SIM_HAL_H
+#define SIM_HAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "pico.h"
+#include "hardware/pio.h"
+#include "hardware/spi.h"
+
+typedef enum {
+    SIM_TIME_REAL = 0,    // 模拟时钟包含主机真实耗时 (用于性能剖析)
+    SIM_TIME_VIRTUAL = 1  // 只有模拟等待推进时钟 (结果可重复)
+} sim_time_mode_t;
+
+// 初始化/复位整个模拟环境 (时钟、中断、DMA、SPI、PIO、GPIO)
+void sim_init(sim_time_mode_t mode);
+
+// -----------------------------------------------------------------------------
+// 模拟时钟与事件
+// -----------------------------------------------------------------------------
+uint64_t sim_now_ns(void);
+void sim_advance_ns(uint64_t ns);
+void sim_advance_to_ns(uint64_t t_ns);
+
+typedef void (*sim_event_fn)(void *ctx);
+
+// 在模拟时间 at_ns 执行回调 (在 sim_poll 中触发，与中断同级)
+bool sim_schedule(uint64_t at_ns, sim_event_fn fn, void *ctx);
+void sim_cancel(sim_event_fn fn, void *ctx);
+
+// 处理所有已到期的事件(DMA完成、定时事件)并分发挂起中断
+void sim_poll(void);
+
+// 空闲：把时钟推进到下一个待处理事件并处理它。没有事件时返回false
+bool sim_idle(void);
+
+// -----------------------------------------------------------------------------
+// 中断
+// -----------------------------------------------------------------------------
+void sim_irq_set_pending(uint num);
+bool sim_irq_masked(void);
+// 中断从挂起到开始执行的延迟 (模拟其它中断/关中断造成的响应延迟，默认0)
+void sim_irq_set_latency_ns(uint64_t ns);
+
+// -----------------------------------------------------------------------------
+// GPIO (外部输入电平)
+// -----------------------------------------------------------------------------
+void sim_gpio_set_input(uint gpio, bool level);
+// 周期脉冲 (从first_rise_ns起每period_ns一个上升沿，高电平high_ns)，例如ST7789的TE输出
+void sim_gpio_start_pulses(uint gpio, uint64_t first_rise_ns, uint64_t period_ns, uint64_t high_ns);
+void sim_gpio_stop_pulses(void);
+
+// -----------------------------------------------------------------------------
+// SPI 计数器
+// -----------------------------------------------------------------------------
+typedef struct {
+    uint64_t bytes;          // 线上字节数
+    uint64_t transactions;   // spi_write_blocking 调用 + DMA 传输次数
+    uint64_t dma_transfers;  // 其中由DMA完成的传输次数
+    uint64_t bus_time_ns;    // 总线占用时间
+} sim_spi_stats_t;
+
+// 每次线上传输的观察回调 (data_bits为8或16，len为帧数)
+typedef void (*sim_spi_sink_fn)(void *ctx, const void *data, size_t len, uint data_bits);
+
+void sim_spi_get_stats(spi_inst_t *spi, sim_spi_stats_t *stats);
+void sim_spi_reset_stats(spi_inst_t *spi);
+void sim_spi_set_sink(spi_inst_t *spi, sim_spi_sink_fn fn, void *ctx);
+
+// 计算在spi上传输nbytes所需的总线时间，并返回完成时刻 (供DMA模拟使用)
+uint64_t sim_spi_transfer(spi_inst_t *spi, const void *data, size_t frames, uint frame_bytes, bool from_dma);
+
+// -----------------------------------------------------------------------------
+// DMA 计数器
+// -----------------------------------------------------------------------------
+typedef struct {
+    uint64_t transfers;         // 完成的传输次数
+    uint64_t bus_transactions;  // 总线事务数 (每个元素一次)
+    uint64_t bytes;             // 搬运字节数
+} sim_dma_stats_t;
+
+void sim_dma_get_stats(sim_dma_stats_t *stats);
+void sim_dma_reset_stats(void);
+void sim_dma_reset(void);
+void sim_dma_poll(uint64_t now_ns);
+uint64_t sim_dma_next_completion_ns(void);
+
+// 由外设(PIO RX)按DREQ向正在等待的DMA通道送数据，返回被接收的字数
+uint sim_dma_feed(uint dreq, const uint32_t *words, uint count);
+
+// -----------------------------------------------------------------------------
+// PIO
+// -----------------------------------------------------------------------------
+// 状态机向RX FIFO推送数据 (若有DMA通道在等待该DREQ则直接搬运)
+uint sim_pio_rx_push(PIO pio, uint sm, const uint32_t *words, uint count);
+// 置位PIO中断标志 (等价于程序中的 "irq n")
+void sim_pio_raise_irq(PIO pio, uint irq_flag);
+// FRAME边沿：使能且在等待FRAME的状态机开始接收数据
+void sim_pio_frame_edge(PIO pio);
+// DMA通道开始等待某DREQ时由DMA模型调用，用于排空RX FIFO
+void sim_pio_dma_ready(uint dreq);
+bool sim_pio_sm_enabled(PIO pio, uint sm);
+uint64_t sim_pio_rx_overflows(PIO pio, uint sm);
+void sim_pio_reset(void);
+// 输出程序：TX DREQ判断；把写入TX FIFO的字交给指令解释器执行，返回最后一位移出的时刻
+bool sim_pio_is_tx_dreq(uint dreq);
+uint64_t sim_pio_tx_transfer(uint dreq, const uint32_t *words, uint count, bool from_dma);
+// 状态机驱动的引脚电平 (引脚功能切换给该PIO时 gpio_get 读到的值)
+bool sim_pio_pin_level(uint pio_index, uint pin);
+
+// PIO接管SPI引脚时的线路解码 (由 sim_pio.c 和 gpio_set_function 调用)
+void sim_spi_pin_function(uint gpio, enum gpio_function fn);
+void sim_spi_pio_pins(uint64_t levels);
+void sim_spi_pio_done(uint64_t duration_ns, bool from_dma);
+
+void sim_spi_reset(void);
+void sim_gpio_reset(void);
+
+// -----------------------------------------------------------------------------
+// X3501 LCD 信号源模型
+//
+// 每帧：FRAME边沿(capture状态机的"irq 0") -> 逐行推送采样字 (每行240位，
+// 按32位自动推送对齐) -> 最后一行结束后等到下一个帧周期。
+// -----------------------------------------------------------------------------
+#define SIM_X3501_FRAME_BYTES 7200
+#define SIM_X3501_LINES 240
+
+// 提供第index帧的数据；返回false表示信号源结束。
+// period_us 可被回调改写为本帧到下一帧FRAME边沿的间隔 (回放原始时序)。
+typedef bool (*sim_x3501_frame_fn)(void *ctx, uint32_t index, uint8_t *frame, uint32_t *period_us);
+
+// 信号故障：第index帧的LINECLK数和一行的DATACLK数 (回调只需改写要注入的字段)
+typedef struct {
+    uint32_t lines;            // 本帧行数 (正常240)
+    uint32_t bad_line;         // 时钟数异常的行号 (UINT32_MAX = 没有)
+    uint32_t bad_line_clocks;  // 该行的DATACLK数 (正常60)
+} sim_x3501_fault_t;
+
+typedef void (*sim_x3501_fault_fn)(void *ctx, uint32_t index, sim_x3501_fault_t *fault);
+
+typedef struct {
+    PIO pio;
+    uint sm;
+    uint32_t frame_period_us;  // FRAME到下一次FRAME
+    uint32_t active_us;        // FRAME到最后一行数据推送完成
+    sim_x3501_frame_fn next_frame;
+    sim_x3501_fault_fn fault;  // 可为NULL
+    void *ctx;
+    PIO monitor_pio;           // 帧完整性监视状态机 (NULL = 不模拟)
+    uint line_sm;              // lcd_line_monitor
+    uint clock_sm;             // lcd_dataclk_monitor
+} sim_x3501_config_t;
+
+void sim_x3501_start(const sim_x3501_config_t *config);
+void sim_x3501_stop(void);
+bool sim_x3501_running(void);
+uint32_t sim_x3501_frames_sent(void);
+
+#endif // SIM_HAL_H
@@ -0,0 +1,739 @@
+// =============================================================================
+// 主机模拟HAL：PIO
+//
+// 输入 (捕获) 程序不解释指令，只模拟程序存储分配、状态机使能/重启、RX FIFO与中断标志。
+// 捕获类程序(lcd_capture)都从"等待FRAME"开始：状态机使能、restart或被exec
+// 跳转后会丢弃数据，直到信号源模型调用 sim_pio_frame_edge。
+//
+// 输出程序 (由TX FIFO驱动，如 st7789_expand) 按指令解释执行：DMA/CPU写入TX FIFO的字
+// 交给解释器一直执行到状态机在空FIFO的pull上停住，引脚波形交给 sim_spi_pio_pins 解码，
+// 按执行的周期数和分频计算总线时间。不支持wait和自动推送。
+// =============================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico.h"
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/clocks.h"
+#include "sim_hal.h"
+
+#define SIM_RX_FIFO_MAX 8
+
+typedef struct {
+    bool claimed;
+    bool enabled;
+    bool waiting_frame;
+    uint8_t pc;
+    pio_sm_config config;
+    uint32_t rx_fifo[SIM_RX_FIFO_MAX];
+    uint rx_head;
+    uint rx_count;
+    uint64_t rx_overflows;
+
+    // 指令解释 (输出程序)
+    uint32_t x, y, isr, osr;
+    uint8_t isr_count;      // 已移入ISR的位数
+    uint8_t osr_count;      // 已从OSR移出的位数 (32 = 空)
+    uint64_t busy_until_ns; // 最后一位移出的时刻
+    uint32_t tx_fifo[4];    // 状态机停止时写入的字 (使能后先被pull取走)
+    uint tx_count;
+} sim_pio_sm_t;
+
+typedef struct {
+    uint32_t used_instructions; // 指令存储占用位图
+    uint16_t instr_mem[PIO_INSTRUCTION_COUNT];
+    uint64_t pin_levels;        // 状态机驱动的引脚电平
+    sim_pio_sm_t sm[NUM_PIO_STATE_MACHINES];
+} sim_pio_t;
+
+static pio_hw_t pio_regs[NUM_PIOS];
+pio_hw_t *const pio0 = &pio_regs[0];
+pio_hw_t *const pio1 = &pio_regs[1];
+pio_hw_t *const pio2 = &pio_regs[2];
+
+static sim_pio_t pio_state[NUM_PIOS];
+
+static inline sim_pio_sm_t *sm_state(PIO pio, uint sm)
+{
+    return &pio_state[pio_get_index(pio)].sm[sm];
+}
+
+static inline uint rx_fifo_depth(const sim_pio_sm_t *s)
+{
+    return s->config.fifo_join == PIO_FIFO_JOIN_RX ? 8 : 4;
+}
+
+void sim_pio_reset(void)
+{
+    memset(pio_regs, 0, sizeof(pio_regs));
+    memset(pio_state, 0, sizeof(pio_state));
+}
+
+uint pio_get_index(PIO pio)
+{
+    return (uint)(pio - pio_regs);
+}
+
+uint pio_get_dreq(PIO pio, uint sm, bool is_tx)
+{
+    uint base = pio_get_index(pio) * 8;
+    return base + (is_tx ? 0 : 4) + sm;
+}
+
+// =============================================================================
+// 程序存储与状态机分配
+// =============================================================================
+static int find_offset(PIO pio, const pio_program_t *program)
+{
+    uint32_t used = pio_state[pio_get_index(pio)].used_instructions;
+    uint32_t mask = (program->length >= 32) ? 0xffffffffu : ((1u << program->length) - 1u);
+
+    if (program->origin >= 0)
+    {
+        uint off = (uint)program->origin;
+        if (off + program->length > PIO_INSTRUCTION_COUNT || (used & (mask << off)))
+            return -1;
+        return (int)off;
+    }
+    // SDK从高地址向低地址分配
+    for (int off = PIO_INSTRUCTION_COUNT - program->length; off >= 0; off--)
+    {
+        if (!(used & (mask << off)))
+            return off;
+    }
+    return -1;
+}
+
+bool pio_can_add_program(PIO pio, const pio_program_t *program)
+{
+    return find_offset(pio, program) >= 0;
+}
+
+uint pio_add_program(PIO pio, const pio_program_t *program)
+{
+    int off = find_offset(pio, program);
+    if (off < 0)
+        panic("No program space");
+    uint32_t mask = (program->length >= 32) ? 0xffffffffu : ((1u << program->length) - 1u);
+    sim_pio_t *p = &pio_state[pio_get_index(pio)];
+    p->used_instructions |= mask << off;
+    // 与SDK一致：JMP目标地址按装载位置重定位
+    for (uint i = 0; i < program->length; i++)
+    {
+        uint16_t instr = program->instructions[i];
+        p->instr_mem[off + i] = (instr & 0xe000u) == 0 ? (uint16_t)(instr + off) : instr;
+    }
+    return (uint)off;
+}
+
+void pio_remove_program(PIO pio, const pio_program_t *program, uint loaded_offset)
+{
+    uint32_t mask = (program->length >= 32) ? 0xffffffffu : ((1u << program->length) - 1u);
+    pio_state[pio_get_index(pio)].used_instructions &= ~(mask << loaded_offset);
+}
+
+int pio_claim_unused_sm(PIO pio, bool required)
+{
+    for (uint sm = 0; sm < NUM_PIO_STATE_MACHINES; sm++)
+    {
+        if (!sm_state(pio, sm)->claimed)
+        {
+            sm_state(pio, sm)->claimed = true;
+            return (int)sm;
+        }
+    }
+    if (required)
+        panic("No PIO state machines are available");
+    return -1;
+}
+
+void pio_sm_claim(PIO pio, uint sm)
+{
+    if (sm_state(pio, sm)->claimed)
+        panic("PIO %u SM %u is already claimed", pio_get_index(pio), sm);
+    sm_state(pio, sm)->claimed = true;
+}
+
+void pio_sm_unclaim(PIO pio, uint sm)
+{
+    sm_state(pio, sm)->claimed = false;
+}
+
+bool pio_claim_free_sm_and_add_program(const pio_program_t *program, PIO *pio, uint *sm, uint *offset)
+{
+    for (uint i = 0; i < NUM_PIOS; i++)
+    {
+        PIO candidate = &pio_regs[i];
+        if (!pio_can_add_program(candidate, program))
+            continue;
+        int claimed = pio_claim_unused_sm(candidate, false);
+        if (claimed < 0)
+            continue;
+        *pio = candidate;
+        *sm = (uint)claimed;
+        *offset = pio_add_program(candidate, program);
+        return true;
+    }
+    return false;
+}
+
+void pio_gpio_init(PIO pio, uint pin)
+{
+    gpio_set_function(pin, (enum gpio_function)(GPIO_FUNC_PIO0 + pio_get_index(pio)));
+}
+
+int pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint pin_base, uint pin_count, bool is_out)
+{
+    (void)pio;
+    (void)sm;
+    (void)pin_base;
+    (void)pin_count;
+    (void)is_out;
+    return 0;
+}
+
+void pio_sm_set_pins_with_mask(PIO pio, uint sm, uint32_t pin_values, uint32_t pin_mask)
+{
+    (void)sm;
+    sim_pio_t *p = &pio_state[pio_get_index(pio)];
+    p->pin_levels = (p->pin_levels & ~(uint64_t)pin_mask) | (pin_values & pin_mask);
+}
+
+void pio_sm_set_pindirs_with_mask(PIO pio, uint sm, uint32_t pin_dirs, uint32_t pin_mask)
+{
+    (void)pio;
+    (void)sm;
+    (void)pin_dirs;
+    (void)pin_mask;
+}
+
+// =============================================================================
+// 状态机控制
+// =============================================================================
+int pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config *config)
+{
+    sim_pio_sm_t *s = sm_state(pio, sm);
+    s->enabled = false;
+    s->config = *config;
+    s->pc = (uint8_t)initial_pc;
+    s->rx_count = 0;
+    s->rx_head = 0;
+    s->waiting_frame = true;
+    s->x = s->y = s->isr = s->osr = 0;
+    s->isr_count = 0;
+    s->osr_count = 32;
+    s->busy_until_ns = 0;
+    s->tx_count = 0;
+    return 0;
+}
+
+void pio_sm_set_config(PIO pio, uint sm, const pio_sm_config *config)
+{
+    sm_state(pio, sm)->config = *config;
+}
+
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled)
+{
+    sim_pio_sm_t *s = sm_state(pio, sm);
+    if (enabled && !s->enabled)
+        s->waiting_frame = true;
+    s->enabled = enabled;
+}
+
+void pio_sm_restart(PIO pio, uint sm)
+{
+    sm_state(pio, sm)->waiting_frame = true;
+}
+
+void pio_sm_clear_fifos(PIO pio, uint sm)
+{
+    sim_pio_sm_t *s = sm_state(pio, sm);
+    s->rx_count = 0;
+    s->rx_head = 0;
+    s->tx_count = 0;
+}
+
+void pio_sm_exec(PIO pio, uint sm, uint instr)
+{
+    sim_pio_sm_t *s = sm_state(pio, sm);
+    // 只模拟无条件跳转 (恢复流程中用于回到程序入口)
+    if ((instr & 0xe0e0u) == 0x0000u)
+    {
+        s->pc = (uint8_t)(instr & 0x1fu);
+        s->waiting_frame = true;
+    }
+}
+
+void pio_sm_set_clkdiv(PIO pio, uint sm, float div)
+{
+    sm_state(pio, sm)->config.clkdiv = div;
+}
+
+uint8_t pio_sm_get_pc(PIO pio, uint sm)
+{
+    return sm_state(pio, sm)->pc;
+}
+
+uint pio_sm_get_rx_fifo_level(PIO pio, uint sm)
+{
+    return sm_state(pio, sm)->rx_count;
+}
+
+bool pio_sm_is_rx_fifo_empty(PIO pio, uint sm)
+{
+    return sm_state(pio, sm)->rx_count == 0;
+}
+
+bool pio_sm_is_tx_fifo_empty(PIO pio, uint sm)
+{
+    // 解释器一次执行完交给它的字，最后一位移出之前FIFO视为非空
+    return sim_now_ns() >= sm_state(pio, sm)->busy_until_ns;
+}
+
+uint32_t pio_sm_get(PIO pio, uint sm)
+{
+    sim_pio_sm_t *s = sm_state(pio, sm);
+    if (s->rx_count == 0)
+        return 0;
+    uint32_t v = s->rx_fifo[s->rx_head];
+    s->rx_head = (s->rx_head + 1) % SIM_RX_FIFO_MAX;
+    s->rx_count--;
+    return v;
+}
+
+uint32_t pio_sm_get_blocking(PIO pio, uint sm)
+{
+    while (pio_sm_is_rx_fifo_empty(pio, sm))
+    {
+        if (!sim_idle())
+            panic("pio_sm_get_blocking: PIO %u SM %u never produces data", pio_get_index(pio), sm);
+    }
+    return pio_sm_get(pio, sm);
+}
+
+void pio_sm_put(PIO pio, uint sm, uint32_t data)
+{
+    sim_pio_tx_transfer(pio_get_dreq(pio, sm, true), &data, 1, false);
+}
+
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data)
+{
+    pio_sm_put(pio, sm, data);
+}
+
+// =============================================================================
+// 中断标志
+// =============================================================================
+void pio_interrupt_clear(PIO pio, uint pio_interrupt_num)
+{
+    pio->irq &= ~(1u << pio_interrupt_num);
+}
+
+bool pio_interrupt_get(PIO pio, uint pio_interrupt_num)
+{
+    return (pio->irq >> pio_interrupt_num) & 1u;
+}
+
+void pio_set_irq0_source_enabled(PIO pio, enum pio_interrupt_source source, bool enabled)
+{
+    if (enabled)
+        pio->inte0 |= 1u << source;
+    else
+        pio->inte0 &= ~(1u << source);
+}
+
+void sim_pio_raise_irq(PIO pio, uint irq_flag)
+{
+    pio->irq |= 1u << irq_flag;
+    if (pio->inte0 & (1u << (pis_interrupt0 + irq_flag)))
+        sim_irq_set_pending(PIO0_IRQ_0 + 2 * pio_get_index(pio));
+}
+
+// =============================================================================
+// 数据通路
+// =============================================================================
+static void rx_fifo_push(sim_pio_sm_t *s, uint32_t word)
+{
+    if (s->rx_count >= rx_fifo_depth(s))
+    {
+        s->rx_overflows++;
+        return;
+    }
+    s->rx_fifo[(s->rx_head + s->rx_count) % SIM_RX_FIFO_MAX] = word;
+    s->rx_count++;
+}
+
+uint sim_pio_rx_push(PIO pio, uint sm, const uint32_t *words, uint count)
+{
+    sim_pio_sm_t *s = sm_state(pio, sm);
+    if (!s->enabled || s->waiting_frame)
+        return 0;
+
+    // 先排空FIFO中的旧数据，保持顺序
+    uint dreq = pio_get_dreq(pio, sm, false);
+    while (s->rx_count > 0)
+    {
+        uint32_t w = s->rx_fifo[s->rx_head];
+        if (sim_dma_feed(dreq, &w, 1) == 0)
+            break;
+        s->rx_head = (s->rx_head + 1) % SIM_RX_FIFO_MAX;
+        s->rx_count--;
+    }
+
+    uint fed = (s->rx_count == 0) ? sim_dma_feed(dreq, words, count) : 0;
+    for (uint i = fed; i < count; i++)
+        rx_fifo_push(s, words[i]);
+    return count;
+}
+
+void sim_pio_dma_ready(uint dreq)
+{
+    if (dreq >= NUM_PIOS * 8 || (dreq & 4u) == 0)
+        return;
+    sim_pio_sm_t *s = &pio_state[dreq / 8].sm[dreq & 3u];
+    while (s->rx_count > 0)
+    {
+        uint32_t w = s->rx_fifo[s->rx_head];
+        if (sim_dma_feed(dreq, &w, 1) == 0)
+            break;
+        s->rx_head = (s->rx_head + 1) % SIM_RX_FIFO_MAX;
+        s->rx_count--;
+    }
+}
+
+void sim_pio_frame_edge(PIO pio)
+{
+    for (uint sm = 0; sm < NUM_PIO_STATE_MACHINES; sm++)
+    {
+        if (pio_state[pio_get_index(pio)].sm[sm].enabled)
+            pio_state[pio_get_index(pio)].sm[sm].waiting_frame = false;
+    }
+}
+
+bool sim_pio_sm_enabled(PIO pio, uint sm)
+{
+    return sm_state(pio, sm)->enabled;
+}
+
+uint64_t sim_pio_rx_overflows(PIO pio, uint sm)
+{
+    return sm_state(pio, sm)->rx_overflows;
+}
+
+// =============================================================================
+// 输出程序的指令解释
+// =============================================================================
+static inline uint32_t pull_threshold(const sim_pio_sm_t *s)
+{
+    return s->config.out_pull_threshold ? s->config.out_pull_threshold : 32;
+}
+
+static void drive_pins(sim_pio_t *p, uint base, uint count, uint32_t value)
+{
+    for (uint i = 0; i < count; i++)
+    {
+        uint pin = (base + i) % 32;
+        if ((value >> i) & 1u)
+            p->pin_levels |= 1ull << pin;
+        else
+            p->pin_levels &= ~(1ull << pin);
+    }
+}
+
+static uint32_t shift_out(sim_pio_sm_t *s, uint count)
+{
+    uint32_t data;
+    if (s->config.out_shift_right)
+    {
+        data = count == 32 ? s->osr : s->osr & ((1u << count) - 1u);
+        s->osr = count == 32 ? 0 : s->osr >> count;
+    }
+    else
+    {
+        data = s->osr >> (32 - count);
+        s->osr = count == 32 ? 0 : s->osr << count;
+    }
+    s->osr_count = (uint8_t)(s->osr_count + count > 32 ? 32 : s->osr_count + count);
+    return data;
+}
+
+static void shift_in(sim_pio_sm_t *s, uint32_t data, uint count)
+{
+    uint32_t bits = count == 32 ? data : data & ((1u << count) - 1u);
+    if (s->config.in_shift_right)
+        s->isr = count == 32 ? bits : (s->isr >> count) | (bits << (32 - count));
+    else
+        s->isr = count == 32 ? bits : (s->isr << count) | bits;
+    s->isr_count = (uint8_t)(s->isr_count + count > 32 ? 32 : s->isr_count + count);
+}
+
+typedef struct {
+    const uint32_t *words;
+    uint count;
+    uint next;
+} tx_queue_t;
+
+static uint32_t mov_source(PIO pio, sim_pio_sm_t *s, const tx_queue_t *tx, uint src)
+{
+    sim_pio_t *p = &pio_state[pio_get_index(pio)];
+    switch (src)
+    {
+    case 0: return (uint32_t)(p->pin_levels >> s->config.in_base);
+    case 1: return s->x;
+    case 2: return s->y;
+    case 3: return 0;
+    case 5:
+        // STATUS：只模拟TX FIFO级别 (还没被取走的字数视为FIFO级别)
+        if (s->config.status_sel != STATUS_TX_LESSTHAN)
+            panic("PIO STATUS source %u is not simulated", s->config.status_sel);
+        return (tx->count - tx->next < s->config.status_n) ? 0xffffffffu : 0;
+    case 6: return s->isr;
+    case 7: return s->osr;
+    default: return 0;
+    }
+}
+
+static uint32_t reverse_bits(uint32_t v)
+{
+    uint32_t r = 0;
+    for (int i = 0; i < 32; i++)
+        r |= ((v >> i) & 1u) << (31 - i);
+    return r;
+}
+
+// 执行到状态机在空TX FIFO上停住，返回执行的周期数
+static uint64_t exec_until_stall(PIO pio, uint sm, tx_queue_t *tx)
+{
+    sim_pio_t *p = &pio_state[pio_get_index(pio)];
+    sim_pio_sm_t *s = &p->sm[sm];
+    uint64_t cycles = 0;
+
+    for (;;)
+    {
+        uint16_t instr = p->instr_mem[s->pc];
+        uint delay_side = (instr >> 8) & 0x1fu;
+        uint side_bits = s->config.sideset_bits;
+        uint delay_bits = 5 - side_bits;
+
+        // side-set在指令开始时生效 (停住的指令也一样)
+        if (side_bits > 0)
+        {
+            uint value = delay_side >> delay_bits;
+            uint pins = side_bits;
+            bool enabled = true;
+            if (s->config.sideset_optional)
+            {
+                pins--;
+                enabled = (value >> pins) & 1u;
+                value &= (1u << pins) - 1u;
+            }
+            if (enabled && !s->config.sideset_pindirs)
+                drive_pins(p, s->config.sideset_base, pins, value);
+        }
+        uint delay = delay_side & ((1u << delay_bits) - 1u);
+
+        bool jumped = false;
+        bool stalled = false;
+        uint op = (instr >> 5) & 7u;
+        uint arg = instr & 0x1fu;
+
+        switch (instr >> 13)
+        {
+        case 0: // JMP
+        {
+            bool take;
+            switch (op)
+            {
+            case 0: take = true; break;
+            case 1: take = s->x == 0; break;
+            case 2: take = s->x != 0; s->x--; break;
+            case 3: take = s->y == 0; break;
+            case 4: take = s->y != 0; s->y--; break;
+            case 5: take = s->x != s->y; break;
+            case 6: take = gpio_get(s->config.jmp_pin); break;
+            default: take = s->osr_count < pull_threshold(s); break; // !OSRE
+            }
+            if (take)
+            {
+                s->pc = (uint8_t)arg;
+                jumped = true;
+            }
+            break;
+        }
+        case 2: // IN
+            shift_in(s, mov_source(pio, s, tx, op), arg ? arg : 32);
+            break;
+        case 3: // OUT
+        {
+            uint count = arg ? arg : 32;
+            if (s->config.out_autopull && s->osr_count >= pull_threshold(s))
+            {
+                if (tx->next >= tx->count)
+                {
+                    stalled = true;
+                    break;
+                }
+                s->osr = tx->words[tx->next++];
+                s->osr_count = 0;
+            }
+            uint32_t data = shift_out(s, count);
+            switch (op)
+            {
+            case 0: drive_pins(p, s->config.out_base, s->config.out_count, data); break;
+            case 1: s->x = data; break;
+            case 2: s->y = data; break;
+            case 5: s->pc = (uint8_t)(data & 0x1fu); jumped = true; break;
+            case 6: s->isr = data; s->isr_count = (uint8_t)count; break;
+            case 3: case 4: break; // null, pindirs
+            default: panic("PIO OUT EXEC is not simulated");
+            }
+            break;
+        }
+        case 4: // PUSH/PULL/MOV RX FIFO
+            if ((instr & 0x0010u) && (instr & 0x0080u))
+            {
+                // mov osr, rxfifo[y|index]：不改变OSR移位计数
+                uint index = (instr & 0x0008u) ? (instr & 3u) : (s->y & 3u);
+                s->osr = pio->rxf_putget[sm][index];
+            }
+            else if (instr & 0x0010u)
+            {
+                pio->rxf_putget[sm][(instr & 0x0008u) ? (instr & 3u) : (s->y & 3u)] = s->isr;
+            }
+            else if (instr & 0x0080u)
+            {
+                bool if_empty = instr & 0x0040u;
+                bool block = instr & 0x0020u;
+                if (if_empty && s->osr_count < pull_threshold(s))
+                    break;
+                if (tx->next < tx->count)
+                {
+                    s->osr = tx->words[tx->next++];
+                    s->osr_count = 0;
+                }
+                else if (block)
+                {
+                    stalled = true;
+                }
+                else
+                {
+                    s->osr = s->x;
+                    s->osr_count = 0;
+                }
+            }
+            else
+            {
+                rx_fifo_push(s, s->isr);
+                s->isr = 0;
+                s->isr_count = 0;
+            }
+            break;
+        case 5: // MOV
+        {
+            uint32_t v = mov_source(pio, s, tx, arg & 7u);
+            uint mov_op = (arg >> 3) & 3u;
+            if (mov_op == 1)
+                v = ~v;
+            else if (mov_op == 2)
+                v = reverse_bits(v);
+            switch (op)
+            {
+            case 0: drive_pins(p, s->config.out_base, s->config.out_count, v); break;
+            case 1: s->x = v; break;
+            case 2: s->y = v; break;
+            case 5: s->pc = (uint8_t)(v & 0x1fu); jumped = true; break;
+            case 6: s->isr = v; s->isr_count = 0; break;
+            case 7: s->osr = v; s->osr_count = 0; break;
+            case 3: break; // pindirs
+            default: panic("PIO MOV EXEC is not simulated");
+            }
+            break;
+        }
+        case 6: // IRQ
+            if (op & 2u)
+                pio->irq &= ~(1u << (arg & 7u));
+            else if (op & 1u)
+                panic("PIO IRQ WAIT is not simulated");
+            else
+                sim_pio_raise_irq(pio, arg & 7u);
+            break;
+        case 7: // SET
+            switch (op)
+            {
+            case 0: drive_pins(p, s->config.set_base, s->config.set_count, arg); break;
+            case 1: s->x = arg; break;
+            case 2: s->y = arg; break;
+            default: break; // pindirs
+            }
+            break;
+        default:
+            panic("PIO WAIT is not simulated for output programs");
+        }
+
+        sim_spi_pio_pins(p->pin_levels);
+        if (stalled)
+            break;
+
+        cycles += 1 + delay;
+        if (!jumped)
+            s->pc = (s->pc == s->config.wrap) ? (uint8_t)s->config.wrap_target : (uint8_t)(s->pc + 1);
+    }
+    return cycles;
+}
+
+bool sim_pio_pin_level(uint pio_index, uint pin)
+{
+    return (pio_state[pio_index].pin_levels >> pin) & 1u;
+}
+
+// 最后一位移出后状态机停在pull上：置位FDEBUG.TXSTALL
+static void tx_stall_event(void *ctx)
+{
+    for (uint i = 0; i < NUM_PIOS; i++)
+        for (uint sm = 0; sm < NUM_PIO_STATE_MACHINES; sm++)
+            if (&pio_state[i].sm[sm] == ctx)
+                pio_regs[i].fdebug |= 1u << (PIO_FDEBUG_TXSTALL_LSB + sm);
+}
+
+bool sim_pio_is_tx_dreq(uint dreq)
+{
+    return dreq < NUM_PIOS * 8 && (dreq & 4u) == 0;
+}
+
+uint64_t sim_pio_tx_transfer(uint dreq, const uint32_t *words, uint count, bool from_dma)
+{
+    PIO pio = &pio_regs[dreq / 8];
+    uint sm = dreq & 3u;
+    sim_pio_sm_t *s = sm_state(pio, sm);
+    uint64_t now = sim_now_ns();
+    if (!s->enabled)
+    {
+        // 状态机停止：字留在TX FIFO里 (满了以后的写入丢弃)
+        for (uint i = 0; i < count && s->tx_count < 4; i++)
+            s->tx_fifo[s->tx_count++] = words[i];
+        return now;
+    }
+
+    uint32_t *queued = malloc(((size_t)s->tx_count + count) * sizeof(uint32_t));
+    memcpy(queued, s->tx_fifo, s->tx_count * sizeof(uint32_t));
+    memcpy(queued + s->tx_count, words, count * sizeof(uint32_t));
+    tx_queue_t tx = {.words = queued, .count = s->tx_count + count, .next = 0};
+    s->tx_count = 0;
+
+    uint64_t start = s->busy_until_ns > now ? s->busy_until_ns : now;
+    uint64_t cycles = exec_until_stall(pio, sm, &tx);
+    free(queued);
+    if (tx.next < tx.count)
+        panic("PIO %u SM %u stopped consuming TX data", dreq / 8, sm);
+
+    float div = s->config.clkdiv < 1.0f ? 1.0f : s->config.clkdiv;
+    uint64_t duration = (uint64_t)((double)cycles * div * 1e9 / SIM_CLK_SYS_HZ + 0.5);
+    s->busy_until_ns = start + duration;
+    sim_spi_pio_done(duration, from_dma);
+
+    sim_cancel(tx_stall_event, s);
+    sim_schedule(s->busy_until_ns, tx_stall_event, s);
+    return s->busy_until_ns;
+}
@@ -0,0 +1,235 @@
+// =============================================================================
+// 主机模拟HAL：SPI控制器 (PL022)
+//
+// 不产生真实波形，只按波特率累计总线时间、统计字节数与事务数。
+// 波特率分频算法与SDK的spi_set_baudrate一致 (clk_peri = 150MHz)。
+// SCK引脚切换给PIO时改为解码PIO驱动的引脚电平 (SPI模式0，SCK上升沿采样MOSI，MSB先)，
+// 解码出的字节同样计入统计，并在第8个SCK上升沿逐字节交给sink (此时sink读到的D/C电平
+// 就是LCD锁存的电平)，上层看到的总线与SPI控制器发送时一致。
+// =============================================================================
+#include <stdio.h>
+#include <string.h>
+#include "pico.h"
+#include "hardware/spi.h"
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "sim_hal.h"
+
+#define SIM_CLK_PERI_HZ 150000000u
+
+struct spi_inst {
+    spi_hw_t hw;
+    uint index;
+    uint baudrate;
+    uint data_bits;
+    uint64_t busy_until_ns;
+    sim_spi_stats_t stats;
+    sim_spi_sink_fn sink;
+    void *sink_ctx;
+
+    // PIO驱动的线路解码
+    int pio_sck;            // SCK引脚 (-1 = 由SPI控制器驱动)
+    bool last_sck;
+    uint8_t shift;
+    uint8_t shift_bits;
+};
+
+static struct spi_inst spi_instances[2] = {{.index = 0, .pio_sck = -1}, {.index = 1, .pio_sck = -1}};
+spi_inst_t *const spi0 = &spi_instances[0];
+spi_inst_t *const spi1 = &spi_instances[1];
+
+void sim_spi_reset(void)
+{
+    for (uint i = 0; i < 2; i++)
+    {
+        memset(&spi_instances[i], 0, sizeof(spi_instances[i]));
+        spi_instances[i].index = i;
+        spi_instances[i].data_bits = 8;
+        spi_instances[i].pio_sck = -1;
+    }
+}
+
+void sim_spi_get_stats(spi_inst_t *spi, sim_spi_stats_t *stats)
+{
+    *stats = spi->stats;
+}
+
+void sim_spi_reset_stats(spi_inst_t *spi)
+{
+    memset(&spi->stats, 0, sizeof(spi->stats));
+}
+
+void sim_spi_set_sink(spi_inst_t *spi, sim_spi_sink_fn fn, void *ctx)
+{
+    spi->sink = fn;
+    spi->sink_ctx = ctx;
+}
+
+uint64_t sim_spi_transfer(spi_inst_t *spi, const void *data, size_t frames, uint frame_bytes, bool from_dma)
+{
+    (void)frame_bytes;
+    uint64_t now = sim_now_ns();
+    uint64_t start = spi->busy_until_ns > now ? spi->busy_until_ns : now;
+    uint64_t bits = (uint64_t)frames * spi->data_bits;
+    uint64_t duration = spi->baudrate ? (bits * 1000000000ull + spi->baudrate - 1) / spi->baudrate : 0;
+
+    spi->busy_until_ns = start + duration;
+    spi->stats.bytes += bits / 8;
+    spi->stats.transactions++;
+    spi->stats.bus_time_ns += duration;
+    if (from_dma)
+        spi->stats.dma_transfers++;
+
+    if (spi->sink)
+        spi->sink(spi->sink_ctx, data, frames, spi->data_bits);
+
+    return spi->busy_until_ns;
+}
+
+// =============================================================================
+// PIO驱动的线路解码
+// =============================================================================
+// SPI功能的引脚编号规律：SCK = 4n+2，TX = 4n+3，每8个引脚在SPI0/SPI1之间交替
+void sim_spi_pin_function(uint gpio, enum gpio_function fn)
+{
+    if (gpio % 4 != 2)
+        return;
+    spi_inst_t *spi = &spi_instances[(gpio >> 3) & 1u];
+    bool is_pio = fn == GPIO_FUNC_PIO0 || fn == GPIO_FUNC_PIO1 || fn == GPIO_FUNC_PIO2;
+    if (is_pio)
+    {
+        spi->pio_sck = (int)gpio;
+        spi->last_sck = false;
+        spi->shift_bits = 0;
+    }
+    else if (spi->pio_sck == (int)gpio)
+    {
+        spi->pio_sck = -1;
+    }
+}
+
+void sim_spi_pio_pins(uint64_t levels)
+{
+    for (uint i = 0; i < 2; i++)
+    {
+        spi_inst_t *spi = &spi_instances[i];
+        if (spi->pio_sck < 0)
+            continue;
+        bool sck = (levels >> spi->pio_sck) & 1u;
+        if (sck && !spi->last_sck)
+        {
+            spi->shift = (uint8_t)((spi->shift << 1) | ((levels >> (spi->pio_sck + 1)) & 1u));
+            if (++spi->shift_bits == 8)
+            {
+                spi->shift_bits = 0;
+                spi->stats.bytes++;
+                if (spi->sink)
+                    spi->sink(spi->sink_ctx, &spi->shift, 1, 8);
+            }
+        }
+        spi->last_sck = sck;
+    }
+}
+
+void sim_spi_pio_done(uint64_t duration_ns, bool from_dma)
+{
+    for (uint i = 0; i < 2; i++)
+    {
+        spi_inst_t *spi = &spi_instances[i];
+        if (spi->pio_sck < 0)
+            continue;
+        spi->stats.transactions++;
+        spi->stats.bus_time_ns += duration_ns;
+        if (from_dma)
+            spi->stats.dma_transfers++;
+    }
+}
+
+// =============================================================================
+// SDK接口
+// =============================================================================
+uint spi_set_baudrate(spi_inst_t *spi, uint baudrate)
+{
+    uint freq_in = SIM_CLK_PERI_HZ;
+    uint prescale, postdiv;
+
+    for (prescale = 2; prescale <= 254; prescale += 2)
+    {
+        if (freq_in < prescale * 256 * (uint64_t)baudrate)
+            break;
+    }
+    for (postdiv = 256; postdiv > 1; --postdiv)
+    {
+        if (freq_in / (prescale * (postdiv - 1)) > baudrate)
+            break;
+    }
+
+    spi->baudrate = freq_in / (prescale * postdiv);
+    return spi->baudrate;
+}
+
+uint spi_get_baudrate(const spi_inst_t *spi)
+{
+    return spi->baudrate;
+}
+
+uint spi_init(spi_inst_t *spi, uint baudrate)
+{
+    spi->data_bits = 8;
+    spi->busy_until_ns = 0;
+    return spi_set_baudrate(spi, baudrate);
+}
+
+void spi_deinit(spi_inst_t *spi)
+{
+    spi->baudrate = 0;
+}
+
+void spi_set_format(spi_inst_t *spi, uint data_bits, spi_cpol_t cpol, spi_cpha_t cpha, spi_order_t order)
+{
+    (void)cpol;
+    (void)cpha;
+    (void)order;
+    // 与硬件一致：改变帧格式前必须等待总线空闲
+    if (spi_is_busy(spi))
+        panic("spi_set_format while SPI%u is busy", spi->index);
+    spi->data_bits = data_bits;
+}
+
+spi_hw_t *spi_get_hw(spi_inst_t *spi)
+{
+    return &spi->hw;
+}
+
+uint spi_get_index(const spi_inst_t *spi)
+{
+    return spi->index;
+}
+
+uint spi_get_dreq(spi_inst_t *spi, bool is_tx)
+{
+    if (spi->index == 0)
+        return is_tx ? DREQ_SPI0_TX : DREQ_SPI0_RX;
+    return is_tx ? DREQ_SPI1_TX : DREQ_SPI1_RX;
+}
+
+bool spi_is_busy(const spi_inst_t *spi)
+{
+    return sim_now_ns() < spi->busy_until_ns;
+}
+
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len)
+{
+    uint64_t done = sim_spi_transfer(spi, src, len, 1, false);
+    sim_advance_to_ns(done);
+    sim_poll();
+    return (int)len;
+}
+
+int spi_write16_blocking(spi_inst_t *spi, const uint16_t *src, size_t len)
+{
+    uint64_t done = sim_spi_transfer(spi, src, len, 2, false);
+    sim_advance_to_ns(done);
+    sim_poll();
+    return (int)len;
+}
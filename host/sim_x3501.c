@@ -0,0 +1,145 @@
+// =============================================================================
+// 主机模拟HAL：X3501 LCD 信号源
+//
+// 按行把帧数据推送给capture状态机 (与lcd_capture.pio一致：每行60个DATACLK、
+// 每个DATACLK 4位，ISR满32位自动推送)，并在帧开始时置位PIO中断标志0。
+// 可选：向帧完整性监视状态机推送行数/异常行时钟数，并按帧注入行数或时钟数故障
+// (故障帧只改变推送的位数，不模拟错位后的具体像素内容)。
+// =============================================================================
+#include <stdio.h>
+#include <string.h>
+#include "pico.h"
+#include "hardware/pio.h"
+#include "sim_hal.h"
+
+#define LINE_BITS 240
+#define LINE_CLOCKS (LINE_BITS / 4)
+#define FRAME_WORDS (SIM_X3501_FRAME_BYTES / 4)
+
+static sim_x3501_config_t source;
+static bool running = false;
+static uint32_t frame_index = 0;
+static uint32_t frames_sent = 0;
+static uint32_t current_period_us = 0;
+static uint64_t frame_start_ns = 0;
+static uint32_t line = 0;
+static uint32_t words_pushed = 0;
+static uint64_t stream_bits = 0;    // capture状态机累计采样位数 (不足32位的留在ISR)
+static uint64_t stream_words = 0;   // 累计自动推送的字数
+static uint32_t prev_frame_lines = 0;
+static sim_x3501_fault_t fault;
+static uint32_t frame_words[FRAME_WORDS];
+
+static void line_event(void *ctx);
+
+static void frame_event(void *ctx)
+{
+    (void)ctx;
+    if (!running)
+        return;
+
+    current_period_us = source.frame_period_us;
+    if (!source.next_frame(source.ctx, frame_index, (uint8_t *)frame_words, &current_period_us))
+    {
+        running = false;
+        return;
+    }
+    frame_index++;
+
+    frame_start_ns = sim_now_ns();
+    line = 0;
+    words_pushed = 0;
+    fault.lines = SIM_X3501_LINES;
+    fault.bad_line = UINT32_MAX;
+    fault.bad_line_clocks = LINE_CLOCKS;
+    if (source.fault != NULL)
+        source.fault(source.ctx, frame_index - 1, &fault);
+
+    // capture程序在帧开头清空ISR：上一帧不足32位的残留被丢弃
+    stream_bits = stream_words * 32;
+
+    // 监视状态机：行首FRAME为高时推送上一帧的行数 (在capture的"irq 0"之前)
+    if (source.monitor_pio != NULL)
+    {
+        sim_pio_frame_edge(source.monitor_pio);
+        sim_pio_rx_push(source.monitor_pio, source.line_sm, &prev_frame_lines, 1);
+    }
+    prev_frame_lines = fault.lines;
+
+    // FRAME上升沿：等待FRAME的状态机开始采样，capture程序执行 "irq 0"
+    bool capture_running = sim_pio_sm_enabled(source.pio, source.sm);
+    sim_pio_frame_edge(source.pio);
+    if (capture_running)
+        sim_pio_raise_irq(source.pio, 0);
+
+    uint64_t line_ns = (uint64_t)source.active_us * 1000 / SIM_X3501_LINES;
+    sim_schedule(frame_start_ns + line_ns, line_event, NULL);
+}
+
+static void line_event(void *ctx)
+{
+    (void)ctx;
+    if (!running)
+        return;
+
+    uint32_t clocks = (line == fault.bad_line) ? fault.bad_line_clocks : LINE_CLOCKS;
+    line++;
+    stream_bits += (uint64_t)clocks * 4;
+    while (stream_words < stream_bits / 32)
+    {
+        // 超出一帧的字 (长帧/多出的时钟) 补0
+        uint32_t word = (words_pushed < FRAME_WORDS) ? frame_words[words_pushed] : 0;
+        sim_pio_rx_push(source.pio, source.sm, &word, 1);
+        words_pushed++;
+        stream_words++;
+    }
+
+    // 本行在下一个LINECLK上升沿结束：时钟数不对时lcd_dataclk_monitor推送实际时钟数
+    if (clocks != LINE_CLOCKS && source.monitor_pio != NULL)
+        sim_pio_rx_push(source.monitor_pio, source.clock_sm, &clocks, 1);
+
+    uint64_t line_ns = (uint64_t)source.active_us * 1000 / SIM_X3501_LINES;
+    if (line < fault.lines)
+    {
+        sim_schedule(frame_start_ns + (uint64_t)(line + 1) * line_ns, line_event, NULL);
+    }
+    else
+    {
+        frames_sent++;
+        uint64_t next_ns = frame_start_ns + (uint64_t)current_period_us * 1000;
+        if (next_ns < sim_now_ns() + line_ns)
+            next_ns = sim_now_ns() + line_ns; // 长帧：下一个FRAME至少在一行之后
+        sim_schedule(next_ns, frame_event, NULL);
+    }
+}
+
+void sim_x3501_start(const sim_x3501_config_t *config)
+{
+    source = *config;
+    if (source.active_us == 0 || source.active_us > source.frame_period_us)
+        source.active_us = source.frame_period_us;
+    running = true;
+    frame_index = 0;
+    frames_sent = 0;
+    stream_bits = 0;
+    stream_words = 0;
+    prev_frame_lines = 0;
+    sim_schedule(sim_now_ns(), frame_event, NULL);
+}
+
+void sim_x3501_stop(void)
+{
+    running = false;
+    sim_cancel(frame_event, NULL);
+    sim_cancel(line_event, NULL);
+}
+
+bool sim_x3501_running(void)
+{
+    return running;
+}
+
+uint32_t sim_x3501_frames_sent(void)
+{
+    return frames_sent;
+}
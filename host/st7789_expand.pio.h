@@ -0,0 +1,44 @@
+// =============================================================================
+// 主机端替身：内容与 pioasm 从 ../st7789_expand.pio 生成的头文件一致 (指令手工汇编)。
+// 主机没有pioasm；sim_pio.c 的指令解释器执行这些编码，是PIO展开输出的参考模型，
+// 修改 .pio 时必须同步修改这里。
+// =============================================================================
+#pragma once
+
+#include "hardware/pio.h"
+
+#define st7789_expand_wrap_target 0
+#define st7789_expand_wrap 10
+#define st7789_expand_pio_version 1
+
+static const uint16_t st7789_expand_program_instructions[] = {
+            //     .wrap_target
+    0x80a0, //  0: pull   block           side 0
+    0xa0c7, //  1: mov    isr, osr        side 0
+    0xe03f, //  2: set    x, 31           side 0
+    0xa0e6, //  3: mov    osr, isr        side 0
+    0x6041, //  4: out    y, 1            side 0
+    0xa0c7, //  5: mov    isr, osr        side 0
+    0x8090, //  6: mov    osr, rxfifo[y]  side 0
+    0xa0e7, //  7: mov    osr, osr        side 0
+    0x6001, //  8: out    pins, 1         side 0
+    0x10e8, //  9: jmp    !osre, 8        side 1
+    0x0043, // 10: jmp    x--, 3          side 0
+            //     .wrap
+};
+
+static const pio_program_t st7789_expand_program = {
+    .instructions = st7789_expand_program_instructions,
+    .length = 11,
+    .origin = -1,
+    .pio_version = 1,
+};
+
+static inline pio_sm_config st7789_expand_program_get_default_config(uint offset)
+{
+    pio_sm_config c = pio_get_default_sm_config();
+    sm_config_set_wrap(&c, offset + st7789_expand_wrap_target, offset + st7789_expand_wrap);
+    sm_config_set_sideset(&c, 1, false, false);
+    sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_TXGET);
+    return c;
+}
@@ -40,13 +40,83 @@
     // pin_sck  = 18   (时钟)
     // pin_mosi = 19   (数据)
     // pin_blk  = 21   (背光)
+    // pin_te   = 22   (TE输出，ST7789_TE_PACING置1时使用)
     // SPI_PORT = spi0
 
     #define LCD_TYPE_NAME "ST7789 240x240 彩色LCD"
     #define LCD_DISPLAY_WIDTH 240
     #define LCD_DISPLAY_HEIGHT 240
+    // 像素格式：默认RGB565 (16位)，与 LCD_CONFIG_ST7789_240x240 一致
+    // 置1使用RGB444 (12位，COLMOD 0x03)：1-bit源只有黑白两色，无损且每帧少发25%字节
+    #ifndef ST7789_OUTPUT_RGB444
+    #define ST7789_OUTPUT_RGB444 0
+    #endif
+
+    #if ST7789_OUTPUT_RGB444
+    #define LCD_COLOR_DEPTH 12  // 12-bit RGB444
+    #else
     #define LCD_COLOR_DEPTH 16  // 16-bit RGB565
+    #endif
+
+    // 输出引擎：置1由pio1把1-bit行直接展开成像素并驱动SCK/MOSI (CPU不做转换，
+    // DMA每帧只搬运7.2KB)；总线比SPI控制器慢约19% (每像素多6个PIO周期)
+    #ifndef ST7789_OUTPUT_PIO_EXPAND
+    #define ST7789_OUTPUT_PIO_EXPAND 0
+    #endif
+
+    // TE同步送显：置1时打开面板的TE输出 (需要把TE脚接到GPIO 22)，每个刷新周期最多送一帧，
+    // 只在扫描线碰不到240行窗口的时段开始发送，消除撕裂；输出帧率不超过面板刷新率
+    #ifndef ST7789_TE_PACING
+    #define ST7789_TE_PACING 0
+    #endif
 
 #endif
 
+// =============================================================================
+// ST75320 页流水线
+// =============================================================================
+// 置1时没有9.6KB的整帧显存：转换内核逐页生成到两个320字节的页缓冲里，
+// 第p页在DMA上发送时转换第p+1页 (所有旋转角度都能逐页生成)。
+// 此时不提供 lcd_set_pixel / lcd_draw_rect / lcd_refresh (需要随机访问整帧显存)。
+// 置0恢复整帧显存：先转换完整帧再一次发送。
+#ifndef ST75320_PAGE_PIPELINE
+#define ST75320_PAGE_PIPELINE 1
+#endif
+
+// =============================================================================
+// 追帧送显 (低延迟)
+// =============================================================================
+// 置1时不等整帧捕获完：显示循环跟着捕获DMA的写指针，每落地24行就把其中变化的行转换并送显，
+// 帧的最后一行捕获完到它上屏只剩最后一个带的发送时间 (整帧模式要等整帧转换发送)。
+// 代价：不做CRC去重，不等完整性判定 (坏帧可能上屏一帧)，没有渲染帧可导出 (ENABLE_CAPTURE_DUMP无效)。
+// 与ST7789的TE同步送显互斥
+#ifndef LCD_RACE_THE_BEAM
+#define LCD_RACE_THE_BEAM 0
+#endif
+
+#if LCD_RACE_THE_BEAM && defined(ST7789_TE_PACING) && ST7789_TE_PACING
+#error "LCD_RACE_THE_BEAM 与 ST7789_TE_PACING 不能同时打开"
+#endif
+
+// =============================================================================
+// 捕获帧导出 (调试/回放素材)
+// =============================================================================
+// 置1后，每个新的渲染帧以 "@CAP ..." 文本行从USB串口输出 (格式见 capture_file.h)，
+// 主机端用 lcd_host import 把串口日志转换成 .cap 文件，再用 lcd_host replay 回放。
+// 每帧约14.4KB文本，USB输出会拖慢主循环，正常使用时保持为0。
+#ifndef ENABLE_CAPTURE_DUMP
+#define ENABLE_CAPTURE_DUMP 0
+#endif
+
+// =============================================================================
+// 双核分工
+// =============================================================================
+// 置1时core1独占显示流水线 (取帧、1-bit转换、SPI/DMA送显、帧导出)，
+// core0只负责捕获中断、帧异常恢复、传感器和背光/对比度控制。
+// 帧通过无锁三重缓冲状态字交接 (lcd_triple_buffer.h)，送显时等待SPI DMA的阻塞只发生在core1上。
+// 主机模拟器不模拟core1，双核路径还没有在板子上验证，默认保持单核主循环。
+#ifndef ENABLE_DUAL_CORE
+#define ENABLE_DUAL_CORE 0
+#endif
+
 #endif // LCD_CONFIG_H
\ No newline at end of file
@@ -2,7 +2,9 @@
 #include <string.h>
 #include <math.h>
 #include <stdlib.h>
+#include <stdatomic.h>
 #include "pico/stdlib.h"
+#include "pico/multicore.h"
 #include "hardware/pio.h"
 #include "hardware/irq.h"
 #include "hardware/dma.h"
@@ -11,6 +13,7 @@
 #include "lcd_framebuffer.h"
 #include "lcd_config.h"
 #include "sensor.h"
+#include "capture_file.h"
 
 #ifdef USE_ST75320_LCD
 #include "lcd_st75320.h"
@@ -20,6 +23,11 @@
 #define LCD_CAPTURE_PIO pio0
 #define LCD_CAPTURE_SM 0 // 单状态机
 
+// 帧完整性监视：lcd_capture占满了pio0的大部分指令空间，两个监视程序放在pio2
+#define LCD_MONITOR_PIO pio2
+#define LCD_MONITOR_LINE_SM 0
+#define LCD_MONITOR_CLOCK_SM 1
+
 // 当前IO口配置
 #define X3501_FRAME_PIN 2
 #define X3501_LINECLK_PIN 3
@@ -55,6 +63,30 @@ static bool init_capture_pio(void)
     return true;
 }
 
+// 帧完整性监视PIO：每帧LINECLK计数 + 每行DATACLK计数 (在捕获DMA准备好之后启动)
+static bool init_monitor_pio(void)
+{
+    if (!pio_can_add_program(LCD_MONITOR_PIO, &lcd_line_monitor_program) ||
+        !pio_can_add_program(LCD_MONITOR_PIO, &lcd_dataclk_monitor_program))
+    {
+        printf("❌ 监视程序指令空间不足\n");
+        return false;
+    }
+
+    uint line_offset = pio_add_program(LCD_MONITOR_PIO, &lcd_line_monitor_program);
+    uint clock_offset = pio_add_program(LCD_MONITOR_PIO, &lcd_dataclk_monitor_program);
+    pio_sm_claim(LCD_MONITOR_PIO, LCD_MONITOR_LINE_SM);
+    pio_sm_claim(LCD_MONITOR_PIO, LCD_MONITOR_CLOCK_SM);
+
+    lcd_line_monitor_program_init(LCD_MONITOR_PIO, LCD_MONITOR_LINE_SM, line_offset);
+    lcd_dataclk_monitor_program_init(LCD_MONITOR_PIO, LCD_MONITOR_CLOCK_SM, clock_offset, LCD_WIDTH / 4);
+    pio_sm_set_enabled(LCD_MONITOR_PIO, LCD_MONITOR_LINE_SM, true);
+    pio_sm_set_enabled(LCD_MONITOR_PIO, LCD_MONITOR_CLOCK_SM, true);
+
+    printf("帧完整性监视: 期望每帧%d行、每行%d个DATACLK\n", LCD_HEIGHT, LCD_WIDTH / 4);
+    return lcd_framebuffer_init_integrity_monitor(LCD_MONITOR_PIO, LCD_MONITOR_LINE_SM, LCD_MONITOR_CLOCK_SM);
+}
+
 // 初始化SPI LCD
 static bool init_spi_lcd(void)
 {
@@ -68,6 +100,12 @@ static bool init_spi_lcd(void)
 
     lcd_config_t config = LCD_CONFIG_ST7789_240x240;
     config.spi_freq_hz = 80000000; // 80MHz
+#if ST7789_OUTPUT_RGB444
+    config.color_format = LCD_COLOR_RGB444;
+#endif
+#if ST7789_OUTPUT_PIO_EXPAND
+    config.output_engine = LCD_OUTPUT_PIO_EXPAND;
+#endif
 
     // 自定义引脚配置
     config.pin_cs = 17;
@@ -76,12 +114,16 @@ static bool init_spi_lcd(void)
     config.pin_sck = 18;
     config.pin_mosi = 19;
     config.pin_blk = 21;
+    config.pin_te = 22;
 
     if (!spi_lcd_init(&config))
     {
         printf("错误: SPI LCD初始化失败\n");
         return false;
     }
+#if ST7789_TE_PACING
+    spi_lcd_set_te_pacing(true);
+#endif
 
     // // 显示红绿蓝三色测试图案
     // spi_lcd_clear(LCD_COLOR_BLACK);
@@ -112,65 +154,145 @@ static bool init_spi_lcd(void)
 #endif
 }
 
-// 高效显示framebuffer到SPI LCD (使用DMA批量传输)
+#if !LCD_RACE_THE_BEAM
+// 高效显示framebuffer到SPI LCD (异步提交DMA传输，只发送变化的行)
+// 返回时传输还在进行，渲染缓冲区由显示驱动占用，最后一段DMA完成中断里释放
 static void display_framebuffer_to_lcd(void)
 {
+    const lcd_dirty_rows_t *dirty = lcd_framebuffer_get_dirty_rows();
 #ifdef USE_ST75320_LCD
-    // ST75320和捕获的framebuffer都是1-bit单色，使用优化的批量更新
-    const uint8_t *framebuffer_data = lcd_framebuffer_get_render_data();
-    if (framebuffer_data != NULL)
+    // ST75320和捕获的framebuffer都是1-bit单色，按页转换后逐页发送
+    if (!lcd_submit_dirty_from_framebuffer(dirty))
     {
-        lcd_update_from_1bit_framebuffer(framebuffer_data);
+        printf("显示失败 - framebuffer未就绪\n");
     }
 #else
-    // 直接使用spi_lcd的高效framebuffer更新函数
-    if (!spi_lcd_update_from_framebuffer())
+    if (!spi_lcd_submit_dirty_from_framebuffer(dirty))
     {
         printf("显示失败 - framebuffer未就绪\n");
     }
 #endif
 }
-static void display_frame_check(void)
+#endif
+
+// 能否取下一帧：上一帧已经发完 (顺便记录它的帧统计)；ST7789按TE节拍时还要在本周期的开始窗口里
+static bool display_output_ready(void)
+{
+#ifdef USE_ST75320_LCD
+    return lcd_poll();
+#else
+    return spi_lcd_frame_slot();
+#endif
+}
+#if ENABLE_CAPTURE_DUMP
+// 把新的渲染帧以文本记录输出到串口 (同一帧只输出一次)
+static void dump_capture_frame(void)
+{
+    static capture_record_t record;
+    static uint32_t last_dumped_id = 0;
+
+    lcd_framebuffer_t frame;
+    if (!lcd_framebuffer_get_render_frame(&frame) || frame.frame_id == last_dumped_id)
+        return;
+
+    record.frame_id = frame.frame_id;
+    record.timestamp_us = frame.timestamp_us;
+    record.frame_to_dma_interval_us = lcd_framebuffer_get_frame_to_dma_interval();
+    memcpy(record.data, frame.data, CAPTURE_FRAME_BYTES);
+    last_dumped_id = frame.frame_id;
+
+    capture_record_print(&record);
+}
+#endif
+
+// 显示流水线的一步：有变化的新帧就转换并送显
+// 单核模式在主循环里调用；双核模式只在core1上调用。送显是异步的：上一帧还在发送时
+// 直接返回，不等DMA
+static void display_pipeline_poll(void)
 {
-    static uint32_t last_status_time = 0;
-    // 每1秒打印状态信息并检测异常
-    if (last_status_time <= time_us_32())
+#if LCD_RACE_THE_BEAM
+    // 追帧送显：输出空闲就把正在捕获的帧里新落地的、有变化的行直接从捕获缓冲区送出
+    static lcd_dirty_rows_t band;
+    const uint8_t *band_data;
+    if (display_output_ready() && lcd_framebuffer_beam_next_band(&band_data, &band))
     {
-        last_status_time = time_us_32() + 1000 * 100;
-        int32_t frame_to_dma_interval = lcd_framebuffer_get_frame_to_dma_interval();
+#ifdef USE_ST75320_LCD
+        lcd_submit_rows(band_data, &band);
+#else
+        spi_lcd_submit_rows(band_data, &band);
+#endif
+    }
+#else
+    // 准备安全的显示帧（拷贝到专用渲染缓冲区）
+    // 帧CRC与上次送显的相同时跳过转换和SPI传输 (画面静止时总线空闲)
+    if (display_output_ready() && lcd_framebuffer_prepare_changed_frame())
+    {
+        // 现在可以安全地显示，数据不会被采集覆盖
+        display_framebuffer_to_lcd();
+    }
+#endif
+#if ENABLE_CAPTURE_DUMP
+    dump_capture_frame();
+#endif
+}
 
-        // printf(">>> 帧时序: frame_to_dma_interval = %d us (用于偏移检测)\n",
-        //        frame_to_dma_interval);
+#ifdef USE_ST75320_LCD
+#if ENABLE_DUAL_CORE
+// 对比度命令和帧数据共用显示SPI：core0只把新值放进这个槽，由core1在两帧之间发送
+#define CONTRAST_REQUEST_PENDING 0x100u
+static _Atomic uint32_t contrast_request = 0;
 
-        // 连续3次检测到frame_to_dma_interval不在13800-13810范围内就重置
-        static uint8_t error_count = 0;
-        const uint32_t TARGET_MIN = 13799;
-        const uint32_t TARGET_MAX = 13810;
+static void request_contrast(uint8_t contrast)
+{
+    atomic_store_explicit(&contrast_request, CONTRAST_REQUEST_PENDING | contrast, memory_order_release);
+}
 
-        if (frame_to_dma_interval < TARGET_MIN || frame_to_dma_interval > TARGET_MAX)
-        {
-            error_count++;
-            printf(">>> 时序异常检测: %d/%d (范围: %u-%u us)\n",
-                   error_count, 3, TARGET_MIN, TARGET_MAX);
-
-            if (error_count >= 3)
-            {
-                printf(">>> 连续3次时序异常，重置捕获系统\n");
-                lcd_framebuffer_reset_capture_system();
-                error_count = 0; // 重置计数器
-            }
-        }
-        else
-        {
-            // 时序正常，重置错误计数
-            if (error_count > 0)
-            {
-                printf(">>> 时序恢复正常，重置错误计数\n");
-                error_count = 0;
-            }
-        }
+static void apply_contrast_request(void)
+{
+    uint32_t request = atomic_exchange_explicit(&contrast_request, 0, memory_order_acquire);
+    if (request & CONTRAST_REQUEST_PENDING)
+        lcd_set_contrast((uint8_t)request);
+}
+#else
+static void request_contrast(uint8_t contrast)
+{
+    lcd_set_contrast(contrast);
+}
+#endif
+#endif
+
+#if ENABLE_DUAL_CORE
+// core1：只跑显示流水线。捕获中断在core0上注册和处理，帧从三重缓冲的display槽取走
+static void core1_display_main(void)
+{
+    while (true)
+    {
+#ifdef USE_ST75320_LCD
+        apply_contrast_request();
+#endif
+        display_pipeline_poll();
     }
 }
+#endif
+
+// 帧完整性由监视状态机逐帧判定，坏帧在送显前已经丢弃，捕获在中断里快速重新同步；
+// 只有连续几次重新同步都没有得到有效帧时才完整重启捕获系统
+static void display_frame_check(void)
+{
+    if (!lcd_framebuffer_capture_needs_reset())
+        return;
+
+    lcd_frame_integrity_stats_t stats;
+    lcd_capture_recovery_stats_t recovery;
+    lcd_framebuffer_get_integrity_stats(&stats);
+    lcd_framebuffer_get_recovery_stats(&recovery);
+    printf(">>> 帧异常: 行数 %u, 异常行DATACLK %u (有效 %u, 短帧 %u, 长帧 %u, 丢弃 %u)\n",
+           stats.last_lines, stats.last_bad_clocks, stats.valid, stats.short_frames,
+           stats.long_frames, stats.dropped);
+    printf(">>> 快速重新同步 %u+%u 次无效，完整重启 (已重启 %u 次，最长恢复 %u us)\n",
+           recovery.edge_resyncs, recovery.wait_resyncs, recovery.full_resets, recovery.max_recovery_us);
+    lcd_framebuffer_reset_capture_system(); // 只动生产者的缓冲区，core1可以继续渲染
+}
 
 int main()
 {
@@ -223,6 +345,13 @@ int main()
         return -1;
     }
 
+    // 初始化帧完整性监视 (在启动捕获之前，第一个FRAME边沿起开始计数)
+    if (!init_monitor_pio())
+    {
+        printf("帧完整性监视初始化失败\n");
+        return -1;
+    }
+
     // 启动零CPU参与的自动捕获
     if (!lcd_framebuffer_start_auto_capture())
     {
@@ -243,14 +372,17 @@ int main()
     static uint64_t last_sensor_read_time = 0;
     const uint64_t sensor_read_interval_us = 200000; // 200ms
 
+#if ENABLE_DUAL_CORE
+    // 显示初始化已在core0上完成，之后显示SPI只由core1使用
+    multicore_launch_core1(core1_display_main);
+    printf("双核模式: core0 捕获/传感器/控制, core1 显示流水线\n");
+#endif
+
     while (true)
     {
-        // 准备安全的显示帧（拷贝到专用渲染缓冲区）
-        if (lcd_framebuffer_prepare_display_frame())
-        {
-            // 现在可以安全地显示，数据不会被采集覆盖
-            display_framebuffer_to_lcd();
-        }
+#if !ENABLE_DUAL_CORE
+        display_pipeline_poll();
+#endif
 
         display_frame_check();
 
@@ -312,7 +444,7 @@ int main()
 
             // 步进为 1：对比度值变化才更新，避免频繁写入但保证平滑
             if (last_contrast == 0xFF || contrast != last_contrast) {
-                lcd_set_contrast(contrast);
+                request_contrast(contrast);
                 last_contrast = contrast;
             }
 #endif
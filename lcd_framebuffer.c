@@ -1,12 +1,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdatomic.h>
 #include "pico/stdlib.h"
-#include "pico/sync.h"
 #include "hardware/pio.h"
 #include "hardware/dma.h"
 #include "hardware/irq.h"
 #include "lcd_framebuffer.h"
+#include "lcd_triple_buffer.h"
 #include "hardware/irq.h"
 #include "hardware/timer.h"
 #include "hardware/pwm.h"
@@ -17,6 +18,11 @@
 #define LCD_BITS_PER_PIXEL 1
 #define LCD_BYTES_PER_LINE ((LCD_WIDTH * LCD_BITS_PER_PIXEL + 7) / 8) // 30 bytes per line
 #define LCD_FRAME_SIZE (LCD_BYTES_PER_LINE * LCD_HEIGHT)              // 7,200 bytes per frame
+#define LCD_CLOCKS_PER_LINE (LCD_WIDTH / 4)                            // 每个DATACLK采4个像素
+#define LCD_CAPTURE_FIFO_DEPTH 8                                       // capture状态机RX FIFO (合并后)
+#define LCD_RESYNC_ESCALATE 3                                          // 连续快速重新同步失败次数上限
+#define LCD_RESYNC_MAX_WORDS 256                                       // 帧边沿重新同步最多搬回的字数 (约34行，2ms中断延迟)
+#define LCD_BEAM_BAND_ROWS 24 // 追帧送显的带高：ST75320的3页、8个4/3缩放行组、PIO展开的12个行对、ST7789转换的3个块
 
 // Internal frame buffer structure
 typedef struct
@@ -27,19 +33,34 @@ typedef struct
     uint32_t frame_id;
     uint64_t timestamp_us;
     int32_t frame_to_dma_interval_us; // 帧开始到DMA完成的时间间隔(微秒)
+    uint32_t crc;                     // 帧内容CRC-32 (DMA嗅探器或软件计算)
+    bool crc_valid;                   // 中断来得太晚、嗅探器漏掉帧开头时为false
 } internal_framebuffer_t;
 
-// Triple buffer system for safe display (zero-copy implementation)
-static internal_framebuffer_t frame_buffers[3];
-static volatile uint8_t active_buffer = 0;  // Buffer being written by DMA
-static volatile uint8_t display_buffer = 1; // Buffer ready for display
-static volatile uint8_t render_buffer = 2;  // Buffer being used by display system
-static critical_section_t buffer_mutex;
+// CRC-32 (多项式0x04C11DB7，MSB优先，初值0xFFFFFFFF，无输出取反)
+// 与DMA嗅探器 DMA_SNIFF_CTRL_CALC_VALUE_CRC32 模式相同；只用于判断帧内容是否变化
+#define LCD_FRAME_CRC_SEED 0xFFFFFFFFu
+
+// Triple buffer system for safe display (zero-copy, lock-free)
+// active = written by DMA, display = newest complete frame, render = used by display system,
+// spare = already armed in the idle ping-pong DMA channel for the frame after active,
+// pending/free = complete frame waiting for its integrity verdict, or the buffer it will free
+#define LCD_CAPTURE_BUFFERS 5
+static internal_framebuffer_t frame_buffers[LCD_CAPTURE_BUFFERS];
+static lcd_triple_buffer_t buffer_state;
+static uint32_t spare_buffer = 3;
+static int32_t pending_buffer = -1; // <0 时 free_buffer 有效
+static uint32_t free_buffer = 4;
 
 // =============================================================================
 // DMA和自动捕获配置 (集中管理)
 // =============================================================================
-static uint dma_channel = -1; // 用于PIO数据捕获
+// 乒乓捕获：两个通道互相chain，一个通道完成时另一个已装好下一帧的目标地址并立即接管，
+// 中断只做记账和重新装填空闲通道，不在数据通路上
+static uint dma_channel = -1;      // 用于PIO数据捕获 (乒)
+static uint dma_channel_pong = -1; // 用于PIO数据捕获 (乓)
+static uint capture_channel = 0;   // 正在写入active缓冲区的通道
+static bool capture_crc_valid = false; // 嗅探器是否从帧开头就跟踪了capture_channel
 static bool framebuffer_initialized = false;
 
 // Auto-capture DMA configuration
@@ -47,8 +68,89 @@ static PIO pio_instance = NULL;
 static uint pio_sm = 0;
 static volatile bool auto_capture_enabled = false;
 static volatile uint32_t frame_counter = 0;
+static volatile uint32_t frames_superseded = 0; // 显示端取走之前就被更新的帧替换掉的帧
 static volatile uint32_t frame_sync_errors = 0;
 
+// 帧完整性监视 (lcd_capture.pio 的 lcd_line_monitor / lcd_dataclk_monitor)
+static PIO monitor_pio = NULL;
+static uint monitor_line_sm = 0;
+static uint monitor_clock_sm = 0;
+static bool integrity_monitor_enabled = false;
+static bool monitor_synced = false;        // 第一个FRAME边沿之前的计数不完整，丢弃
+static lcd_frame_integrity_stats_t integrity_stats;
+
+// 错误恢复：坏帧之后在中断里快速重新同步，连续失败才升级为完整重启
+static volatile bool capture_reset_needed = false;
+static bool resync_after_completion = false; // DMA中断里发现的错位，处理完通道后再重新同步
+static uint32_t consecutive_resyncs = 0;     // 两次有效帧之间的快速重新同步次数
+static bool recovery_waiting = false;        // 捕获在等下一个FRAME边沿重新开始
+static uint64_t recovery_started_us = 0;
+static lcd_capture_recovery_stats_t recovery_stats;
+
+// 帧去重：上次送显帧的CRC
+static bool displayed_crc_valid = false;
+static bool shadow_valid = false; // displayed_shadow 保存着上次送显的帧
+static uint32_t displayed_crc = 0;
+static uint32_t frames_shown = 0;
+static uint32_t frames_skipped = 0;
+
+// 异步送显：提交的帧还在读取渲染缓冲区时为true，由显示驱动的DMA完成中断清除
+static volatile bool render_held = false;
+
+// 脏行跟踪：上次送显帧的副本 + 本次变化的行
+static uint8_t displayed_shadow[LCD_FRAME_SIZE] __attribute__((aligned(4)));
+static lcd_dirty_rows_t dirty_rows;
+
+// 追帧送显：捕获进度的顺序锁 (中断修改捕获状态期间为奇数)，显示循环据此读到一致的快照
+static atomic_uint capture_seq;
+static uint32_t capture_restarts = 0; // 重新同步/重启次数：正在跟随的帧作废
+
+typedef struct
+{
+    bool following;
+    uint32_t frame_id;  // 跟随的帧完成后的序号 (frame_counter)
+    uint32_t buffer;    // 跟随的帧所在的缓冲区
+    uint32_t restarts;
+    uint32_t rows_done; // 已经比较过 (送出或没有变化) 的行
+    bool redraw;        // 整帧重绘：等这一帧写完再整帧送出
+} beam_follow_t;
+static beam_follow_t beam;
+
+// 捕获到送显的延迟：帧的最后一行捕获完 (DMA完成) -> 这一帧最后的变化行发送完
+static bool output_inflight = false;    // 已提交的帧/带还没发送完
+static bool output_final = false;       // 已提交的是某一帧最后的变化行
+static uint32_t output_frame_id = 0;    // 最近提交的帧/带属于哪一帧
+static uint32_t output_capture_end_us = 0;
+static uint32_t output_done_us = 0;
+static lcd_output_latency_stats_t latency_stats;
+
+// 软件CRC查找表 (DMA嗅探器不可用时使用，例如回放提交的帧)
+static uint32_t crc32_table[256];
+
+static void init_crc32_table(void)
+{
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t crc = i << 24;
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc & 0x80000000u) ? (crc << 1) ^ 0x04C11DB7u : (crc << 1);
+        crc32_table[i] = crc;
+    }
+}
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+        crc = (crc << 8) ^ crc32_table[(crc >> 24) ^ data[i]];
+    return crc;
+}
+
+// 软件计算帧CRC (回放提交的帧没有经过DMA嗅探器)
+uint32_t lcd_framebuffer_crc32(const uint8_t *data, size_t len)
+{
+    return crc32_update(LCD_FRAME_CRC_SEED, data, len);
+}
+
 // Initialize frame buffer system
 bool lcd_framebuffer_init(void)
 {
@@ -57,31 +159,37 @@ bool lcd_framebuffer_init(void)
         return true;
     }
 
-    // Initialize critical section for thread safety
-    critical_section_init(&buffer_mutex);
+    // 无锁三重缓冲索引：DMA中断和显示循环互不阻塞
+    lcd_triple_buffer_init(&buffer_state);
 
     // Clear frame buffers
     memset(frame_buffers, 0, sizeof(frame_buffers));
+    init_crc32_table();
 
-    // Initialize buffer states (triple buffer)
-    frame_buffers[0].ready = false;
-    frame_buffers[0].capturing = false;
-    frame_buffers[0].frame_id = 0;
-
-    frame_buffers[1].ready = false;
-    frame_buffers[1].capturing = false;
-    frame_buffers[1].frame_id = 0;
-
-    frame_buffers[2].ready = false;
-    frame_buffers[2].capturing = false;
-    frame_buffers[2].frame_id = 0;
-
-    // Claim DMA channel for PIO data capture
-    dma_channel = dma_claim_unused_channel(true);
-    if (dma_channel == -1)
+    // Initialize buffer states (triple buffer + ping-pong spare)
+    for (int i = 0; i < LCD_CAPTURE_BUFFERS; i++)
+    {
+        frame_buffers[i].ready = false;
+        frame_buffers[i].capturing = false;
+        frame_buffers[i].frame_id = 0;
+    }
+    spare_buffer = 3;
+    pending_buffer = -1;
+    free_buffer = 4;
+
+    // Claim ping-pong DMA channels for PIO data capture
+    int ping = dma_claim_unused_channel(false);
+    int pong = dma_claim_unused_channel(false);
+    if (ping < 0 || pong < 0)
     {
+        if (ping >= 0)
+            dma_channel_unclaim((uint)ping);
+        if (pong >= 0)
+            dma_channel_unclaim((uint)pong);
         return false;
     }
+    dma_channel = (uint)ping;
+    dma_channel_pong = (uint)pong;
 
     framebuffer_initialized = true;
     return true;
@@ -92,11 +200,45 @@ bool lcd_framebuffer_init(void)
 static uint64_t frame_start_time = 0;       // 用于记录帧开始时间
 static uint64_t last_dma_complete_time = 0; // 用于记录上一次DMA完成时间
 
+static void judge_finished_frames(void);
+
+// 修改显示循环追帧时读取的捕获状态 (完成帧、换通道、重新同步) 前后调用
+static inline void capture_seq_begin(void)
+{
+    atomic_fetch_add_explicit(&capture_seq, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static inline void capture_seq_end(void)
+{
+    atomic_fetch_add_explicit(&capture_seq, 1, memory_order_release);
+}
+
+// 一次恢复的耗时：发现坏帧 -> 捕获重新从帧开头运行
+static void record_recovery(uint64_t started_us, uint64_t aligned_us)
+{
+    uint32_t elapsed = (uint32_t)(aligned_us - started_us);
+    recovery_stats.last_recovery_us = elapsed;
+    if (elapsed > recovery_stats.max_recovery_us)
+        recovery_stats.max_recovery_us = elapsed;
+}
+
 static void pio_irq_handler(void)
 {
     // 清除PIO中断标志
     pio_interrupt_clear(pio_instance, 0);
     frame_start_time = time_us_64();
+
+    // capture状态机刚从wait_frame执行了"irq 0"：重新同步/重启后的第一帧从这里开始
+    if (recovery_waiting)
+    {
+        recovery_waiting = false;
+        record_recovery(recovery_started_us, frame_start_time);
+    }
+
+    // 帧边沿：监视状态机刚推送了上一帧的计数
+    if (integrity_monitor_enabled && auto_capture_enabled)
+        judge_finished_frames();
 }
 
 void lcd_capture_frame_irq_enable(PIO pio)
@@ -111,107 +253,422 @@ void lcd_capture_frame_irq_enable(PIO pio)
 // =============================================================================
 // DMA中断处理和自动捕获系统 (集中管理)
 // =============================================================================
-// DMA中断处理函数 - 处理帧完成和缓冲区轮换
-static void dma_capture_irq_handler(void)
+// 完成active缓冲区并发布给显示端 (只由生产者调用：DMA中断或回放提交)
+// 备用缓冲区接替成为active，返回回收的缓冲区 (新的备用缓冲区)
+static uint32_t complete_active_buffer(uint32_t frame_id, uint64_t timestamp_us, int32_t frame_to_dma_interval_us,
+                                       uint32_t crc, bool crc_valid)
 {
-    if (dma_channel_get_irq0_status(dma_channel))
+    // 完成当前缓冲区 (元信息在发布之前写好，消费者获取时一定可见)
+    internal_framebuffer_t *completed = &frame_buffers[lcd_triple_buffer_active(&buffer_state)];
+    completed->capturing = false;
+    completed->ready = true;
+    completed->frame_id = frame_id;
+    completed->timestamp_us = timestamp_us;
+    completed->frame_to_dma_interval_us = frame_to_dma_interval_us;
+    completed->crc = crc;
+    completed->crc_valid = crc_valid;
+
+    // 缓冲区轮换：完成的缓冲区原子地变成新的display缓冲区，备用缓冲区成为active，
+    // 显示端还没取走的旧display缓冲区被回收为备用 (render缓冲区不受影响)
+    uint32_t next_active = spare_buffer;
+    bool superseded;
+    spare_buffer = lcd_triple_buffer_publish_next(&buffer_state, next_active, &superseded);
+    if (superseded)
+        frames_superseded++;
+
+    // 准备下一个缓冲区
+    frame_buffers[next_active].capturing = true;
+    frame_buffers[next_active].ready = false;
+    frame_buffers[spare_buffer].capturing = false;
+    frame_buffers[spare_buffer].ready = false;
+    return spare_buffer;
+}
+
+// 暂存帧得到判定：有效则发布给显示端，否则丢弃 (需要重新同步时一律丢弃)
+// 回收的缓冲区成为free_buffer
+static void resolve_pending_frame(bool valid)
+{
+    uint32_t held = (uint32_t)pending_buffer;
+    pending_buffer = -1;
+
+    if (valid && !capture_reset_needed)
     {
-        dma_channel_acknowledge_irq0(dma_channel);
+        frame_buffers[held].ready = true;
+        bool superseded;
+        free_buffer = lcd_triple_buffer_publish_held(&buffer_state, held, &superseded);
+        if (superseded)
+            frames_superseded++;
+    }
+    else
+    {
+        free_buffer = held;
+        integrity_stats.dropped++;
+    }
+    frame_buffers[free_buffer].ready = false;
+}
 
-        if (!auto_capture_enabled)
-        {
-            return;
-        }
+// 完整性监视打开时完成active缓冲区：写完的帧移出状态字暂存，等下一个FRAME边沿的判定
+// 备用缓冲区接替成为active，返回新的备用缓冲区
+static uint32_t hold_active_buffer(uint32_t frame_id, uint64_t timestamp_us, int32_t frame_to_dma_interval_us,
+                                   uint32_t crc, bool crc_valid)
+{
+    // 上一帧整整一帧时间都没有等到判定：FRAME边沿丢失，帧比240行长，捕获已错位
+    if (pending_buffer >= 0)
+    {
+        integrity_stats.long_frames++;
+        resolve_pending_frame(false);
+        resync_after_completion = true;
+    }
 
-        // 计算从帧开始到DMA完成的时间间隔
-        uint64_t dma_complete_time = time_us_64();
-        int32_t frame_to_dma_interval = 0;
-        if (frame_start_time != 0)
-        {
-            int64_t interval = (int64_t)dma_complete_time - (int64_t)frame_start_time;
-            // 确保间隔在合理范围内（避免异常值）
-            if (interval >= 0 && interval <= 100000) // 最大100毫秒
-            {
-                frame_to_dma_interval = (int32_t)interval;
-            }
-        }
+    uint32_t completed = lcd_triple_buffer_retire_active(&buffer_state, spare_buffer);
+    internal_framebuffer_t *held = &frame_buffers[completed];
+    held->capturing = false;
+    held->ready = false;
+    held->frame_id = frame_id;
+    held->timestamp_us = timestamp_us;
+    held->frame_to_dma_interval_us = frame_to_dma_interval_us;
+    held->crc = crc;
+    held->crc_valid = crc_valid;
+
+    frame_buffers[spare_buffer].capturing = true;
+    pending_buffer = (int32_t)completed;
+    spare_buffer = free_buffer;
+    frame_buffers[spare_buffer].capturing = false;
+    frame_buffers[spare_buffer].ready = false;
+
+    if (capture_reset_needed)
+    {
+        resolve_pending_frame(false);
+    }
+    return spare_buffer;
+}
+
+// 丢弃监视状态机里的旧计数 (不用pio_sm_clear_fifos：那会连同TX FIFO里的期望值一起清掉)
+static void drain_monitor_fifos(void)
+{
+    while (!pio_sm_is_rx_fifo_empty(monitor_pio, monitor_line_sm))
+        pio_sm_get(monitor_pio, monitor_line_sm);
+    while (!pio_sm_is_rx_fifo_empty(monitor_pio, monitor_clock_sm))
+        pio_sm_get(monitor_pio, monitor_clock_sm);
+}
+
+// 读出监视状态机的计数，判定刚结束的帧
+// 行数来自lcd_line_monitor (每个FRAME边沿一个字)，异常行来自lcd_dataclk_monitor (只有异常行才有字)
+// captured_words: capture状态机为这一帧推送的字数 (每行240位，帧开头丢弃不足32位的残留)；
+// 有时钟数异常的行时状态机会跨行取时钟、跳过行，字数无法确定，返回-1
+static lcd_frame_status_t classify_frame(uint32_t lines, int32_t *captured_words)
+{
+    *captured_words = (int32_t)(lines * LCD_BYTES_PER_LINE / 4);
+
+    lcd_frame_status_t status = LCD_FRAME_VALID;
+    if (lines < LCD_HEIGHT)
+        status = LCD_FRAME_SHORT;
+    else if (lines > LCD_HEIGHT)
+        status = LCD_FRAME_LONG;
 
-        // 重置PIO状态机确保同步
-        // pio_sm_set_enabled(pio_instance, pio_sm, false);
-        // pio_sm_clear_fifos(pio_instance, pio_sm);
-        // pio_sm_restart(pio_instance, pio_sm);
-        // pio_sm_set_enabled(pio_instance, pio_sm, true);
+    while (!pio_sm_is_rx_fifo_empty(monitor_pio, monitor_clock_sm))
+    {
+        uint32_t clocks = pio_sm_get(monitor_pio, monitor_clock_sm);
+        integrity_stats.last_bad_clocks = clocks;
+        *captured_words = -1;
+        if (status == LCD_FRAME_VALID)
+            status = (clocks < LCD_CLOCKS_PER_LINE) ? LCD_FRAME_SHORT : LCD_FRAME_LONG;
+    }
+    return status;
+}
+
+static void configure_capture_channels(uint32_t prefilled_words, uint32_t crc);
+
+// 帧边沿重新同步：capture状态机刚刚自己在行首看到FRAME并执行了"irq 0"，已经对齐到本帧开头，
+// 错位的只是DMA。坏帧的字数由监视器的行数算出，两个通道的剩余计数给出从坏帧开头起一共搬运了多少字，
+// 多出来的就是本帧已经被搬走的前几个字：把它们移到active缓冲区开头，DMA从后面接着写。
+// DMA必须已经中止；completion_pending: capture_channel已经写满、完成中断还没处理，另一个通道正在写备用缓冲区。
+// 返回false表示无法确定位置 (字数未知、中断来得太晚)
+static bool realign_at_frame_edge(int32_t bad_frame_words, bool completion_pending, uint32_t *prefilled_words,
+                                  uint32_t *crc)
+{
+    static uint32_t carried[LCD_RESYNC_MAX_WORDS];
+    const uint32_t frame_words = LCD_FRAME_SIZE / 4;
+
+    if (bad_frame_words < 0)
+        return false;
+
+    // 坏帧开头以来DMA依次写过的缓冲区：暂存缓冲区 (已写满) -> active -> 备用缓冲区
+    const uint32_t *segments[3];
+    uint32_t count = 0;
+    uint32_t active = lcd_triple_buffer_active(&buffer_state);
+    if (pending_buffer >= 0)
+        segments[count++] = (const uint32_t *)frame_buffers[pending_buffer].data;
+    segments[count++] = (const uint32_t *)frame_buffers[active].data;
+    uint running = capture_channel;
+    if (completion_pending)
+    {
+        segments[count++] = (const uint32_t *)frame_buffers[spare_buffer].data;
+        running = (capture_channel == dma_channel) ? dma_channel_pong : dma_channel;
+    }
+    uint32_t moved = count * frame_words - dma_channel_hw_addr(running)->transfer_count;
+
+    int32_t early = (int32_t)moved - bad_frame_words;
+    if (early < 0 || early > LCD_RESYNC_MAX_WORDS)
+        return false;
+
+    for (int32_t i = 0; i < early; i++)
+    {
+        uint32_t pos = (uint32_t)(bad_frame_words + i);
+        carried[i] = segments[pos / frame_words][pos % frame_words];
+    }
+    memcpy(frame_buffers[active].data, carried, (size_t)early * 4);
 
-        critical_section_enter_blocking(&buffer_mutex);
+    *prefilled_words = (uint32_t)early;
+    *crc = crc32_update(LCD_FRAME_CRC_SEED, frame_buffers[active].data, (size_t)early * 4);
+    return true;
+}
 
-        // 完成当前缓冲区
-        frame_buffers[active_buffer].capturing = false;
-        frame_buffers[active_buffer].ready = true;
-        frame_buffers[active_buffer].frame_id = ++frame_counter;
-        frame_buffers[active_buffer].timestamp_us = time_us_64();
-        frame_buffers[active_buffer].frame_to_dma_interval_us = frame_to_dma_interval;
+// 快速重新同步：只重新对齐正在进行的捕获，display/render缓冲区和已经发布的帧保持不变，不打印
+// at_frame_edge: 在FRAME中断里调用，bad_frame_words是坏帧被捕获的字数 (-1 = 未知)，先尝试就地对齐本帧；
+// 做不到时 (或在DMA中断里发现错位) 重启状态机等下一个FRAME边沿，恢复时间不超过 (最长等于) 一个帧周期
+static void resync_capture(bool at_frame_edge, int32_t bad_frame_words)
+{
+    if (capture_reset_needed)
+        return;
 
-        // 三重缓冲区轮换：完成的缓冲区变成新的display_buffer
-        uint8_t completed_buffer = active_buffer;
+    uint64_t detected_us = at_frame_edge ? frame_start_time : time_us_64();
 
-        // 寻找下一个可用的缓冲区作为新的active_buffer
-        // (不能是render_buffer，因为显示系统可能在使用)
-        for (int i = 0; i < 3; i++)
+    // 连续几次重新同步之后仍然没有有效帧：交给显示循环完整重启
+    if (++consecutive_resyncs > LCD_RESYNC_ESCALATE)
+    {
+        capture_reset_needed = true;
+        recovery_started_us = detected_us;
+        if (pending_buffer >= 0)
+            resolve_pending_frame(false);
+        return;
+    }
+
+    // 通道刚写满、完成中断还没处理：DMA已经换到另一个通道 (INTS0受INTE0屏蔽，要在关中断之前读)
+    bool completion_pending = dma_channel_get_irq0_status(capture_channel);
+
+    capture_seq_begin();
+    capture_restarts++;
+
+    dma_channel_set_irq0_enabled(dma_channel, false);
+    dma_channel_set_irq0_enabled(dma_channel_pong, false);
+    dma_channel_abort(dma_channel);
+    dma_channel_abort(dma_channel_pong);
+
+    uint32_t prefilled_words = 0;
+    uint32_t crc = LCD_FRAME_CRC_SEED;
+    bool realigned = at_frame_edge &&
+                     realign_at_frame_edge(bad_frame_words, completion_pending, &prefilled_words, &crc);
+
+    dma_channel_acknowledge_irq0(dma_channel);
+    dma_channel_acknowledge_irq0(dma_channel_pong);
+
+    if (!realigned)
+    {
+        pio_sm_set_enabled(pio_instance, pio_sm, false);
+        pio_sm_clear_fifos(pio_instance, pio_sm);
+        pio_sm_restart(pio_instance, pio_sm);
+        pio_sm_exec(pio_instance, pio_sm, pio_encode_jmp(0));
+        monitor_synced = false; // 正在进行的这一帧不会被捕获，跳过它的判定
+    }
+
+    // 暂存帧属于错位的捕获，丢弃；active缓冲区里的残帧直接被覆盖
+    if (pending_buffer >= 0)
+        resolve_pending_frame(false);
+    configure_capture_channels(prefilled_words, crc);
+
+    dma_channel_set_irq0_enabled(dma_channel, true);
+    dma_channel_set_irq0_enabled(dma_channel_pong, true);
+    dma_channel_start(dma_channel);
+    capture_seq_end();
+
+    if (realigned)
+    {
+        recovery_stats.edge_resyncs++;
+        record_recovery(detected_us, time_us_64());
+    }
+    else
+    {
+        pio_sm_set_enabled(pio_instance, pio_sm, true);
+        recovery_stats.wait_resyncs++;
+        recovery_waiting = true;
+        recovery_started_us = detected_us;
+    }
+}
+
+// FRAME边沿 (PIO中断)：给上一帧下判定。正常情况下DMA在帧间消隐期内完成，判定时上一帧已经暂存；
+// 到FRAME边沿DMA还没写满 (短帧、丢字) 说明捕获字数和帧边界不一致，即使行数正常也不可信
+static void judge_finished_frames(void)
+{
+    bool resync = false;
+    int32_t bad_frame_words = -1;
+    uint32_t verdicts = 0;
+
+    while (!pio_sm_is_rx_fifo_empty(monitor_pio, monitor_line_sm))
+    {
+        uint32_t lines = pio_sm_get(monitor_pio, monitor_line_sm);
+        int32_t captured_words;
+        lcd_frame_status_t status = classify_frame(lines, &captured_words);
+        if (!monitor_synced)
         {
-            if (i != render_buffer && i != completed_buffer)
-            {
-                active_buffer = i;
-                break;
-            }
+            monitor_synced = true;
+            continue;
         }
 
-        display_buffer = completed_buffer;
+        if (status == LCD_FRAME_VALID && pending_buffer < 0)
+            status = LCD_FRAME_SHORT;
+
+        integrity_stats.last_lines = lines;
+        if (status == LCD_FRAME_SHORT)
+            integrity_stats.short_frames++;
+        else if (status == LCD_FRAME_LONG)
+            integrity_stats.long_frames++;
+        else
+            integrity_stats.valid++;
+
+        // 坏帧的暂存缓冲区先留给resync_capture：末尾可能已经是新一帧的开头，搬回之后再丢弃
+        if (pending_buffer >= 0 && (status == LCD_FRAME_VALID || verdicts > 0))
+            resolve_pending_frame(status == LCD_FRAME_VALID && !resync);
+
+        if (status == LCD_FRAME_VALID)
+            consecutive_resyncs = 0;
+        else
+            resync = true;
+        bad_frame_words = captured_words;
+        verdicts++;
+    }
 
-        // 准备下一个缓冲区
-        frame_buffers[active_buffer].capturing = true;
-        frame_buffers[active_buffer].ready = false;
-        // 重新配置DMA到新缓冲区
-        dma_channel_set_write_addr(dma_channel, frame_buffers[active_buffer].data, false);
-        dma_channel_set_trans_count(dma_channel, LCD_FRAME_SIZE / 4, true);
+    // 状态机已经对齐到刚开始的这一帧，把DMA也对齐过来
+    // (一次取到多个判定说明漏过FRAME中断，坏帧的起点不可信)
+    if (resync)
+        resync_capture(true, verdicts == 1 ? bad_frame_words : -1);
+}
 
-        critical_section_exit(&buffer_mutex);
+// 一个捕获通道写完一帧：另一个通道已经由chain触发接管下一帧
+static void capture_channel_complete(uint finished)
+{
+    uint running = (finished == dma_channel) ? dma_channel_pong : dma_channel;
+
+    // 计算从帧开始到DMA完成的时间间隔
+    uint64_t dma_complete_time = time_us_64();
+    int32_t frame_to_dma_interval = 0;
+    if (frame_start_time != 0)
+    {
+        int64_t interval = (int64_t)dma_complete_time - (int64_t)frame_start_time;
+        // 确保间隔在合理范围内（避免异常值）
+        if (interval >= 0 && interval <= 100000) // 最大100毫秒
+        {
+            frame_to_dma_interval = (int32_t)interval;
+        }
     }
+
+    // 嗅探器只跟踪一个通道：读出完成帧的CRC，切到正在运行的通道并重新置种子。
+    // 中断在帧间消隐期内到达时新通道还没搬运数据，CRC完整；来得太晚时只把新帧的CRC标记为无效，
+    // 数据本身不会丢 (去重时无效CRC的帧一律按脏行比较)
+    uint32_t frame_crc = dma_sniffer_get_data_accumulator();
+    bool frame_crc_valid = capture_crc_valid;
+    dma_sniffer_enable(running, DMA_SNIFF_CTRL_CALC_VALUE_CRC32, false);
+    dma_sniffer_set_data_accumulator(LCD_FRAME_CRC_SEED);
+    capture_crc_valid = dma_channel_hw_addr(running)->transfer_count == LCD_FRAME_SIZE / 4;
+
+    capture_seq_begin();
+    capture_channel = running;
+    uint32_t spare = integrity_monitor_enabled
+                         ? hold_active_buffer(++frame_counter, time_us_64(), frame_to_dma_interval,
+                                              frame_crc, frame_crc_valid)
+                         : complete_active_buffer(++frame_counter, time_us_64(), frame_to_dma_interval,
+                                                  frame_crc, frame_crc_valid);
+    capture_seq_end();
+
+    // 空闲通道装填再下一帧的目标地址，不触发 (由正在运行的通道完成时chain触发)
+    dma_channel_set_write_addr(finished, frame_buffers[spare].data, false);
+    dma_channel_set_trans_count(finished, LCD_FRAME_SIZE / 4, false);
 }
 
-// 初始化自动捕获DMA系统
-bool lcd_framebuffer_init_auto_capture(PIO pio, uint sm)
+// DMA中断处理函数 - 只做帧完成记账和缓冲区轮换，不在捕获数据通路上
+static void dma_capture_irq_handler(void)
 {
-    if (!framebuffer_initialized || auto_capture_enabled)
+    // 先处理当前通道：中断被延迟超过一帧时两个通道可能同时挂起
+    uint order[2] = {capture_channel, (capture_channel == dma_channel) ? dma_channel_pong : dma_channel};
+
+    for (int i = 0; i < 2; i++)
     {
-        return false;
+        uint ch = order[i];
+        if (!dma_channel_get_irq0_status(ch))
+            continue;
+
+        dma_channel_acknowledge_irq0(ch);
+
+        if (!auto_capture_enabled)
+        {
+            continue;
+        }
+
+        capture_channel_complete(ch);
     }
 
-    pio_instance = pio;
-    pio_sm = sm;
+    if (resync_after_completion)
+    {
+        resync_after_completion = false;
+        resync_capture(false, -1);
+    }
+}
 
-    // 配置DMA通道
+// 配置乒乓捕获通道：乒写active缓冲区，乓写备用缓冲区，互相chain (不启动)
+// prefilled_words/crc: 帧边沿重新同步时active缓冲区开头已经放好的字数及其CRC，DMA从后面接着写
+static void configure_capture_channels(uint32_t prefilled_words, uint32_t crc)
+{
     dma_channel_config config = dma_channel_get_default_config(dma_channel);
     channel_config_set_transfer_data_size(&config, DMA_SIZE_32);
-    channel_config_set_dreq(&config, pio_get_dreq(pio, sm, false));
+    channel_config_set_dreq(&config, pio_get_dreq(pio_instance, pio_sm, false));
     channel_config_set_read_increment(&config, false);
     channel_config_set_write_increment(&config, true);
+    channel_config_set_sniff_enable(&config, true); // 嗅探器计算帧CRC，零CPU开销
 
-    // 设置初始传输到活动缓冲区
-    critical_section_enter_blocking(&buffer_mutex);
-    frame_buffers[active_buffer].capturing = true;
-    frame_buffers[active_buffer].ready = false;
-    frame_buffers[active_buffer].timestamp_us = time_us_64();
+    internal_framebuffer_t *active = &frame_buffers[lcd_triple_buffer_active(&buffer_state)];
+    active->capturing = true;
+    active->ready = false;
+    active->timestamp_us = time_us_64();
 
+    channel_config_set_chain_to(&config, dma_channel_pong);
     dma_channel_configure(
         dma_channel, &config,
-        frame_buffers[active_buffer].data,
-        &pio->rxf[sm],
+        active->data + prefilled_words * 4,
+        &pio_instance->rxf[pio_sm],
+        LCD_FRAME_SIZE / 4 - prefilled_words,
+        false);
+
+    channel_config_set_chain_to(&config, dma_channel);
+    dma_channel_configure(
+        dma_channel_pong, &config,
+        frame_buffers[spare_buffer].data,
+        &pio_instance->rxf[pio_sm],
         LCD_FRAME_SIZE / 4,
         false);
-    critical_section_exit(&buffer_mutex);
 
-    // 设置DMA中断
+    capture_channel = dma_channel;
+    capture_crc_valid = true;
+    dma_sniffer_enable(dma_channel, DMA_SNIFF_CTRL_CALC_VALUE_CRC32, false);
+    dma_sniffer_set_data_accumulator(crc);
+}
+
+// 初始化自动捕获DMA系统
+bool lcd_framebuffer_init_auto_capture(PIO pio, uint sm)
+{
+    if (!framebuffer_initialized || auto_capture_enabled)
+    {
+        return false;
+    }
+
+    pio_instance = pio;
+    pio_sm = sm;
+
+    // 设置初始传输到活动缓冲区 (DMA中断尚未启用，没有并发)
+    configure_capture_channels(0, LCD_FRAME_CRC_SEED);
+
+    // 设置DMA中断 (两个通道共用DMA_IRQ_0)
     dma_channel_set_irq0_enabled(dma_channel, true);
+    dma_channel_set_irq0_enabled(dma_channel_pong, true);
     irq_set_exclusive_handler(DMA_IRQ_0, dma_capture_irq_handler);
     irq_set_enabled(DMA_IRQ_0, true);
 
@@ -219,6 +676,45 @@ bool lcd_framebuffer_init_auto_capture(PIO pio, uint sm)
     return true;
 }
 
+// 启用逐帧完整性判定 (监视状态机由调用者加载并启动)
+bool lcd_framebuffer_init_integrity_monitor(PIO pio, uint line_sm, uint clock_sm)
+{
+    if (!framebuffer_initialized || !auto_capture_enabled)
+    {
+        return false;
+    }
+
+    monitor_pio = pio;
+    monitor_line_sm = line_sm;
+    monitor_clock_sm = clock_sm;
+    monitor_synced = false;
+    capture_reset_needed = false;
+    consecutive_resyncs = 0;
+    memset(&integrity_stats, 0, sizeof(integrity_stats));
+    memset(&recovery_stats, 0, sizeof(recovery_stats));
+    drain_monitor_fifos();
+
+    integrity_monitor_enabled = true;
+    return true;
+}
+
+void lcd_framebuffer_get_integrity_stats(lcd_frame_integrity_stats_t *stats)
+{
+    if (stats)
+        *stats = integrity_stats;
+}
+
+void lcd_framebuffer_get_recovery_stats(lcd_capture_recovery_stats_t *stats)
+{
+    if (stats)
+        *stats = recovery_stats;
+}
+
+bool lcd_framebuffer_capture_needs_reset(void)
+{
+    return capture_reset_needed;
+}
+
 // DMA控制函数组
 bool lcd_framebuffer_start_auto_capture(void)
 {
@@ -240,12 +736,12 @@ bool lcd_framebuffer_stop_auto_capture(void)
     if (!auto_capture_enabled)
         return false;
 
-    dma_channel_abort(dma_channel);
     dma_channel_set_irq0_enabled(dma_channel, false);
+    dma_channel_set_irq0_enabled(dma_channel_pong, false);
+    dma_channel_abort(dma_channel);
+    dma_channel_abort(dma_channel_pong);
 
-    critical_section_enter_blocking(&buffer_mutex);
-    frame_buffers[active_buffer].capturing = false;
-    critical_section_exit(&buffer_mutex);
+    frame_buffers[lcd_triple_buffer_active(&buffer_state)].capturing = false;
 
     auto_capture_enabled = false;
     return true;
@@ -253,47 +749,343 @@ bool lcd_framebuffer_stop_auto_capture(void)
 
 bool lcd_framebuffer_is_auto_capturing(void)
 {
-    return auto_capture_enabled && dma_channel_is_busy(dma_channel);
+    return auto_capture_enabled && (dma_channel_is_busy(dma_channel) || dma_channel_is_busy(dma_channel_pong));
 }
 
 uint32_t lcd_framebuffer_get_frame_count(void) { return frame_counter; }
 
-// 准备安全的显示帧 (三重缓冲指针轮换，无数据拷贝)
+uint32_t lcd_framebuffer_get_superseded_count(void) { return frames_superseded; }
+
+// 显示端还没取走的新帧 (送显节拍器据此判断错过的时隙)
+bool lcd_framebuffer_has_new_frame(void)
+{
+    return framebuffer_initialized && lcd_triple_buffer_has_new(&buffer_state);
+}
+
+// 准备安全的显示帧 (三重缓冲索引原子轮换，无数据拷贝)
+// 只在DMA完成新帧后返回true；不加锁，DMA中断可以随时发布新帧
 bool lcd_framebuffer_prepare_display_frame(void)
 {
-    if (!framebuffer_initialized)
+    if (!framebuffer_initialized || render_held)
         return false;
 
-    critical_section_enter_blocking(&buffer_mutex);
+    // 有新帧时display -> render，render缓冲区在下一次获取前归显示系统独占
+    return lcd_triple_buffer_acquire(&buffer_state);
+}
+
+// 送显异步进行时，渲染缓冲区在DMA读完之前不能换出 (换出后生产者会回收它)
+void lcd_framebuffer_hold_render(void)
+{
+    render_held = true;
+}
+
+// 可以在中断里调用：只清除标志，下一次 prepare_display_frame 才轮换缓冲区
+void lcd_framebuffer_release_render(void)
+{
+    render_held = false;
+}
+
+bool lcd_framebuffer_is_render_held(void)
+{
+    return render_held;
+}
+
+// =============================================================================
+// 捕获到送显的延迟
+// =============================================================================
+static void record_latency(uint32_t done_us, uint32_t capture_end_us)
+{
+    int32_t latency = (int32_t)(done_us - capture_end_us);
+    if (latency < 0)
+        latency = 0; // 追帧时最后一个变化的带可能在帧捕获完之前就发送完了
+
+    latency_stats.frames++;
+    latency_stats.last_us = (uint32_t)latency;
+    latency_stats.total_us += (uint32_t)latency;
+    if ((uint32_t)latency > latency_stats.max_us)
+        latency_stats.max_us = (uint32_t)latency;
+}
+
+// 显示循环把一帧 (或追帧时的一个带) 交给驱动；final = 这一帧之后不会再有变化的行
+static void output_submitted(uint32_t frame_id, bool final, uint32_t capture_end_us)
+{
+    output_inflight = true;
+    output_final = final;
+    output_frame_id = frame_id;
+    output_capture_end_us = capture_end_us;
+}
 
-    // 检查显示缓冲区是否有新数据
-    if (!frame_buffers[display_buffer].ready)
+void lcd_framebuffer_output_complete(uint32_t end_us)
+{
+    output_inflight = false;
+    output_done_us = end_us;
+    if (output_final)
     {
-        critical_section_exit(&buffer_mutex);
-        return false;
+        output_final = false;
+        record_latency(end_us, output_capture_end_us);
+    }
+}
+
+void lcd_framebuffer_get_latency_stats(lcd_output_latency_stats_t *stats)
+{
+    if (stats)
+        *stats = latency_stats;
+}
+
+// 与上次送显帧逐字异或，得到 [y0, y1) 行的脏行位图并同步影子副本 (y0、y1为偶数)
+// 每行30字节不是4字节对齐，按两行(60字节 = 15个字)一组处理：
+// 字0-6属于偶数行；字7的低16位(字节28-29)属于偶数行、高16位属于奇数行；字8-14属于奇数行
+static void compute_dirty_rows(const uint8_t *frame, uint32_t y0, uint32_t y1, lcd_dirty_rows_t *dirty)
+{
+    const uint32_t *cur = (const uint32_t *)(frame + y0 * LCD_BYTES_PER_LINE);
+    uint32_t *prev = (uint32_t *)(displayed_shadow + y0 * LCD_BYTES_PER_LINE);
+
+    memset(dirty->bits, 0, sizeof(dirty->bits));
+
+    for (uint32_t y = y0; y < y1; y += 2, cur += 15, prev += 15)
+    {
+        uint32_t even = 0;
+        uint32_t odd = 0;
+        for (int w = 0; w < 7; w++)
+            even |= cur[w] ^ prev[w];
+        uint32_t mid = cur[7] ^ prev[7];
+        even |= mid & 0x0000FFFFu;
+        odd |= mid & 0xFFFF0000u;
+        for (int w = 8; w < 15; w++)
+            odd |= cur[w] ^ prev[w];
+
+        if (even | odd)
+        {
+            if (even)
+                lcd_dirty_row_set(dirty, y);
+            if (odd)
+                lcd_dirty_row_set(dirty, y + 1);
+            memcpy(prev, cur, 15 * sizeof(uint32_t));
+        }
     }
+}
+
+// 准备显示帧并与上次送显的帧比较CRC：内容没有变化时返回false，调用者可跳过转换和SPI传输
+// 内容变化时同时生成脏行位图 (lcd_framebuffer_get_dirty_rows)
+bool lcd_framebuffer_prepare_changed_frame(void)
+{
+    if (!lcd_framebuffer_prepare_display_frame())
+        return false;
+
+    const internal_framebuffer_t *buffer = &frame_buffers[lcd_triple_buffer_render(&buffer_state)];
+    uint32_t crc = buffer->crc;
 
-    // 简单的指针轮换：display_buffer -> render_buffer
-    // 无需数据拷贝，零开销
-    render_buffer = display_buffer;
+    if (displayed_crc_valid && buffer->crc_valid && crc == displayed_crc)
+    {
+        frames_skipped++;
+        return false;
+    }
 
-    // 现在render_buffer指向有效数据，保持ready状态
-    // 不需要修改ready标志，因为数据本来就是ready的
+    if (shadow_valid)
+    {
+        compute_dirty_rows(buffer->data, 0, LCD_HEIGHT, &dirty_rows);
 
-    // 注意：不要设置frame_buffers[display_buffer].ready = false
-    // 因为render_buffer现在指向同一个缓冲区
+        // CRC无效的帧 (嗅探器漏掉了帧开头) 由逐字比较决定是否跳过
+        if (!buffer->crc_valid && lcd_framebuffer_count_dirty_rows(&dirty_rows) == 0)
+        {
+            displayed_crc_valid = false;
+            frames_skipped++;
+            return false;
+        }
+    }
+    else
+    {
+        // 首帧或强制重绘：全部行都需要送显
+        memset(dirty_rows.bits, 0xFF, sizeof(dirty_rows.bits));
+        memcpy(displayed_shadow, buffer->data, LCD_FRAME_SIZE);
+        shadow_valid = true;
+    }
 
-    critical_section_exit(&buffer_mutex);
+    displayed_crc = crc;
+    displayed_crc_valid = buffer->crc_valid;
+    frames_shown++;
+    output_submitted(buffer->frame_id, true, (uint32_t)buffer->timestamp_us);
     return true;
 }
 
+const lcd_dirty_rows_t *lcd_framebuffer_get_dirty_rows(void)
+{
+    return &dirty_rows;
+}
+
+uint32_t lcd_framebuffer_count_dirty_rows(const lcd_dirty_rows_t *dirty)
+{
+    uint32_t count = 0;
+    for (int i = 0; i < 8; i++)
+        count += __builtin_popcount(dirty->bits[i]);
+    return count;
+}
+
+// 下一帧无条件送显 (显示器重新初始化、内容被其它代码改写后调用)
+void lcd_framebuffer_force_redraw(void)
+{
+    displayed_crc_valid = false;
+    shadow_valid = false;
+}
+
+// =============================================================================
+// 追帧送显 (race the beam)
+// =============================================================================
+// 捕获进度快照：中断正在修改时重读，读到的帧号、缓冲区、通道和写指针属于同一帧
+typedef struct
+{
+    uint32_t completed; // 已完成的帧数 (frame_counter)
+    uint32_t restarts;
+    uint32_t buffer;    // 正在捕获的缓冲区
+    uint32_t rows;      // 已经写进缓冲区的整行数
+} capture_progress_t;
+
+static void read_capture_progress(capture_progress_t *progress)
+{
+    uint32_t seq;
+    uintptr_t write_addr;
+    do
+    {
+        seq = atomic_load_explicit(&capture_seq, memory_order_acquire);
+        progress->completed = frame_counter;
+        progress->restarts = capture_restarts;
+        progress->buffer = lcd_triple_buffer_active(&buffer_state);
+        write_addr = (uintptr_t)dma_channel_hw_addr(capture_channel)->write_addr;
+        atomic_thread_fence(memory_order_acquire);
+    } while ((seq & 1) || seq != atomic_load_explicit(&capture_seq, memory_order_relaxed));
+
+    uintptr_t start = (uintptr_t)frame_buffers[progress->buffer].data;
+    uint32_t bytes = write_addr > start ? (uint32_t)(write_addr - start) : 0;
+    progress->rows = bytes >= LCD_FRAME_SIZE ? LCD_HEIGHT : bytes / LCD_BYTES_PER_LINE;
+}
+
+// 跟随的帧完成了，最后一段没有变化：延迟记到这一帧最后发送的带上
+static void beam_frame_finished_clean(uint32_t capture_end_us)
+{
+    if (output_frame_id != beam.frame_id)
+        return; // 这一帧没有任何变化的行
+    if (output_inflight)
+    {
+        output_final = true;
+        output_capture_end_us = capture_end_us;
+    }
+    else
+    {
+        record_latency(output_done_us, capture_end_us);
+    }
+}
+
+bool lcd_framebuffer_beam_next_band(const uint8_t **data, lcd_dirty_rows_t *rows)
+{
+    if (!framebuffer_initialized || !auto_capture_enabled || data == NULL || rows == NULL)
+        return false;
+
+    // 跟随的帧完成且最后一段没有变化时，接着看正在捕获的下一帧
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+        capture_progress_t progress;
+        read_capture_progress(&progress);
+
+        // 捕获重新同步过，或者下一帧也已经完成 (跟随帧的缓冲区可能已经被回收)：放弃这一帧。
+        // 落后一整帧、或者已经送出一部分 (屏上留着半帧) 才算放弃，还没开始的帧重新同步后本来就不存在
+        if (beam.following && (progress.restarts != beam.restarts || progress.completed > beam.frame_id))
+        {
+            if (progress.completed > beam.frame_id || beam.rows_done > 0)
+                latency_stats.overruns++;
+            beam.following = false;
+        }
+        if (!beam.following)
+        {
+            beam.following = true;
+            beam.frame_id = progress.completed + 1;
+            beam.buffer = progress.buffer;
+            beam.restarts = progress.restarts;
+            beam.rows_done = 0;
+            beam.redraw = false;
+        }
+        // 首帧或强制重绘 (也可能发生在跟随途中)：影子副本不可信，整帧送出
+        if (!shadow_valid && !beam.redraw)
+        {
+            beam.redraw = true;
+            beam.rows_done = 0;
+        }
+
+        bool complete = progress.completed >= beam.frame_id;
+        uint32_t band_end;
+        if (complete)
+            band_end = LCD_HEIGHT;
+        else if (beam.redraw)
+            return false;
+        else
+            band_end = progress.rows / LCD_BEAM_BAND_ROWS * LCD_BEAM_BAND_ROWS;
+        if (band_end <= beam.rows_done)
+            return false;
+
+        const internal_framebuffer_t *buffer = &frame_buffers[beam.buffer];
+        if (beam.redraw)
+        {
+            memset(rows->bits, 0xFF, sizeof(rows->bits));
+            rows->bits[7] = (1u << (LCD_HEIGHT - 224)) - 1; // 只有240行
+            memcpy(displayed_shadow, buffer->data, LCD_FRAME_SIZE);
+            shadow_valid = true;
+        }
+        else
+        {
+            compute_dirty_rows(buffer->data, beam.rows_done, band_end, rows);
+        }
+        beam.rows_done = band_end;
+        displayed_crc_valid = false; // 跳过了CRC去重，下一次整帧比较只能逐字进行
+
+        bool changed = lcd_framebuffer_count_dirty_rows(rows) > 0;
+        uint32_t capture_end_us = (uint32_t)buffer->timestamp_us;
+        if (complete)
+        {
+            beam.following = false;
+            if (changed || output_frame_id == beam.frame_id)
+                frames_shown++;
+            else
+                frames_skipped++;
+        }
+
+        if (changed)
+        {
+            *data = buffer->data;
+            latency_stats.bands++;
+            output_submitted(beam.frame_id, complete, capture_end_us);
+            return true;
+        }
+        if (!complete)
+            return false;
+        beam_frame_finished_clean(capture_end_us);
+    }
+    return false;
+}
+
+void lcd_framebuffer_get_dedup_stats(uint32_t *shown, uint32_t *skipped)
+{
+    if (shown)
+        *shown = frames_shown;
+    if (skipped)
+        *skipped = frames_skipped;
+}
+
+uint32_t lcd_framebuffer_get_render_crc(void)
+{
+    return frame_buffers[lcd_triple_buffer_render(&buffer_state)].crc;
+}
+
+bool lcd_framebuffer_is_render_crc_valid(void)
+{
+    return frame_buffers[lcd_triple_buffer_render(&buffer_state)].crc_valid;
+}
+
 // =============================================================================
 // 显示缓冲区管理和像素访问 (集中管理)
 // =============================================================================
 // 检查渲染缓冲区是否就绪（由prepare_display_frame准备）
 bool lcd_framebuffer_is_render_ready(void)
 {
-    return framebuffer_initialized && frame_buffers[render_buffer].ready;
+    return framebuffer_initialized && frame_buffers[lcd_triple_buffer_render(&buffer_state)].ready;
 }
 // 高性能直接数据访问（用于优化显示）
 const uint8_t *lcd_framebuffer_get_render_data(void)
@@ -301,20 +1093,53 @@ const uint8_t *lcd_framebuffer_get_render_data(void)
     if (!framebuffer_initialized)
         return NULL;
 
-    const internal_framebuffer_t *buffer = &frame_buffers[render_buffer];
+    const internal_framebuffer_t *buffer = &frame_buffers[lcd_triple_buffer_render(&buffer_state)];
     if (!buffer->ready)
         return NULL;
 
     return buffer->data;
 }
 
+// 获取渲染缓冲区的帧数据和元信息 (帧序号、时间戳)
+bool lcd_framebuffer_get_render_frame(lcd_framebuffer_t *frame)
+{
+    if (!framebuffer_initialized || frame == NULL)
+        return false;
+
+    internal_framebuffer_t *buffer = &frame_buffers[lcd_triple_buffer_render(&buffer_state)];
+    if (!buffer->ready)
+        return false;
+
+    frame->data = buffer->data;
+    frame->ready = buffer->ready;
+    frame->capturing = buffer->capturing;
+    frame->frame_id = buffer->frame_id;
+    frame->timestamp_us = buffer->timestamp_us;
+    return true;
+}
+
+// 外部提交一帧 (捕获文件回放)，与DMA完成走相同的三重缓冲轮换
+bool lcd_framebuffer_submit_frame(const uint8_t *data, uint32_t frame_id,
+                                  uint64_t timestamp_us, int32_t frame_to_dma_interval_us)
+{
+    // 自动捕获运行时active缓冲区归DMA所有，不能写入
+    if (!framebuffer_initialized || auto_capture_enabled || data == NULL)
+        return false;
+
+    memcpy(frame_buffers[lcd_triple_buffer_active(&buffer_state)].data, data, LCD_FRAME_SIZE);
+    frame_counter++;
+    complete_active_buffer(frame_id, timestamp_us, frame_to_dma_interval_us,
+                           lcd_framebuffer_crc32(data, LCD_FRAME_SIZE), true);
+    return true;
+}
+
 // 获取帧时序信息用于偏移检测
 int32_t lcd_framebuffer_get_frame_to_dma_interval(void)
 {
     if (!framebuffer_initialized)
         return 0;
 
-    const internal_framebuffer_t *buffer = &frame_buffers[render_buffer];
+    const internal_framebuffer_t *buffer = &frame_buffers[lcd_triple_buffer_render(&buffer_state)];
     if (!buffer->ready)
         return 0;
 
@@ -329,11 +1154,12 @@ bool lcd_framebuffer_reset_capture_system(void)
 
     printf("⚠️  检测到帧异常，正在重启捕获系统...\n");
 
-    critical_section_enter_blocking(&buffer_mutex);
-
-    // 1. 停止并重置DMA
-    dma_channel_abort(dma_channel);
+    // 1. 停止并重置两个乒乓DMA通道 (先关中断，之后不会再有生产者发布或判定)
+    pio_set_irq0_source_enabled(pio_instance, pis_interrupt0, false);
     dma_channel_set_irq0_enabled(dma_channel, false);
+    dma_channel_set_irq0_enabled(dma_channel_pong, false);
+    dma_channel_abort(dma_channel);
+    dma_channel_abort(dma_channel_pong);
 
     // 2. 停止PIO状态机
     pio_sm_set_enabled(pio_instance, pio_sm, false);
@@ -349,39 +1175,47 @@ bool lcd_framebuffer_reset_capture_system(void)
     // 5. 手动跳转到wait_frame (确保从等待FRAME开始)
     pio_sm_exec(pio_instance, pio_sm, pio_encode_jmp(0));
 
-    // 6. 清理缓冲区状态
-    for (int i = 0; i < 3; i++)
+    // 6. 等待判定的暂存帧属于被中止的捕获，直接回收
+    if (pending_buffer >= 0)
     {
-        frame_buffers[i].capturing = false;
-        frame_buffers[i].ready = false;
-        frame_buffers[i].frame_to_dma_interval_us = 0;
+        free_buffer = (uint32_t)pending_buffer;
+        pending_buffer = -1;
     }
 
-    // 7. 重置缓冲区指针到初始状态
-    active_buffer = 0;
-    display_buffer = 1;
-    render_buffer = 2;
-
-    // 8. 重新配置DMA到活动缓冲区
-    dma_channel_config config = dma_channel_get_default_config(dma_channel);
-    channel_config_set_transfer_data_size(&config, DMA_SIZE_32);
-    channel_config_set_dreq(&config, pio_get_dreq(pio_instance, pio_sm, false));
-    channel_config_set_read_increment(&config, false);
-    channel_config_set_write_increment(&config, true);
-
-    dma_channel_configure(
-        dma_channel, &config,
-        frame_buffers[active_buffer].data,
-        &pio_instance->rxf[pio_sm],
-        LCD_FRAME_SIZE / 4,
-        false);
+    // 7. 只清理生产者持有的缓冲区 (active/备用/空闲)；display/render属于显示端，索引和内容都不动，
+    //    显示循环可以在另一个核上继续渲染，不需要和复位同步
+    uint32_t producer_buffers[3] = {lcd_triple_buffer_active(&buffer_state), spare_buffer, free_buffer};
+    for (int i = 0; i < 3; i++)
+    {
+        frame_buffers[producer_buffers[i]].capturing = false;
+        frame_buffers[producer_buffers[i]].ready = false;
+        frame_buffers[producer_buffers[i]].frame_to_dma_interval_us = 0;
+    }
 
+    // 帧完整性监视从下一个FRAME边沿重新开始计数
+    if (integrity_monitor_enabled)
+    {
+        drain_monitor_fifos();
+        monitor_synced = false;
+    }
+    resync_after_completion = false;
+    consecutive_resyncs = 0;
+    if (!capture_reset_needed)
+        recovery_started_us = time_us_64();
+    capture_reset_needed = false;
+    recovery_stats.full_resets++;
+    recovery_waiting = true;
+
+    // 8. 重新配置乒乓通道到活动/备用缓冲区，嗅探器重新置种子 (丢弃被中止帧的部分CRC)
     // 9. 标记活动缓冲区为捕获状态
-    frame_buffers[active_buffer].capturing = true;
-    frame_buffers[active_buffer].ready = false;
+    capture_seq_begin();
+    capture_restarts++;
+    configure_capture_channels(0, LCD_FRAME_CRC_SEED);
+    capture_seq_end();
 
     // 10. 重新启用DMA中断
     dma_channel_set_irq0_enabled(dma_channel, true);
+    dma_channel_set_irq0_enabled(dma_channel_pong, true);
 
     // 11. 先启动DMA（确保数据接收准备就绪）
     dma_channel_start(dma_channel);
@@ -396,8 +1230,6 @@ bool lcd_framebuffer_reset_capture_system(void)
     frame_start_time = 0;
     last_dma_complete_time = 0;
 
-    critical_section_exit(&buffer_mutex);
-
     printf("✅ 捕获系统重启完成，恢复正常工作\n");
     return true;
 }
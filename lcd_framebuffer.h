@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include "hardware/pio.h"
 
 
@@ -15,6 +16,47 @@ typedef struct {
     uint64_t timestamp_us;
 } lcd_framebuffer_t;
 
+// Per-frame dirty-row bitmap: bit y set = source row y differs from the
+// last displayed frame. Produced by lcd_framebuffer_prepare_changed_frame().
+typedef struct {
+    uint32_t bits[8];           // 240 rows, bit (y & 31) of bits[y >> 5]
+} lcd_dirty_rows_t;
+
+static inline bool lcd_dirty_row_test(const lcd_dirty_rows_t* dirty, uint32_t y) {
+    return (dirty->bits[y >> 5] >> (y & 31)) & 1u;
+}
+
+static inline void lcd_dirty_row_set(lcd_dirty_rows_t* dirty, uint32_t y) {
+    dirty->bits[y >> 5] |= 1u << (y & 31);
+}
+
+// Capture integrity verdict for one frame, from the monitor state machines
+// in lcd_capture.pio (LINECLK count per frame, DATACLK count per line)
+typedef enum {
+    LCD_FRAME_VALID = 0,        // 240 lines of 60 DATACLKs
+    LCD_FRAME_SHORT = 1,        // fewer lines, or a line with fewer clocks
+    LCD_FRAME_LONG  = 2         // more lines, or a line with more clocks
+} lcd_frame_status_t;
+
+typedef struct {
+    uint32_t valid;
+    uint32_t short_frames;
+    uint32_t long_frames;
+    uint32_t dropped;           // completed captures never published
+    uint32_t last_lines;        // LINECLK count of the last judged frame
+    uint32_t last_bad_clocks;   // DATACLK count of the last bad line
+} lcd_frame_integrity_stats_t;
+
+// How often each capture recovery path ran, and how long recovery took
+typedef struct {
+    uint32_t edge_resyncs;      // DMA realigned in the FRAME IRQ that reported the bad frame
+    uint32_t wait_resyncs;      // capture SM restarted to wait for the next FRAME edge
+    uint32_t full_resets;       // lcd_framebuffer_reset_capture_system()
+    uint32_t last_recovery_us;  // bad frame detected -> capture running from a frame start
+    uint32_t max_recovery_us;   // <= one frame period: an edge resync is immediate, a
+                                // wait resync takes exactly one frame (next FRAME edge)
+} lcd_capture_recovery_stats_t;
+
 // Initialize frame buffer system
 bool lcd_framebuffer_init(void);
 
@@ -25,10 +67,70 @@ bool lcd_framebuffer_start_auto_capture(void);
 bool lcd_framebuffer_stop_auto_capture(void);
 bool lcd_framebuffer_is_auto_capturing(void);
 uint32_t lcd_framebuffer_get_frame_count(void);
+// Frames replaced by a newer one before the display loop took them (the
+// triple buffer only keeps the newest published frame)
+uint32_t lcd_framebuffer_get_superseded_count(void);
+// True when a published frame is waiting for prepare_display_frame
+bool lcd_framebuffer_has_new_frame(void);
 
 // Safe display functions (triple buffering)
 bool lcd_framebuffer_prepare_display_frame(void);
 
+// Render buffer ownership for asynchronous display: a driver holds the render
+// buffer while a submitted frame still reads it and releases it from its DMA
+// completion IRQ. prepare_display_frame/prepare_changed_frame return false
+// while it is held, so the next frame waits instead of recycling the buffer.
+void lcd_framebuffer_hold_render(void);
+void lcd_framebuffer_release_render(void);
+bool lcd_framebuffer_is_render_held(void);
+
+// Frame dedup: like prepare_display_frame, but returns false when the new
+// frame's CRC equals the last displayed frame (skip conversion and SPI).
+// The CRC comes for free from the DMA sniffer on the capture channel.
+bool lcd_framebuffer_prepare_changed_frame(void);
+void lcd_framebuffer_force_redraw(void);
+
+void lcd_framebuffer_get_dedup_stats(uint32_t* shown, uint32_t* skipped);
+uint32_t lcd_framebuffer_get_render_crc(void);
+// False when the capture IRQ ran so late that the sniffer missed the start of the frame
+bool lcd_framebuffer_is_render_crc_valid(void);
+
+// Rows of the prepared render frame that changed since the last displayed
+// frame (all rows after force_redraw or for the first frame).
+const lcd_dirty_rows_t* lcd_framebuffer_get_dirty_rows(void);
+uint32_t lcd_framebuffer_count_dirty_rows(const lcd_dirty_rows_t* dirty);
+
+// Race-the-beam output: instead of waiting for a complete frame, the display
+// loop follows the capture DMA write pointer and sends each band of rows as
+// soon as it has landed. Returns the next band: the rows of the frame being
+// captured that landed since the previous band (whole bands of 24 rows, the
+// remainder once the frame completes) and differ from what is on the panel.
+// After force_redraw the frame is handed out whole once it completes. *data
+// points into the capture buffer and stays valid until the next frame
+// completes; drivers may only read the rows set in *rows. Call only while the
+// output is idle. Frames are neither CRC-deduplicated nor held for the
+// integrity verdict, so a frame later judged bad may reach the panel.
+bool lcd_framebuffer_beam_next_band(const uint8_t** data, lcd_dirty_rows_t* rows);
+
+// Capture-to-output latency: from the end of a frame's capture (DMA
+// completion) to the last changed row of that frame leaving the display bus
+typedef struct {
+    uint32_t frames;            // frames measured (frames with changed rows)
+    uint32_t last_us;
+    uint32_t max_us;
+    uint64_t total_us;
+    uint32_t bands;             // race-the-beam bands handed out
+    uint32_t overruns;          // followed frames abandoned: output a frame behind or capture resynced
+} lcd_output_latency_stats_t;
+
+// Display drivers call this when a submitted frame or band has left the bus
+void lcd_framebuffer_output_complete(uint32_t end_us);
+void lcd_framebuffer_get_latency_stats(lcd_output_latency_stats_t* stats);
+
+// Software CRC-32 fallback (sniffer CRC32 mode: MSB-first, poly 0x04C11DB7, seed 0xFFFFFFFF).
+// CRCs are only compared against frames from the same source, never across sources.
+uint32_t lcd_framebuffer_crc32(const uint8_t* data, size_t len);
+
 bool lcd_framebuffer_is_render_ready(void);
 // High-performance direct data access (for optimized display)
 const uint8_t* lcd_framebuffer_get_render_data(void);
@@ -36,10 +138,35 @@ const uint8_t* lcd_framebuffer_get_render_data(void);
 // Frame interrupt functions
 void lcd_capture_frame_irq_enable(PIO pio);
 
+// Render buffer data plus frame_id/timestamp (for capture dump)
+bool lcd_framebuffer_get_render_frame(lcd_framebuffer_t* frame);
+
+// Feed a frame into the triple buffer without PIO/DMA (capture file replay).
+// Only valid while auto-capture is not running.
+bool lcd_framebuffer_submit_frame(const uint8_t* data, uint32_t frame_id,
+                                  uint64_t timestamp_us, int32_t frame_to_dma_interval_us);
+
 // Get frame timing information (for offset detection)
 int32_t lcd_framebuffer_get_frame_to_dma_interval(void);
 
-// Reset PIO state machine and DMA (for error recovery)
+// Per-frame integrity checking. The monitor SMs must already be running
+// lcd_line_monitor / lcd_dataclk_monitor. Once enabled, each completed capture
+// is held until the next FRAME edge delivers its verdict; bad frames are
+// dropped before display and the in-flight capture is resynced from the IRQ
+// without touching the display/render buffers. Call after init_auto_capture,
+// before start.
+bool lcd_framebuffer_init_integrity_monitor(PIO pio, uint line_sm, uint clock_sm);
+void lcd_framebuffer_get_integrity_stats(lcd_frame_integrity_stats_t* stats);
+// Fast resyncs recover in at most one frame period, not strictly less: the
+// wait path cannot restart capture before the next FRAME edge.
+void lcd_framebuffer_get_recovery_stats(lcd_capture_recovery_stats_t* stats);
+// True when several fast resyncs in a row produced no valid frame: every
+// completion is dropped until lcd_framebuffer_reset_capture_system() runs
+bool lcd_framebuffer_capture_needs_reset(void);
+
+// Reset PIO state machine and DMA (for error recovery). Only producer-owned
+// buffers are touched, so call it from the core that services the capture
+// IRQs; the display loop may keep rendering on the other core.
 bool lcd_framebuffer_reset_capture_system(void);
 
 // Wait for LCD power on signal (GPIO 1)
@@ -0,0 +1,128 @@
+// =============================================================================
+// PIO显示链路：带命令/数据标记的字节流 + DMA控制块表
+// 整屏刷新只启动一次DMA，CPU不再逐页切换CS/A0、重新配置DMA
+// =============================================================================
+#include "lcd_link.h"
+#include "hardware/dma.h"
+#include "hardware/clocks.h"
+#include "lcd_link.pio.h"
+#include <stdio.h>
+
+bool lcd_link_init(lcd_link_t *link, PIO pio, uint pin_dc, uint pin_cs, uint pin_sck, uint pin_mosi,
+                   uint baudrate)
+{
+    link->sm = -1;
+    link->ctrl_channel = -1;
+    link->data_channel = -1;
+
+    // SET引脚从A0开始：CS在位1或位2 (程序里 "set pins, 6" 拉高CS)
+    if (pin_cs != pin_dc + 1 && pin_cs != pin_dc + 2)
+        return false;
+    if (!pio_can_add_program(pio, &lcd_link_program))
+        return false;
+    int sm = pio_claim_unused_sm(pio, false);
+    if (sm < 0)
+        return false;
+    int ctrl_channel = dma_claim_unused_channel(false);
+    int data_channel = dma_claim_unused_channel(false);
+    if (ctrl_channel < 0 || data_channel < 0)
+    {
+        if (ctrl_channel >= 0)
+            dma_channel_unclaim((uint)ctrl_channel);
+        if (data_channel >= 0)
+            dma_channel_unclaim((uint)data_channel);
+        pio_sm_unclaim(pio, (uint)sm);
+        return false;
+    }
+    uint offset = pio_add_program(pio, &lcd_link_program);
+
+    pio_sm_config c = lcd_link_program_get_default_config(offset);
+    sm_config_set_out_pins(&c, pin_mosi, 1);
+    sm_config_set_set_pins(&c, pin_dc, pin_cs - pin_dc + 1);
+    sm_config_set_sideset_pins(&c, pin_sck);
+    sm_config_set_out_shift(&c, false, false, 32); // 左移：8位DMA写入复制到4个字节通道，取最高字节
+    sm_config_set_mov_status(&c, STATUS_TX_LESSTHAN, 1);
+    // 每个SCK周期8个状态机周期，不超过原SPI波特率
+    float div = (float)clock_get_hz(clk_sys) / (8.0f * baudrate);
+    sm_config_set_clkdiv(&c, div < 1.0f ? 1.0f : div);
+
+    // 空闲电平：CS高，SCK/A0/MOSI低 (夹在A0和CS之间的引脚不归PIO管，写入被忽略)
+    uint32_t pin_mask = (1u << pin_dc) | (1u << pin_cs) | (1u << pin_sck) | (1u << pin_mosi);
+    pio_sm_set_pins_with_mask(pio, (uint)sm, 1u << pin_cs, pin_mask);
+    pio_sm_set_pindirs_with_mask(pio, (uint)sm, pin_mask, pin_mask);
+    pio_gpio_init(pio, pin_dc);
+    pio_gpio_init(pio, pin_cs);
+    pio_gpio_init(pio, pin_sck);
+    pio_gpio_init(pio, pin_mosi);
+    pio_sm_init(pio, (uint)sm, offset, &c);
+    pio_sm_set_enabled(pio, (uint)sm, true);
+
+    // 数据通道：字节 -> TX FIFO，完成后链回控制通道取下一个控制块
+    dma_channel_config dc = dma_channel_get_default_config((uint)data_channel);
+    channel_config_set_transfer_data_size(&dc, DMA_SIZE_8);
+    channel_config_set_read_increment(&dc, true);
+    channel_config_set_write_increment(&dc, false);
+    channel_config_set_dreq(&dc, pio_get_dreq(pio, (uint)sm, true));
+    channel_config_set_chain_to(&dc, (uint)ctrl_channel);
+    channel_config_set_irq_quiet(&dc, true);
+    dma_channel_configure((uint)data_channel, &dc, &pio->txf[sm], NULL, 0, false);
+
+    // 控制通道：每次把一个控制块写进数据通道的AL3别名 (写环绕回到AL3_TRANS_COUNT)，
+    // 写READ_ADDR_TRIG触发数据通道；{0, NULL}是空触发，表到此结束
+    dma_channel_config cc = dma_channel_get_default_config((uint)ctrl_channel);
+    channel_config_set_transfer_data_size(&cc, DMA_SIZE_32);
+    channel_config_set_read_increment(&cc, true);
+    channel_config_set_write_increment(&cc, true);
+    channel_config_set_ring(&cc, true, __builtin_ctz(sizeof(lcd_link_block_t)));
+    channel_config_set_irq_quiet(&cc, true);
+    dma_channel_configure((uint)ctrl_channel, &cc, &dma_hw->ch[data_channel].al3_transfer_count, NULL,
+                          sizeof(lcd_link_block_t) / sizeof(uint32_t), false);
+
+    link->pio = pio;
+    link->sm = sm;
+    link->ctrl_channel = ctrl_channel;
+    link->data_channel = data_channel;
+    link->pin_cs = pin_cs;
+    printf("✅ PIO显示链路: pio%u SM%d, DMA通道%d(控制)/%d(数据)\n", pio_get_index(pio), sm, ctrl_channel,
+           data_channel);
+    return true;
+}
+
+void lcd_link_start(const lcd_link_t *link, const lcd_link_block_t *blocks)
+{
+    lcd_link_wait(link);
+    dma_channel_set_read_addr((uint)link->ctrl_channel, blocks, true);
+}
+
+bool lcd_link_busy(const lcd_link_t *link)
+{
+    if (dma_channel_is_busy((uint)link->ctrl_channel) || dma_channel_is_busy((uint)link->data_channel))
+        return true;
+    if (!pio_sm_is_tx_fifo_empty(link->pio, (uint)link->sm))
+        return true;
+    // FIFO空了还要等最后一个字节移出：程序只在FIFO取空、回到idle时拉高CS
+    return !gpio_get(link->pin_cs);
+}
+
+void lcd_link_wait(const lcd_link_t *link)
+{
+    while (lcd_link_busy(link))
+    {
+        tight_loop_contents();
+    }
+}
+
+void lcd_link_write(const lcd_link_t *link, bool is_data, const uint8_t *data, size_t len)
+{
+    lcd_link_wait(link);
+    while (len > 0)
+    {
+        size_t seg = len < LCD_LINK_SEGMENT_MAX ? len : LCD_LINK_SEGMENT_MAX;
+        pio_sm_put_blocking(link->pio, (uint)link->sm, lcd_link_header(is_data, seg) * 0x01010101u);
+        for (size_t i = 0; i < seg; i++)
+            pio_sm_put_blocking(link->pio, (uint)link->sm, data[i] * 0x01010101u);
+        data += seg;
+        len -= seg;
+    }
+    lcd_link_wait(link);
+}
@@ -0,0 +1,54 @@
+#ifndef LCD_LINK_H
+#define LCD_LINK_H
+
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// PIO显示链路 (lcd_link.pio)：A0(D/C)、CS、SCK、MOSI全部由状态机驱动。
+// 字节流按段组织，每段以1字节段头开始 (见 lcd_link_header)，段头选择命令/数据。
+// 一次刷新 (寻址命令 + 页数据) 写成一张DMA控制块表：控制通道依次把 {字节数, 地址}
+// 写进数据通道的AL3别名并触发它，数据通道完成后再链回控制通道，直到遇到 {0, NULL}。
+
+// 每段最多128字节
+#define LCD_LINK_SEGMENT_MAX 128
+
+// DMA控制块：布局与数据通道的 {AL3_TRANS_COUNT, AL3_READ_ADDR_TRIG} 相同
+typedef struct {
+    uint32_t transfer_count;
+    const volatile void *read_addr;
+} lcd_link_block_t;
+
+typedef struct {
+    PIO pio;
+    int sm;
+    int ctrl_channel;
+    int data_channel;
+    uint pin_cs;
+} lcd_link_t;
+
+// 段头：[7] = 1数据/0命令，[6:0] = 字节数 - 1
+static inline uint8_t lcd_link_header(bool is_data, uint32_t len)
+{
+    return (uint8_t)((is_data ? 0x80u : 0x00u) | (len - 1));
+}
+
+// 初始化链路并把4个引脚切换给PIO (pin_cs 必须是 pin_dc + 1 或 pin_dc + 2)
+// PIO/DMA资源不足时返回false，引脚保持原样
+bool lcd_link_init(lcd_link_t *link, PIO pio, uint pin_dc, uint pin_cs, uint pin_sck, uint pin_mosi,
+                   uint baudrate);
+
+// 启动一张控制块表 (以 {0, NULL} 结尾)，立即返回；表和它引用的数据在传输结束前不能修改
+void lcd_link_start(const lcd_link_t *link, const lcd_link_block_t *blocks);
+
+// 上一次传输是否还没结束 (DMA未完成或最后一个字节还没移出)
+bool lcd_link_busy(const lcd_link_t *link);
+
+// 等待上一次传输结束 (CS已拉高)
+void lcd_link_wait(const lcd_link_t *link);
+
+// CPU直接发送一段命令或数据 (先等待链路空闲，发送完成后返回)
+void lcd_link_write(const lcd_link_t *link, bool is_data, const uint8_t *data, size_t len);
+
+#endif // LCD_LINK_H
@@ -2,7 +2,11 @@
 #include "hardware/spi.h"
 #include "hardware/gpio.h"
 #include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
 #include "frame_stats.h"
+#include "lcd_link.h"
+#include "lcd_config.h"
 #include <string.h>
 #include <stdio.h>
 
@@ -21,35 +25,176 @@
 #define SPI_PORT spi1
 #define SPI_BAUDRATE 20000000
 
-// 帧显存：30页 x 320列 = 9600字节
+// 输出链路：A0/CS/SCK/MOSI由pio1驱动，一次刷新 (寻址命令 + 页数据) 是一张DMA控制块表，
+// 启动后立即返回；PIO/DMA资源不足时退回SPI控制器逐页发送
+#ifndef ST75320_PIO_LINK
+#define ST75320_PIO_LINK 1
+#endif
+#define LCD_LINK_PIO pio1
+
+// 显示RAM：30页 x 320列 = 9600字节
 #define FB_PAGES 30
 #define FB_COLS 320
 #define FB_SIZE (FB_PAGES * FB_COLS)
 
-static uint8_t framebuffer[FB_SIZE];
+#if ST75320_PAGE_PIPELINE
+// 页流水线：没有整帧显存，转换内核轮流写两个页缓冲，一页在线上时转换下一页
+#define PAGE_RING_SLOTS 2
+static uint8_t page_ring[PAGE_RING_SLOTS][FB_COLS] __attribute__((aligned(4))); // 转换内核按字写入
+static int page_ring_slot = 0; // 下一个可写的页缓冲 (另一个可能还在发送)
+#else
+static uint8_t framebuffer[FB_SIZE] __attribute__((aligned(4))); // 转换内核按字写入
+#endif
 static int dma_chan;
 static frame_stats_t lcd_stats;
+static const char *const rotation_names[4] = {"0°", "90°", "180°", "270°"};
 static lcd_rotation_t current_rotation = LCD_ROTATION_0;
 
+// 转换内核的软件变换：旋转角度里控制器镜像做不到的部分
+typedef enum {
+    SW_IDENTITY,      // 8个源行 -> 一页，列不变
+    SW_FLIP,          // 180°：页序、行序、列方向都相反
+    SW_TRANSPOSE,     // 源行 -> 目标列，源字节 -> 页字节 (纯转置，没有任何反转)
+    SW_TRANSPOSE_90,  // 转置 + 列方向相反
+    SW_TRANSPOSE_270, // 转置 + 页序、位序相反
+    SW_TRANSFORM_COUNT
+} sw_transform_t;
+
+static const struct {
+    bool transposed;  // 源行变成目标列
+    bool mirror_cols; // 目标列方向相反
+    bool flip_rows;   // 目标页序、页内位序相反
+    const char *name;
+} sw_transforms[SW_TRANSFORM_COUNT] = {
+    [SW_IDENTITY] = {false, false, false, "按行"},
+    [SW_FLIP] = {false, true, true, "按行+行列反转"},
+    [SW_TRANSPOSE] = {true, false, false, "转置"},
+    [SW_TRANSPOSE_90] = {true, true, false, "转置+列反转"},
+    [SW_TRANSPOSE_270] = {true, false, true, "转置+行反转"},
+};
+
+// 旋转 = 控制器镜像 (0xA0列地址反向、0xC8行扫描反向，刷新时不花CPU时间) + 剩下的软件变换。
+// 镜像两个方向可以任意组合，所以每个角度都能只留下最便宜的软件变换：
+// 180° = 0°的按行转换 + 水平垂直镜像；90°/270° = 纯转置 + 一个方向的镜像。
+// 关闭硬件镜像时回到原来的纯软件重映射 (控制器不镜像)，作为参考路径
+#ifndef ST75320_HARDWARE_MIRRORING
+#define ST75320_HARDWARE_MIRRORING 1
+#endif
+static bool hardware_mirroring = ST75320_HARDWARE_MIRRORING;
+
+typedef struct {
+    sw_transform_t transform;
+    lcd_mirror_t mirror;
+} orientation_plan_t;
+
+static const orientation_plan_t orientation_plans[2][4] = {
+    // 纯软件
+    {{SW_IDENTITY, LCD_MIRROR_NORMAL},
+     {SW_TRANSPOSE_90, LCD_MIRROR_NORMAL},
+     {SW_FLIP, LCD_MIRROR_NORMAL},
+     {SW_TRANSPOSE_270, LCD_MIRROR_NORMAL}},
+    // 硬件镜像 + 最便宜的软件变换
+    {{SW_IDENTITY, LCD_MIRROR_NORMAL},
+     {SW_TRANSPOSE, LCD_MIRROR_H},
+     {SW_IDENTITY, LCD_MIRROR_HV},
+     {SW_TRANSPOSE, LCD_MIRROR_V}},
+};
+static sw_transform_t current_transform = SW_IDENTITY;
+
 // 预计算的缩放映射表
 static uint16_t scale_map_240_to_320[240];
 // 预计算X坐标缩放映射表 (0°和180°用)
 static uint16_t x_scale_map[240];
 static bool scale_fill_map[240];  // 是否需要填充相邻像素
 
-// 90°/270°优化预计算表
-static uint8_t y_to_page[240];     // Y坐标 -> page索引
-static uint8_t y_to_bit_mask[240]; // Y坐标 -> bit掩码
-static uint16_t y_to_fb_offset[240]; // Y坐标 -> framebuffer偏移量基址
-
 // 水平320像素直接查表 (超级优化)
 static uint16_t horizontal_320_map[240]; // 240像素直接映射到320的位置
 static uint16_t horizontal_320_fill[240]; // 对应的填充位置
 
 static bool scale_map_initialized = false;
 
+// 图像占用的显示RAM列数：不缩放时只用前240列
+#if ENABLE_LCD_SCALING
+#define IMAGE_COLS 320
+#else
+#define IMAGE_COLS 240
+#endif
+// 列地址反向时RAM第c列显示在第319-c列：不缩放时转换结果整体右移80列，图像仍落在原来的240列上
+static uint16_t ram_col_offset = 0;
+
+// 270°的页字节是源字节的位反转
+static uint8_t bit_reverse_table[256];
+
+#if ENABLE_LCD_SCALING
+// 4/3水平缩放展开表：一组3个源字节 (24像素) -> 32个目标像素，按组内字节位置分表，三次查表或起来。
+// 源像素 x=3k -> 列4k，3k+1 -> 4k+1/4k+2，3k+2 -> 4k+2/4k+3；bit q = 组内第q列
+static uint32_t scale_expand[3][256];
+static uint32_t scale_expand_flip[3][256]; // 180°：组内列倒序 (bit q = 组内第31-q列)
+#endif
+
+// 1-bit -> 页格式转换内核
+static lcd_convert_kernel_t convert_kernel = LCD_CONVERT_TRANSPOSE;
+
+// 局部刷新：本次需要重新生成的源行，以及旋转改变后强制整屏刷新
+static lcd_dirty_rows_t redraw_rows;
+static bool force_full_update = true;
+
+// PIO链路：每页一组寻址命令 + 最多3个数据段头 (跨页连续写入时更少)
+// 整帧显存时一次刷新是一张表，按 (页, 列窗口) 缓存；页流水线时每次只发一页
+#define LINK_PAGE_CMD_BYTES 14
+#define LINK_BLOCKS_PER_PAGE 6
+#if ST75320_PAGE_PIPELINE
+#define LINK_LIST_PAGES 1
+#else
+#define LINK_LIST_PAGES FB_PAGES
+#endif
+static lcd_link_t link;
+static bool link_ready = false;
+static bool link_active = false;
+static uint8_t link_cmd_bytes[LINK_LIST_PAGES * LINK_PAGE_CMD_BYTES]; // 寻址命令和段头
+static lcd_link_block_t link_blocks[LINK_LIST_PAGES * LINK_BLOCKS_PER_PAGE + 1];
+#if !ST75320_PAGE_PIPELINE
+static bool link_list_valid = false;
+static uint32_t link_list_pages;
+static uint16_t link_list_col0, link_list_col1;
+#endif
+
+// 整页宽度的连续页只寻址一次，靠控制器地址自动递增跨页写入 (lcd_set_contiguous_refresh)
+#ifndef ST75320_CONTIGUOUS_REFRESH
+#define ST75320_CONTIGUOUS_REFRESH 1
+#endif
+static bool contiguous_refresh = ST75320_CONTIGUOUS_REFRESH;
+
+// SPI控制器发送：最后一页的DMA可能还在进行 (CS为低)
+static bool spi_page_busy = false;
+
+// 输出异步进行：修改显存/页缓冲或发命令之前等上一次发送结束
+static void lcd_wait_output(void)
+{
+    if (link_active)
+    {
+        lcd_link_wait(&link);
+        return;
+    }
+    if (!spi_page_busy)
+        return;
+    dma_channel_wait_for_finish_blocking(dma_chan);
+    while (spi_is_busy(SPI_PORT))
+    {
+        tight_loop_contents();
+    }
+    gpio_put(PIN_CS, 1);
+    spi_page_busy = false;
+}
+
 static void lcd_write_command(uint8_t cmd)
 {
+    if (link_active)
+    {
+        lcd_link_write(&link, false, &cmd, 1);
+        return;
+    }
+    lcd_wait_output();
     gpio_put(PIN_CS, 0);
     gpio_put(PIN_A0, 0);
     spi_write_blocking(SPI_PORT, &cmd, 1);
@@ -58,6 +203,12 @@ static void lcd_write_command(uint8_t cmd)
 
 static void lcd_write_data(uint8_t data)
 {
+    if (link_active)
+    {
+        lcd_link_write(&link, true, &data, 1);
+        return;
+    }
+    lcd_wait_output();
     gpio_put(PIN_CS, 0);
     gpio_put(PIN_A0, 1);
     spi_write_blocking(SPI_PORT, &data, 1);
@@ -75,15 +226,40 @@ static void init_scale_mapping(void)
         x_scale_map[i] = (i * 4) / 3;
         scale_fill_map[i] = (i % 3) != 0;  // 预计算是否需要填充
 
-        // 90°/270°预计算Y坐标相关信息
-        y_to_page[i] = i / 8;
-        y_to_bit_mask[i] = (1 << (i % 8));
-        y_to_fb_offset[i] = (i / 8) * FB_COLS;
-
         // 水平320像素直接映射
         horizontal_320_map[i] = (i * 4) / 3;
         horizontal_320_fill[i] = ((i % 3) != 0) ? ((i * 4) / 3 + 1) : 0; // 填充位置或0
     }
+    for (int i = 0; i < 256; i++)
+    {
+        uint8_t r = 0;
+        for (int b = 0; b < 8; b++)
+            r |= ((i >> b) & 1) << (7 - b);
+        bit_reverse_table[i] = r;
+    }
+#if ENABLE_LCD_SCALING
+    for (int byte = 0; byte < 3; byte++)
+    {
+        for (int v = 0; v < 256; v++)
+        {
+            uint32_t word = 0;
+            for (int b = 0; b < 8; b++)
+            {
+                if (!(v & (1 << b)))
+                    continue;
+                int x = byte * 8 + b;
+                word |= 1u << ((x * 4) / 3);
+                if (x % 3 != 0)
+                    word |= 1u << ((x * 4) / 3 + 1);
+            }
+            scale_expand[byte][v] = word;
+            uint32_t flipped = 0;
+            for (int q = 0; q < 32; q++)
+                flipped |= ((word >> q) & 1u) << (31 - q);
+            scale_expand_flip[byte][v] = flipped;
+        }
+    }
+#endif
     scale_map_initialized = true;
 }
 
@@ -190,28 +366,50 @@ void lcd_init(void)
 
     // 初始化DMA
     dma_chan = dma_claim_unused_channel(true);
+#if ST75320_PIO_LINK
+    lcd_set_pio_link(true);
+#endif
 
     // 初始化缩放映射表
     init_scale_mapping();
 
     // 初始化帧统计 (ST75320: 240x240 = 7.2KB 显示数据)
     frame_stats_init(&lcd_stats, "ST75320", 7.2f);
+    frame_stats_set_variants(&lcd_stats, rotation_names, 4);
     lcd_set_rotation(LCD_ROTATION_90);
     lcd_clear();
     lcd_write_command(0xAF); // 显示开启
-    lcd_refresh();
+    lcd_wait_output();
 }
 
+static void span_send_start(bool address, int page, uint16_t col0, const uint8_t *data, uint32_t count);
+
 void lcd_clear(void)
 {
+    lcd_wait();
+    lcd_wait_output();
+#if ST75320_PAGE_PIPELINE
+    // 没有整帧显存：同一个全0页缓冲发送30次 (连续写入时只在第0页寻址)
+    uint8_t *zero_page = page_ring[page_ring_slot];
+    memset(zero_page, 0x00, FB_COLS);
+    for (int page = 0; page < FB_PAGES; page++)
+        span_send_start(page == 0 || !contiguous_refresh, page, 0, zero_page, FB_COLS);
+    page_ring_slot = (page_ring_slot + 1) % PAGE_RING_SLOTS;
+#else
     memset(framebuffer, 0x00, FB_SIZE);
+    lcd_refresh();
+#endif
 }
 
+#if !ST75320_PAGE_PIPELINE
+
 void lcd_set_pixel(uint16_t x, uint16_t y, bool color)
 {
     if (x >= LCD_WIDTH || y >= LCD_HEIGHT)
         return;
 
+    lcd_wait();
+    lcd_wait_output();
     uint8_t page = y / 8;
     uint8_t bit_pos = y % 8;
     uint16_t fb_index = page * FB_COLS + x;
@@ -249,631 +447,788 @@ void lcd_draw_rect(uint16_t x, uint16_t y, uint16_t width, uint16_t height, bool
     }
 }
 
-void lcd_refresh(void)
+#endif
+
+// 一段连续写入的控制块：[寻址命令 +] 数据 (按128字节分段，段头之间插入)
+// address为false时不发寻址命令，接着控制器当前的地址写 (见 span_send_start)
+// 寻址命令和段头依次存进*cmd_pool并推进它；返回下一个空闲控制块
+static lcd_link_block_t *link_build_span(lcd_link_block_t *block, uint8_t **cmd_pool, bool address, int page,
+                                         uint16_t col0, const uint8_t *data, uint32_t count)
 {
-    for (int page = 0; page < FB_PAGES; page++)
+    uint8_t *cmd = *cmd_pool;
+    uint32_t n = 0;
+    if (address)
+    {
+        cmd[n++] = lcd_link_header(false, 1);
+        cmd[n++] = 0xB1; // 设置页地址
+        cmd[n++] = lcd_link_header(true, 1);
+        cmd[n++] = page;
+        cmd[n++] = lcd_link_header(false, 1);
+        cmd[n++] = 0x13; // 设置起始列地址 (第1字节bit0为X8，第2字节为X7..X0)
+        cmd[n++] = lcd_link_header(true, 2);
+        cmd[n++] = col0 >> 8;
+        cmd[n++] = col0 & 0xFF;
+        cmd[n++] = lcd_link_header(false, 1);
+        cmd[n++] = 0x1D; // 进入数据写入模式
+    }
+
+    for (uint32_t offset = 0; offset < count; offset += LCD_LINK_SEGMENT_MAX)
+    {
+        uint32_t len = count - offset;
+        if (len > LCD_LINK_SEGMENT_MAX)
+            len = LCD_LINK_SEGMENT_MAX;
+        cmd[n] = lcd_link_header(true, len);
+        if (offset == 0)
+            *block++ = (lcd_link_block_t){n + 1, cmd};
+        else
+            *block++ = (lcd_link_block_t){1, &cmd[n]};
+        n++;
+        *block++ = (lcd_link_block_t){len, data + offset};
+    }
+    *cmd_pool = cmd + n;
+    return block;
+}
+
+// 发送count字节：address为true时先设置 (page, col0) 并进入数据写入模式，
+// 否则接着上一次写入的地址继续 (0x84列方向写入时列地址自动加1，写完第319列进入下一页第0列，
+// 所以从第0列开始的整页数据可以跨页连续发送)。先等上一次发送结束，启动后立即返回
+static void span_send_start(bool address, int page, uint16_t col0, const uint8_t *data, uint32_t count)
+{
+    lcd_wait_output();
+
+#if ST75320_PAGE_PIPELINE
+    if (link_active)
+    {
+        uint8_t *cmd_pool = link_cmd_bytes;
+        lcd_link_block_t *end = link_build_span(link_blocks, &cmd_pool, address, page, col0, data, count);
+        *end = (lcd_link_block_t){0, NULL}; // 空触发，表到此结束
+        lcd_link_start(&link, link_blocks);
+        return;
+    }
+#endif
+
+    if (address)
     {
         // 设置页地址
         lcd_write_command(0xB1);
         lcd_write_data(page);
 
-        // 设置列地址为0
+        // 设置起始列地址 (第1字节bit0为X8，第2字节为X7..X0)
         lcd_write_command(0x13);
-        lcd_write_data(0x00);
-        lcd_write_data(0x00);
+        lcd_write_data(col0 >> 8);
+        lcd_write_data(col0 & 0xFF);
 
         // 进入数据写入模式
         lcd_write_command(0x1D);
+    }
 
-        // 使用DMA传输一页数据
-        gpio_put(PIN_CS, 0);
-        gpio_put(PIN_A0, 1);
+    // 使用DMA传输数据，CS在 lcd_wait_output 中拉高
+    gpio_put(PIN_CS, 0);
+    gpio_put(PIN_A0, 1);
 
-        dma_channel_config c = dma_channel_get_default_config(dma_chan);
-        channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
-        channel_config_set_dreq(&c, spi_get_dreq(SPI_PORT, true));
-        channel_config_set_read_increment(&c, true);
-        channel_config_set_write_increment(&c, false);
+    dma_channel_config c = dma_channel_get_default_config(dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_dreq(&c, spi_get_dreq(SPI_PORT, true));
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+
+    dma_channel_configure(
+        dma_chan,
+        &c,
+        &spi_get_hw(SPI_PORT)->dr,
+        data,
+        count,
+        true);
+    spi_page_busy = true;
+}
 
-        dma_channel_configure(
-            dma_chan,
-            &c,
-            &spi_get_hw(SPI_PORT)->dr,
-            &framebuffer[page * FB_COLS],
-            FB_COLS,
-            true);
+#if !ST75320_PAGE_PIPELINE
+// page_mask中从first开始的连续页 (整页宽度且允许连续写入时才合并)，返回最后一页
+static int page_run_end(uint32_t page_mask, int first, bool full_width)
+{
+    int last = first;
+    if (full_width && contiguous_refresh)
+    {
+        while (last + 1 < FB_PAGES && (page_mask & (1u << (last + 1))))
+            last++;
+    }
+    return last;
+}
 
-        dma_channel_wait_for_finish_blocking(dma_chan);
+// 生成整帧控制块表 (page_mask中的页，每页只发送 [col0, col1] 列)
+static void link_build_list(uint32_t page_mask, uint16_t col0, uint16_t col1)
+{
+    if (link_list_valid && link_list_pages == page_mask && link_list_col0 == col0 && link_list_col1 == col1)
+        return;
 
-        while (spi_is_busy(SPI_PORT))
+    uint16_t col_count = col1 - col0 + 1;
+    bool full_width = (col_count == FB_COLS);
+    lcd_link_block_t *block = link_blocks;
+    uint8_t *cmd_pool = link_cmd_bytes;
+    for (int page = 0; page < FB_PAGES; page++)
+    {
+        if (!(page_mask & (1u << page)))
+            continue;
+        int last = page_run_end(page_mask, page, full_width);
+        block = link_build_span(block, &cmd_pool, true, page, col0, &framebuffer[page * FB_COLS + col0],
+                                (uint32_t)(last - page + 1) * col_count);
+        page = last;
+    }
+    *block = (lcd_link_block_t){0, NULL}; // 空触发，表到此结束
+
+    link_list_valid = true;
+    link_list_pages = page_mask;
+    link_list_col0 = col0;
+    link_list_col1 = col1;
+}
+
+#endif
+
+// 源像素x在水平方向占用的目标列 [lo, hi] (mirror：列方向相反)
+static __force_inline void scaled_columns(int x, bool mirror, uint16_t *lo, uint16_t *hi)
+{
+#if ENABLE_LCD_SCALING
+    uint16_t a = horizontal_320_map[x];
+    uint16_t b = horizontal_320_fill[x] ? a + 1 : a;
+    *lo = mirror ? 319 - b : a;
+    *hi = mirror ? 319 - a : b;
+#else
+    *lo = *hi = mirror ? 239 - x : x;
+#endif
+}
+
+// 源行src_y在转置变换后占用的显示RAM列 [lo, hi]
+static void rotated_row_columns(int src_y, uint16_t *lo, uint16_t *hi)
+{
+    scaled_columns(src_y, sw_transforms[current_transform].mirror_cols, lo, hi);
+    *lo += ram_col_offset;
+    *hi += ram_col_offset;
+}
+
+// 根据脏行确定需要重新生成的源行 (redraw_rows)、要发送的页和列窗口
+// 按行变换 (0°/180°)：源行与目标页一一对应，按8行一页扩展，只刷新变化的页
+// 转置变换 (90°/270°)：源行变成目标列，每页只发送覆盖所有脏行的列窗口
+// 返回false表示没有需要刷新的内容
+static bool plan_dirty_update(const lcd_dirty_rows_t *dirty, uint32_t *page_mask,
+                              uint16_t *col0, uint16_t *col1)
+{
+    if (dirty == NULL)
+    {
+        memset(redraw_rows.bits, 0xFF, sizeof(redraw_rows.bits));
+        *page_mask = (1u << FB_PAGES) - 1;
+        *col0 = 0;
+        *col1 = FB_COLS - 1;
+        return true;
+    }
+
+    memset(redraw_rows.bits, 0, sizeof(redraw_rows.bits));
+    *page_mask = 0;
+
+    if (!sw_transforms[current_transform].transposed)
+    {
+        for (int src_page = 0; src_page < FB_PAGES; src_page++)
         {
-            tight_loop_contents();
+            // 一页8行正好落在同一个32位字内
+            uint32_t page_bits = (dirty->bits[src_page >> 2] >> ((src_page & 3) * 8)) & 0xFF;
+            if (page_bits == 0)
+                continue;
+
+            int dst_page = sw_transforms[current_transform].flip_rows ? (FB_PAGES - 1 - src_page) : src_page;
+            redraw_rows.bits[src_page >> 2] |= 0xFFu << ((src_page & 3) * 8);
+            *page_mask |= 1u << dst_page;
         }
+        *col0 = 0;
+        *col1 = FB_COLS - 1;
+        return *page_mask != 0;
+    }
 
-        gpio_put(PIN_CS, 1);
+    int y_min = -1;
+    int y_max = -1;
+    for (int y = 0; y < 240; y++)
+    {
+        if (lcd_dirty_row_test(dirty, y))
+        {
+            if (y_min < 0)
+                y_min = y;
+            y_max = y;
+        }
     }
+    if (y_min < 0)
+        return false;
+
+#if ENABLE_LCD_SCALING
+    // 4/3缩放时每3个源行共用4列 (填充列与相邻行重叠)，按组扩展保证共用列完整重绘
+    y_min = (y_min / 3) * 3;
+    y_max = (y_max / 3) * 3 + 2;
+    if (y_max > 239)
+        y_max = 239;
+#endif
+
+    uint16_t lo_a, hi_a, lo_b, hi_b;
+    rotated_row_columns(y_min, &lo_a, &hi_a);
+    rotated_row_columns(y_max, &lo_b, &hi_b);
+    *col0 = (lo_a < lo_b) ? lo_a : lo_b;
+    *col1 = (hi_a > hi_b) ? hi_a : hi_b;
+
+    for (int y = y_min; y <= y_max; y++)
+        lcd_dirty_row_set(&redraw_rows, y);
+
+    *page_mask = (1u << FB_PAGES) - 1;
+    return true;
 }
 
-// 辅助函数：从源数据获取像素值
-static inline bool get_source_pixel(const uint8_t *src_data, int x, int y)
+// 以下转换内核都只生成一个目标页：dst是该页的320列 (调用前已清零 [col0, col1])，
+// 只读取落在这一页上的源数据，整帧显存和页流水线共用。
+// 内核主体都是 __force_inline 函数，旋转方向 (flip) 作为参数：在文件末尾的实例化里它是常量，
+// 编译器为每个 (内核, 旋转角度) 组合生成一份没有旋转分支的内循环，按帧查表选择
+
+// 逐位转换 (参考实现)：逐个测试源数据位并或入页缓冲，耗时与点亮的像素数成正比
+// 0°/180°：8个源行组成这一页 (180°行序、列方向都相反)
+static __force_inline void bitwise_page_rows(const uint8_t *src_data, int page, uint8_t *dst, bool flip)
 {
-    if (x < 0 || x >= 240 || y < 0 || y >= 240)
-        return false;
+    uint16_t lo, hi;
+    int src_page = flip ? (FB_PAGES - 1 - page) : page;
+    const uint8_t *src_ptr = src_data + src_page * 8 * 30;
 
-    int bit_index = y * 240 + x;
-    int byte_index = bit_index / 8;
-    int bit_pos = bit_index % 8;
+    for (int r = 0; r < 8; r++)
+    {
+        uint8_t bit_mask = 1 << (flip ? 7 - r : r);
+        for (int src_x_byte = 0; src_x_byte < 30; src_x_byte++)
+        {
+            uint8_t src_byte = *src_ptr++;
+            if (src_byte == 0) continue;
 
-    return (src_data[byte_index] >> bit_pos) & 1;
+            for (int b = 0; b < 8; b++)
+            {
+                if (!(src_byte & (1 << b)))
+                    continue;
+                scaled_columns(src_x_byte * 8 + b, flip, &lo, &hi);
+                for (uint16_t col = lo; col <= hi; col++)
+                    dst[col] |= bit_mask;
+            }
+        }
+    }
 }
 
-// 辅助函数：设置目标framebuffer像素
-static inline void set_target_pixel(int x, int y, bool value)
+// 转置：源行变成目标列，每个源行只有一个字节落在这一页 (页p = 第p个源字节，bit b = 源像素b)；
+// mirror：列方向相反 (90°)，flip：页序、位序相反 (270°)
+static __force_inline void bitwise_page_columns(const uint8_t *src_data, int page, uint8_t *dst, bool mirror,
+                                                bool flip)
 {
-    if (x < 0 || x >= 320 || y < 0 || y >= 240)  // 支持320宽度
-        return;
+    uint16_t lo, hi;
+    int src_x_byte = flip ? (FB_PAGES - 1 - page) : page;
+    for (int src_y = 0; src_y < 240; src_y++)
+    {
+        if (!lcd_dirty_row_test(&redraw_rows, src_y))
+            continue;
 
-    int page = y / 8;
-    int bit_pos = y % 8;
-    int fb_index = page * FB_COLS + x;
+        uint8_t src_byte = src_data[src_y * 30 + src_x_byte];
+        if (src_byte == 0) continue;
 
-    if (value)
+        scaled_columns(src_y, mirror, &lo, &hi);
+        for (int b = 0; b < 8; b++)
+        {
+            if (!(src_byte & (1 << b)))
+                continue;
+            uint8_t bit_mask = 1 << (flip ? 7 - b : b);
+            for (uint16_t col = lo; col <= hi; col++)
+                dst[col] |= bit_mask;
+        }
+    }
+}
+
+// 8x8位矩阵转置 (Hacker's Delight transpose8)：两个32位寄存器，固定操作数，没有分支
+// 入: lo/hi 的第r字节 = 第r行 (lo: 行0~3，hi: 行4~7)，字节的bit c = 第c列
+// 出: lo/hi 的第c字节 = 第c列的页字节 (bit r = 第r行)
+static __force_inline void transpose8x8(uint32_t *lo, uint32_t *hi)
+{
+    uint32_t x = *hi;
+    uint32_t y = *lo;
+    uint32_t t;
+
+    t = (x ^ (x >> 7)) & 0x00AA00AAu;
+    x = x ^ t ^ (t << 7);
+    t = (y ^ (y >> 7)) & 0x00AA00AAu;
+    y = y ^ t ^ (t << 7);
+
+    t = (x ^ (x >> 14)) & 0x0000CCCCu;
+    x = x ^ t ^ (t << 14);
+    t = (y ^ (y >> 14)) & 0x0000CCCCu;
+    y = y ^ t ^ (t << 14);
+
+    *hi = (x & 0xF0F0F0F0u) | ((y >> 4) & 0x0F0F0F0Fu);
+    *lo = ((x << 4) & 0xF0F0F0F0u) | (y & 0x0F0F0F0Fu);
+}
+
+// 取出8行 × 8列的块 (行距stride字节) 并转置：lo = 第0~3列的页字节，hi = 第4~7列 (flip: 行序颠倒，用于180°)
+static __force_inline void transpose_block(const uint8_t *src, int stride, bool flip, uint32_t *lo, uint32_t *hi)
+{
+    if (flip)
     {
-        framebuffer[fb_index] |= (1 << bit_pos);
+        *lo = src[7 * stride] | (src[6 * stride] << 8) | (src[5 * stride] << 16) | ((uint32_t)src[4 * stride] << 24);
+        *hi = src[3 * stride] | (src[2 * stride] << 8) | (src[1 * stride] << 16) | ((uint32_t)src[0] << 24);
     }
     else
     {
-        framebuffer[fb_index] &= ~(1 << bit_pos);
+        *lo = src[0] | (src[1 * stride] << 8) | (src[2 * stride] << 16) | ((uint32_t)src[3 * stride] << 24);
+        *hi = src[4 * stride] | (src[5 * stride] << 8) | (src[6 * stride] << 16) | ((uint32_t)src[7 * stride] << 24);
     }
+    transpose8x8(lo, hi);
 }
 
-// 高效批量更新240x240区域 (从1-bit framebuffer数据，支持旋转)
-void lcd_update_from_1bit_framebuffer(const uint8_t *src_data)
+// 4个页字节按地址顺序写入页缓冲 (小端：字的低字节在低地址)
+static __force_inline void store_page_word(uint8_t *dst, uint32_t word)
 {
-    if (src_data == NULL)
-        return;
-
-    // 性能统计开始
-    uint32_t start_time_us = time_us_32();
+    memcpy(dst, &word, sizeof(word));
+}
 
-    // 数据转换开始时间
-    uint32_t conversion_start_us = time_us_32();
+// 0°/180°：每8个源行正好是一个目标页，按8x8块转置后整字写入 (整页重绘，不需要或入)
+static __force_inline void transpose_page_rows(const uint8_t *src_data, int page, uint8_t *dst, bool flip)
+{
+    int src_page = flip ? (FB_PAGES - 1 - page) : page;
+    const uint8_t *src_ptr = src_data + src_page * 8 * 30;
 
-    // 先清空整个320x240显示区域
-    for (int page = 0; page < 30; page++)
-    {                                                 // 240/8 = 30页
-        memset(&framebuffer[page * FB_COLS], 0, 320); // 清空所有320列
+#if ENABLE_LCD_SCALING
+    // 先把8个源行各自查表展开成320像素 (每3个源字节查3次表)，展开后的列已经是目标列顺序，
+    // 再按8x8块转置成页字节
+    const uint32_t(*expand)[256] = flip ? scale_expand_flip : scale_expand;
+    uint32_t rows[8][FB_COLS / 32];
+    for (int r = 0; r < 8; r++)
+    {
+        const uint8_t *s = src_ptr + r * 30;
+        for (int group = 0; group < 10; group++, s += 3)
+            rows[r][flip ? 9 - group : group] = expand[0][s[0]] | expand[1][s[1]] | expand[2][s[2]];
     }
-    // for (int page = 0; page < 30; page++)
-    // {                                                         // 240/8 = 30页
-    //     memset(&framebuffer[page * FB_COLS + 240], 0Xff, 80); // 清空前240列
-    // }
-    // 根据旋转角度进行不同的像素转换
-    switch (current_rotation)
+
+    const uint8_t *row_bytes = (const uint8_t *)rows;
+    for (int block = 0; block < FB_COLS / 8; block++)
     {
-    case LCD_ROTATION_0:
+        uint32_t lo, hi;
+        transpose_block(row_bytes + block, FB_COLS / 8, flip, &lo, &hi);
+        store_page_word(dst + block * 8, lo);
+        store_page_word(dst + block * 8 + 4, hi);
+    }
+#else
+    for (int src_x_byte = 0; src_x_byte < 30; src_x_byte++)
     {
-#if ENABLE_LCD_SCALING
-        // 0度：水平320直接映射 (终极优化版本)
-        const uint8_t *src_ptr = src_data;
-
-        for (int src_y = 0; src_y < 240; src_y++)
+        uint32_t lo, hi;
+        transpose_block(src_ptr + src_x_byte, 30, flip, &lo, &hi);
+        if (flip)
         {
-            int page = src_y / 8;
-            int bit_pos = src_y % 8;
-            uint8_t bit_mask = (1 << bit_pos);
-            uint8_t *fb_base = &framebuffer[page * FB_COLS];
-
-            for (int src_x_byte = 0; src_x_byte < 30; src_x_byte++)
-            {
-                uint8_t src_byte = *src_ptr++;
-                if (src_byte == 0) continue;
-
-                int base_src_x = src_x_byte * 8;
-
-                // 水平320直接映射，超高速查表
-                if (src_byte & 0x01) {
-                    fb_base[horizontal_320_map[base_src_x]] |= bit_mask;
-                    if (horizontal_320_fill[base_src_x])
-                        fb_base[horizontal_320_fill[base_src_x]] |= bit_mask;
-                }
-                if (src_byte & 0x02) {
-                    fb_base[horizontal_320_map[base_src_x + 1]] |= bit_mask;
-                    if (horizontal_320_fill[base_src_x + 1])
-                        fb_base[horizontal_320_fill[base_src_x + 1]] |= bit_mask;
-                }
-                if (src_byte & 0x04) {
-                    fb_base[horizontal_320_map[base_src_x + 2]] |= bit_mask;
-                    if (horizontal_320_fill[base_src_x + 2])
-                        fb_base[horizontal_320_fill[base_src_x + 2]] |= bit_mask;
-                }
-                if (src_byte & 0x08) {
-                    fb_base[horizontal_320_map[base_src_x + 3]] |= bit_mask;
-                    if (horizontal_320_fill[base_src_x + 3])
-                        fb_base[horizontal_320_fill[base_src_x + 3]] |= bit_mask;
-                }
-                if (src_byte & 0x10) {
-                    fb_base[horizontal_320_map[base_src_x + 4]] |= bit_mask;
-                    if (horizontal_320_fill[base_src_x + 4])
-                        fb_base[horizontal_320_fill[base_src_x + 4]] |= bit_mask;
-                }
-                if (src_byte & 0x20) {
-                    fb_base[horizontal_320_map[base_src_x + 5]] |= bit_mask;
-                    if (horizontal_320_fill[base_src_x + 5])
-                        fb_base[horizontal_320_fill[base_src_x + 5]] |= bit_mask;
-                }
-                if (src_byte & 0x40) {
-                    fb_base[horizontal_320_map[base_src_x + 6]] |= bit_mask;
-                    if (horizontal_320_fill[base_src_x + 6])
-                        fb_base[horizontal_320_fill[base_src_x + 6]] |= bit_mask;
-                }
-                if (src_byte & 0x80) {
-                    fb_base[horizontal_320_map[base_src_x + 7]] |= bit_mask;
-                    if (horizontal_320_fill[base_src_x + 7])
-                        fb_base[horizontal_320_fill[base_src_x + 7]] |= bit_mask;
-                }
-            }
+            // 列 x -> 239 - x：8列整体倒序
+            store_page_word(dst + 232 - src_x_byte * 8, __builtin_bswap32(hi));
+            store_page_word(dst + 236 - src_x_byte * 8, __builtin_bswap32(lo));
         }
-#else
-        // 0度：240x240不缩放版本
-        const uint8_t *src_ptr = src_data;
-
-        for (int src_y = 0; src_y < 240; src_y++)
+        else
         {
-            int page = src_y / 8;
-            int bit_pos = src_y % 8;
-            uint8_t bit_mask = (1 << bit_pos);
-            uint8_t *fb_base = &framebuffer[page * FB_COLS];
-
-            for (int src_x_byte = 0; src_x_byte < 30; src_x_byte++)
-            {
-                uint8_t src_byte = *src_ptr++;
-                if (src_byte == 0) continue;
-
-                int base_src_x = src_x_byte * 8;
-
-                // 直接1:1映射，无缩放
-                if (src_byte & 0x01) fb_base[base_src_x + 0] |= bit_mask;
-                if (src_byte & 0x02) fb_base[base_src_x + 1] |= bit_mask;
-                if (src_byte & 0x04) fb_base[base_src_x + 2] |= bit_mask;
-                if (src_byte & 0x08) fb_base[base_src_x + 3] |= bit_mask;
-                if (src_byte & 0x10) fb_base[base_src_x + 4] |= bit_mask;
-                if (src_byte & 0x20) fb_base[base_src_x + 5] |= bit_mask;
-                if (src_byte & 0x40) fb_base[base_src_x + 6] |= bit_mask;
-                if (src_byte & 0x80) fb_base[base_src_x + 7] |= bit_mask;
-            }
+            store_page_word(dst + src_x_byte * 8, lo);
+            store_page_word(dst + src_x_byte * 8 + 4, hi);
         }
-#endif
-        break;
     }
+#endif
+}
 
-    case LCD_ROTATION_90:
-    {
-#if ENABLE_LCD_SCALING
-        // 90度顺时针旋转：水平320直接映射 (终极优化版本)
-        const uint8_t *src_ptr = src_data;
+// 转置：源行变成目标列，源字节的8个像素正好落在同一页的8个位上，转置退化为整字节写入
+// (mirror：列方向相反；flip：页序颠倒、查表反转位序)；这一页只取每个源行的一个字节
+static __force_inline void transpose_page_columns(const uint8_t *src_data, int page, uint8_t *dst, bool mirror,
+                                                  bool flip)
+{
+    int src_x_byte = flip ? (FB_PAGES - 1 - page) : page;
 
-        for (int src_y = 0; src_y < 240; src_y++)
+#if ENABLE_LCD_SCALING
+    // 4/3缩放：3个源行 -> 4个目标列，y=3k -> a，3k+1 -> b，3k+2 -> c，4列为 [a, b, b|c, c]
+    // (mirror时列方向相反)；每组的4列正好是一个对齐的字，整字写入
+    for (int src_y = 0; src_y < 240; src_y += 3)
+    {
+        if (!lcd_dirty_row_test(&redraw_rows, src_y))
+            continue;
+
+        const uint8_t *row_a = src_data + src_y * 30 + src_x_byte;
+        int col = (src_y / 3) * 4;
+        uint32_t a = row_a[0];
+        uint32_t b = row_a[30];
+        uint32_t c = row_a[60];
+        if (flip)
         {
-            uint16_t dst_x_base = 319 - horizontal_320_map[src_y];
-            uint16_t dst_x_fill = horizontal_320_fill[src_y] ? (319 - horizontal_320_fill[src_y] + 1) : 0;
-
-            for (int src_x_byte = 0; src_x_byte < 30; src_x_byte++)
-            {
-                uint8_t src_byte = *src_ptr++;
-                if (src_byte == 0) continue;
-
-                int base_src_x = src_x_byte * 8;
-
-                // 水平320直接映射 + Y轴查表
-                if (src_byte & 0x01) {
-                    int dst_y = base_src_x;
-                    uint8_t *fb_ptr = &framebuffer[y_to_fb_offset[dst_y] + dst_x_base];
-                    uint8_t bit_mask = y_to_bit_mask[dst_y];
-                    *fb_ptr |= bit_mask;
-                    if (dst_x_fill && dst_x_base > 0)
-                        *(fb_ptr - 1) |= bit_mask;
-                }
-                if (src_byte & 0x02) {
-                    int dst_y = base_src_x + 1;
-                    uint8_t *fb_ptr = &framebuffer[y_to_fb_offset[dst_y] + dst_x_base];
-                    uint8_t bit_mask = y_to_bit_mask[dst_y];
-                    *fb_ptr |= bit_mask;
-                    if (dst_x_fill && dst_x_base > 0)
-                        *(fb_ptr - 1) |= bit_mask;
-                }
-                if (src_byte & 0x04) {
-                    int dst_y = base_src_x + 2;
-                    uint8_t *fb_ptr = &framebuffer[y_to_fb_offset[dst_y] + dst_x_base];
-                    uint8_t bit_mask = y_to_bit_mask[dst_y];
-                    *fb_ptr |= bit_mask;
-                    if (dst_x_fill && dst_x_base > 0)
-                        *(fb_ptr - 1) |= bit_mask;
-                }
-                if (src_byte & 0x08) {
-                    int dst_y = base_src_x + 3;
-                    uint8_t *fb_ptr = &framebuffer[y_to_fb_offset[dst_y] + dst_x_base];
-                    uint8_t bit_mask = y_to_bit_mask[dst_y];
-                    *fb_ptr |= bit_mask;
-                    if (dst_x_fill && dst_x_base > 0)
-                        *(fb_ptr - 1) |= bit_mask;
-                }
-                if (src_byte & 0x10) {
-                    int dst_y = base_src_x + 4;
-                    uint8_t *fb_ptr = &framebuffer[y_to_fb_offset[dst_y] + dst_x_base];
-                    uint8_t bit_mask = y_to_bit_mask[dst_y];
-                    *fb_ptr |= bit_mask;
-                    if (dst_x_fill && dst_x_base > 0)
-                        *(fb_ptr - 1) |= bit_mask;
-                }
-                if (src_byte & 0x20) {
-                    int dst_y = base_src_x + 5;
-                    uint8_t *fb_ptr = &framebuffer[y_to_fb_offset[dst_y] + dst_x_base];
-                    uint8_t bit_mask = y_to_bit_mask[dst_y];
-                    *fb_ptr |= bit_mask;
-                    if (dst_x_fill && dst_x_base > 0)
-                        *(fb_ptr - 1) |= bit_mask;
-                }
-                if (src_byte & 0x40) {
-                    int dst_y = base_src_x + 6;
-                    uint8_t *fb_ptr = &framebuffer[y_to_fb_offset[dst_y] + dst_x_base];
-                    uint8_t bit_mask = y_to_bit_mask[dst_y];
-                    *fb_ptr |= bit_mask;
-                    if (dst_x_fill && dst_x_base > 0)
-                        *(fb_ptr - 1) |= bit_mask;
-                }
-                if (src_byte & 0x80) {
-                    int dst_y = base_src_x + 7;
-                    uint8_t *fb_ptr = &framebuffer[y_to_fb_offset[dst_y] + dst_x_base];
-                    uint8_t bit_mask = y_to_bit_mask[dst_y];
-                    *fb_ptr |= bit_mask;
-                    if (dst_x_fill && dst_x_base > 0)
-                        *(fb_ptr - 1) |= bit_mask;
-                }
-            }
+            a = bit_reverse_table[a];
+            b = bit_reverse_table[b];
+            c = bit_reverse_table[c];
         }
+        if (mirror)
+            store_page_word(dst + 316 - col, c | ((b | c) << 8) | (b << 16) | (a << 24));
+        else
+            store_page_word(dst + col, a | (b << 8) | ((b | c) << 16) | (c << 24));
+    }
 #else
-        // 90度顺时针旋转：240x240不缩放版本
-        const uint8_t *src_ptr = src_data;
+    for (int src_y = 0; src_y < 240; src_y++)
+    {
+        if (!lcd_dirty_row_test(&redraw_rows, src_y))
+            continue;
 
-        for (int src_y = 0; src_y < 240; src_y++)
-        {
-            uint16_t dst_x = 239 - src_y;
+        uint16_t col_lo, col_hi;
+        scaled_columns(src_y, mirror, &col_lo, &col_hi);
 
-            for (int src_x_byte = 0; src_x_byte < 30; src_x_byte++)
-            {
-                uint8_t src_byte = *src_ptr++;
-                if (src_byte == 0) continue;
-
-                int base_src_x = src_x_byte * 8;
-
-                // 简单90度旋转，无缩放
-                if (src_byte & 0x01) {
-                    int dst_y = base_src_x;
-                    uint8_t *fb_ptr = &framebuffer[y_to_fb_offset[dst_y] + dst_x];
-                    *fb_ptr |= y_to_bit_mask[dst_y];
-                }
-                if (src_byte & 0x02) {
-                    int dst_y = base_src_x + 1;
-                    uint8_t *fb_ptr = &framebuffer[y_to_fb_offset[dst_y] + dst_x];
-                    *fb_ptr |= y_to_bit_mask[dst_y];
-                }
-                if (src_byte & 0x04) {
-                    int dst_y = base_src_x + 2;
-                    uint8_t *fb_ptr = &framebuffer[y_to_fb_offset[dst_y] + dst_x];
-                    *fb_ptr |= y_to_bit_mask[dst_y];
-                }
-                if (src_byte & 0x08) {
-                    int dst_y = base_src_x + 3;
-                    uint8_t *fb_ptr = &framebuffer[y_to_fb_offset[dst_y] + dst_x];
-                    *fb_ptr |= y_to_bit_mask[dst_y];
-                }
-                if (src_byte & 0x10) {
-                    int dst_y = base_src_x + 4;
-                    uint8_t *fb_ptr = &framebuffer[y_to_fb_offset[dst_y] + dst_x];
-                    *fb_ptr |= y_to_bit_mask[dst_y];
-                }
-                if (src_byte & 0x20) {
-                    int dst_y = base_src_x + 5;
-                    uint8_t *fb_ptr = &framebuffer[y_to_fb_offset[dst_y] + dst_x];
-                    *fb_ptr |= y_to_bit_mask[dst_y];
-                }
-                if (src_byte & 0x40) {
-                    int dst_y = base_src_x + 6;
-                    uint8_t *fb_ptr = &framebuffer[y_to_fb_offset[dst_y] + dst_x];
-                    *fb_ptr |= y_to_bit_mask[dst_y];
-                }
-                if (src_byte & 0x80) {
-                    int dst_y = base_src_x + 7;
-                    uint8_t *fb_ptr = &framebuffer[y_to_fb_offset[dst_y] + dst_x];
-                    *fb_ptr |= y_to_bit_mask[dst_y];
-                }
-            }
-        }
+        uint8_t src_byte = src_data[src_y * 30 + src_x_byte];
+        dst[col_lo] = flip ? bit_reverse_table[src_byte] : src_byte;
+    }
 #endif
-        break;
+}
+
+// 每个 (内核, 软件变换) 组合一份实例：方向参数是常量，内循环没有旋转分支
+typedef void (*convert_page_fn)(const uint8_t *src_data, int page, uint8_t *dst);
+
+#define CONVERT_PAGE_INSTANCE(name, body, ...)                                     \
+    static void name(const uint8_t *src_data, int page, uint8_t *dst)             \
+    {                                                                              \
+        body(src_data, page, dst, __VA_ARGS__);                                    \
     }
 
-    case LCD_ROTATION_180:
+CONVERT_PAGE_INSTANCE(transpose_rows, transpose_page_rows, false)
+CONVERT_PAGE_INSTANCE(transpose_rows_flip, transpose_page_rows, true)
+CONVERT_PAGE_INSTANCE(transpose_columns, transpose_page_columns, false, false)
+CONVERT_PAGE_INSTANCE(transpose_columns_90, transpose_page_columns, true, false)
+CONVERT_PAGE_INSTANCE(transpose_columns_270, transpose_page_columns, false, true)
+CONVERT_PAGE_INSTANCE(bitwise_rows, bitwise_page_rows, false)
+CONVERT_PAGE_INSTANCE(bitwise_rows_flip, bitwise_page_rows, true)
+CONVERT_PAGE_INSTANCE(bitwise_columns, bitwise_page_columns, false, false)
+CONVERT_PAGE_INSTANCE(bitwise_columns_90, bitwise_page_columns, true, false)
+CONVERT_PAGE_INSTANCE(bitwise_columns_270, bitwise_page_columns, false, true)
+
+static const convert_page_fn convert_page_kernels[2][SW_TRANSFORM_COUNT] = {
+    [LCD_CONVERT_TRANSPOSE] = {transpose_rows, transpose_rows_flip, transpose_columns, transpose_columns_90,
+                               transpose_columns_270},
+    [LCD_CONVERT_BITWISE] = {bitwise_rows, bitwise_rows_flip, bitwise_columns, bitwise_columns_90,
+                             bitwise_columns_270},
+};
+
+// 生成一个目标页的显示RAM [col0, col1] 列 (dst指向该页第0列，转换结果从 ram_col_offset 列开始)
+static inline void convert_page(convert_page_fn convert, const uint8_t *src_data, int page, uint8_t *dst,
+                                uint16_t col0, uint16_t col1)
+{
+    memset(&dst[col0], 0, col1 - col0 + 1);
+    convert(src_data, page, dst + ram_col_offset);
+}
+
+// =============================================================================
+// 异步刷新：启动第一段后立即返回，余下的段由DMA_IRQ_1接力发送。
+// SPI逐页发送时 dma_chan 每段完成一次中断，中断里等最后几个字节移出、拉高CS，再发下一段的寻址命令；
+// PIO链路的数据通道是IRQ_QUIET，控制块表末尾的空触发产生一次中断 (每张表一次)，
+// 中断里等状态机移完FIFO里剩下的字节 (CS由状态机拉高)。
+// 页流水线在中断里把下一页转换进刚发完的页缓冲，最后一页转换完就释放源帧；
+// 整帧显存在提交时已经转换完，立即释放。帧统计会打印，由 lcd_poll 在主循环里补记
+// =============================================================================
+static volatile bool refresh_busy = false;     // 已提交的刷新还没发完
+static volatile bool refresh_finished = false; // 已发完，统计还没记录
+static volatile bool refresh_reading_source = false; // 还有页要从源帧转换
+static bool refresh_holds_render = false;      // 源帧是 lcd_framebuffer 的渲染缓冲区
+static bool refresh_band = false;              // 追帧送显的一个带 (不计入帧统计)
+static uint16_t refresh_col0, refresh_col1;
+static lcd_rotation_t refresh_rotation;        // 统计按提交时的旋转角度分项
+static uint32_t refresh_start_us, refresh_end_us, refresh_conversion_us;
+static bool refresh_irq_ready = false;
+#if ST75320_PAGE_PIPELINE
+static const uint8_t *refresh_src;
+static convert_page_fn refresh_convert;
+static uint32_t refresh_unconverted;           // 还没转换的页
+static int refresh_queued_page = -1;           // 已转换、等待发送的页 (-1 = 没有)
+static uint8_t *refresh_queued_data;
+static int refresh_last_page;                  // 上一次发送的页 (整页宽度时紧接着的页不再寻址)
+#else
+static uint32_t refresh_pages;                 // 还没发送的页
+#endif
+
+// 源帧不再被读取：渲染缓冲区还给 lcd_framebuffer (可以在中断里调用)
+static void refresh_release_source(void)
+{
+    refresh_reading_source = false;
+    if (refresh_holds_render)
     {
-#if ENABLE_LCD_SCALING
-        // 180度旋转：水平320直接映射 (终极优化版本)
-        const uint8_t *src_ptr = src_data;
+        refresh_holds_render = false;
+        lcd_framebuffer_release_render();
+    }
+}
 
-        for (int src_y = 0; src_y < 240; src_y++)
-        {
-            int dst_y = 239 - src_y;
-            int dst_page = dst_y / 8;
-            int dst_bit_pos = dst_y % 8;
-            uint8_t dst_mask = (1 << dst_bit_pos);
-            uint8_t *fb_base = &framebuffer[dst_page * FB_COLS];
+#if ST75320_PAGE_PIPELINE
+// 把下一页转换进空闲的页缓冲并排队 (另一个页缓冲可能还在发送)
+static void refresh_convert_next(void)
+{
+    if (refresh_unconverted == 0)
+        return;
+    int page = __builtin_ctz(refresh_unconverted);
+    refresh_unconverted &= refresh_unconverted - 1;
 
-            for (int src_x_byte = 0; src_x_byte < 30; src_x_byte++)
-            {
-                uint8_t src_byte = *src_ptr++;
-                if (src_byte == 0) continue;
-
-                int base_src_x = src_x_byte * 8;
-
-                // 水平320直接映射（180度翻转）
-                if (src_byte & 0x01) {
-                    int dst_x = 319 - horizontal_320_map[base_src_x];
-                    fb_base[dst_x] |= dst_mask;
-                    if (horizontal_320_fill[base_src_x] && dst_x > 0)
-                        fb_base[dst_x - 1] |= dst_mask;
-                }
-                if (src_byte & 0x02) {
-                    int dst_x = 319 - horizontal_320_map[base_src_x + 1];
-                    fb_base[dst_x] |= dst_mask;
-                    if (horizontal_320_fill[base_src_x + 1] && dst_x > 0)
-                        fb_base[dst_x - 1] |= dst_mask;
-                }
-                if (src_byte & 0x04) {
-                    int dst_x = 319 - horizontal_320_map[base_src_x + 2];
-                    fb_base[dst_x] |= dst_mask;
-                    if (horizontal_320_fill[base_src_x + 2] && dst_x > 0)
-                        fb_base[dst_x - 1] |= dst_mask;
-                }
-                if (src_byte & 0x08) {
-                    int dst_x = 319 - horizontal_320_map[base_src_x + 3];
-                    fb_base[dst_x] |= dst_mask;
-                    if (horizontal_320_fill[base_src_x + 3] && dst_x > 0)
-                        fb_base[dst_x - 1] |= dst_mask;
-                }
-                if (src_byte & 0x10) {
-                    int dst_x = 319 - horizontal_320_map[base_src_x + 4];
-                    fb_base[dst_x] |= dst_mask;
-                    if (horizontal_320_fill[base_src_x + 4] && dst_x > 0)
-                        fb_base[dst_x - 1] |= dst_mask;
-                }
-                if (src_byte & 0x20) {
-                    int dst_x = 319 - horizontal_320_map[base_src_x + 5];
-                    fb_base[dst_x] |= dst_mask;
-                    if (horizontal_320_fill[base_src_x + 5] && dst_x > 0)
-                        fb_base[dst_x - 1] |= dst_mask;
-                }
-                if (src_byte & 0x40) {
-                    int dst_x = 319 - horizontal_320_map[base_src_x + 6];
-                    fb_base[dst_x] |= dst_mask;
-                    if (horizontal_320_fill[base_src_x + 6] && dst_x > 0)
-                        fb_base[dst_x - 1] |= dst_mask;
-                }
-                if (src_byte & 0x80) {
-                    int dst_x = 319 - horizontal_320_map[base_src_x + 7];
-                    fb_base[dst_x] |= dst_mask;
-                    if (horizontal_320_fill[base_src_x + 7] && dst_x > 0)
-                        fb_base[dst_x - 1] |= dst_mask;
-                }
-            }
-        }
+    uint8_t *dst = page_ring[page_ring_slot];
+    page_ring_slot = (page_ring_slot + 1) % PAGE_RING_SLOTS;
+    uint32_t conversion_start_us = time_us_32();
+    convert_page(refresh_convert, refresh_src, page, dst, refresh_col0, refresh_col1);
+    refresh_conversion_us += time_us_32() - conversion_start_us;
+
+    refresh_queued_page = page;
+    refresh_queued_data = dst;
+    if (refresh_unconverted == 0)
+        refresh_release_source();
+}
+#endif
+
+// 启动下一段 (上一段已经发完)，没有了返回false
+static bool refresh_send_next(void)
+{
+#if ST75320_PAGE_PIPELINE
+    if (refresh_queued_page < 0)
+        return false;
+    int page = refresh_queued_page;
+    refresh_queued_page = -1;
+    bool full_width = contiguous_refresh && refresh_col0 == 0 && refresh_col1 == FB_COLS - 1;
+    span_send_start(!(full_width && page == refresh_last_page + 1), page, refresh_col0,
+                    &refresh_queued_data[refresh_col0], refresh_col1 - refresh_col0 + 1);
+    refresh_last_page = page;
+
+    // 这一页在线上发送时转换下一页
+    refresh_convert_next();
+    return true;
 #else
-        // 180度旋转：240x240不缩放版本
-        const uint8_t *src_ptr = src_data;
+    if (refresh_pages == 0)
+        return false;
 
-        for (int src_y = 0; src_y < 240; src_y++)
-        {
-            int dst_y = 239 - src_y;
-            int dst_page = dst_y / 8;
-            int dst_bit_pos = dst_y % 8;
-            uint8_t dst_mask = (1 << dst_bit_pos);
-            uint8_t *fb_base = &framebuffer[dst_page * FB_COLS];
+    if (link_active)
+    {
+        // 一次DMA发完整张表
+        link_build_list(refresh_pages, refresh_col0, refresh_col1);
+        lcd_link_start(&link, link_blocks);
+        refresh_pages = 0;
+        return true;
+    }
 
-            for (int src_x_byte = 0; src_x_byte < 30; src_x_byte++)
-            {
-                uint8_t src_byte = *src_ptr++;
-                if (src_byte == 0) continue;
-
-                int base_src_x = src_x_byte * 8;
-
-                // 直接180度旋转，无缩放
-                if (src_byte & 0x01) fb_base[239 - (base_src_x + 0)] |= dst_mask;
-                if (src_byte & 0x02) fb_base[239 - (base_src_x + 1)] |= dst_mask;
-                if (src_byte & 0x04) fb_base[239 - (base_src_x + 2)] |= dst_mask;
-                if (src_byte & 0x08) fb_base[239 - (base_src_x + 3)] |= dst_mask;
-                if (src_byte & 0x10) fb_base[239 - (base_src_x + 4)] |= dst_mask;
-                if (src_byte & 0x20) fb_base[239 - (base_src_x + 5)] |= dst_mask;
-                if (src_byte & 0x40) fb_base[239 - (base_src_x + 6)] |= dst_mask;
-                if (src_byte & 0x80) fb_base[239 - (base_src_x + 7)] |= dst_mask;
-            }
-        }
+    // SPI逐段发送：整页宽度的连续页只寻址一次，列窗口 (局部更新) 逐页寻址
+    uint16_t col_count = refresh_col1 - refresh_col0 + 1;
+    int page = __builtin_ctz(refresh_pages);
+    int last = page_run_end(refresh_pages, page, col_count == FB_COLS);
+    span_send_start(true, page, refresh_col0, &framebuffer[page * FB_COLS + refresh_col0],
+                    (uint32_t)(last - page + 1) * col_count);
+    refresh_pages &= ~((2u << last) - (1u << page));
+    return true;
 #endif
-        break;
+}
+
+static void refresh_complete(void)
+{
+    refresh_end_us = time_us_32();
+    refresh_finished = true;
+    refresh_busy = false;
+}
+
+// 一段发送完成：等它的最后几个字节移出 (SPI时拉高CS)，接着发下一段；都发完了就结束这次刷新
+static void refresh_dma_irq_handler(void)
+{
+    bool segment_done = false;
+    if (dma_channel_get_irq1_status(dma_chan))
+    {
+        dma_channel_acknowledge_irq1(dma_chan);
+        segment_done = true;
+    }
+    if (link_ready && dma_channel_get_irq1_status(link.data_channel))
+    {
+        dma_channel_acknowledge_irq1(link.data_channel);
+        segment_done = true;
     }
+    if (!segment_done || !refresh_busy)
+        return; // 清屏等同步发送也会产生中断
+
+    lcd_wait_output();
+    if (!refresh_send_next())
+        refresh_complete();
+}
+
+static void refresh_ack_irqs(void)
+{
+    dma_channel_acknowledge_irq1(dma_chan);
+    if (link_ready)
+        dma_channel_acknowledge_irq1(link.data_channel);
+}
+
+// 完成中断在第一次提交时注册，从而落在运行显示循环的核上 (双核模式下是core1)
+static void refresh_irq_init(void)
+{
+    if (refresh_irq_ready)
+        return;
+    refresh_ack_irqs();
+    irq_add_shared_handler(DMA_IRQ_1, refresh_dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    dma_channel_set_irq1_enabled(dma_chan, true);
+    if (link_ready)
+        dma_channel_set_irq1_enabled(link.data_channel, true);
+    irq_set_enabled(DMA_IRQ_1, true);
+    refresh_irq_ready = true;
+}
 
-    case LCD_ROTATION_270:
+// 转换并启动一帧 (没有刷新在进行时调用)，没有需要刷新的内容时返回false
+static bool refresh_submit(const uint8_t *src_data, const lcd_dirty_rows_t *dirty, bool holds_render)
+{
+    // 旋转改变后显存内容与新映射不一致，必须整屏重绘
+    if (force_full_update)
     {
-#if ENABLE_LCD_SCALING
-        // 270度顺时针旋转：水平320直接映射 (终极优化版本)
-        const uint8_t *src_ptr = src_data;
+        dirty = NULL;
+        force_full_update = false;
+    }
 
-        for (int src_y = 0; src_y < 240; src_y++)
-        {
-            uint16_t dst_x_base = horizontal_320_map[src_y];
-            uint16_t dst_x_fill = horizontal_320_fill[src_y];
+    uint32_t page_mask;
+    uint16_t col0, col1;
+    if (!plan_dirty_update(dirty, &page_mask, &col0, &col1))
+        return false;
 
-            for (int src_x_byte = 0; src_x_byte < 30; src_x_byte++)
-            {
-                uint8_t src_byte = *src_ptr++;
-                if (src_byte == 0) continue;
-
-                int base_src_x = src_x_byte * 8;
-
-                // 水平320直接映射 + Y轴查表
-                if (src_byte & 0x01) {
-                    int dst_y = 239 - base_src_x;
-                    uint8_t *fb_ptr = &framebuffer[y_to_fb_offset[dst_y] + dst_x_base];
-                    uint8_t bit_mask = y_to_bit_mask[dst_y];
-                    *fb_ptr |= bit_mask;
-                    if (dst_x_fill && dst_x_base < 319)
-                        *(fb_ptr + 1) |= bit_mask;
-                }
-                if (src_byte & 0x02) {
-                    int dst_y = 239 - (base_src_x + 1);
-                    uint8_t *fb_ptr = &framebuffer[y_to_fb_offset[dst_y] + dst_x_base];
-                    uint8_t bit_mask = y_to_bit_mask[dst_y];
-                    *fb_ptr |= bit_mask;
-                    if (dst_x_fill && dst_x_base < 319)
-                        *(fb_ptr + 1) |= bit_mask;
-                }
-                if (src_byte & 0x04) {
-                    int dst_y = 239 - (base_src_x + 2);
-                    uint8_t *fb_ptr = &framebuffer[y_to_fb_offset[dst_y] + dst_x_base];
-                    uint8_t bit_mask = y_to_bit_mask[dst_y];
-                    *fb_ptr |= bit_mask;
-                    if (dst_x_fill && dst_x_base < 319)
-                        *(fb_ptr + 1) |= bit_mask;
-                }
-                if (src_byte & 0x08) {
-                    int dst_y = 239 - (base_src_x + 3);
-                    uint8_t *fb_ptr = &framebuffer[y_to_fb_offset[dst_y] + dst_x_base];
-                    uint8_t bit_mask = y_to_bit_mask[dst_y];
-                    *fb_ptr |= bit_mask;
-                    if (dst_x_fill && dst_x_base < 319)
-                        *(fb_ptr + 1) |= bit_mask;
-                }
-                if (src_byte & 0x10) {
-                    int dst_y = 239 - (base_src_x + 4);
-                    uint8_t *fb_ptr = &framebuffer[y_to_fb_offset[dst_y] + dst_x_base];
-                    uint8_t bit_mask = y_to_bit_mask[dst_y];
-                    *fb_ptr |= bit_mask;
-                    if (dst_x_fill && dst_x_base < 319)
-                        *(fb_ptr + 1) |= bit_mask;
-                }
-                if (src_byte & 0x20) {
-                    int dst_y = 239 - (base_src_x + 5);
-                    uint8_t *fb_ptr = &framebuffer[y_to_fb_offset[dst_y] + dst_x_base];
-                    uint8_t bit_mask = y_to_bit_mask[dst_y];
-                    *fb_ptr |= bit_mask;
-                    if (dst_x_fill && dst_x_base < 319)
-                        *(fb_ptr + 1) |= bit_mask;
-                }
-                if (src_byte & 0x40) {
-                    int dst_y = 239 - (base_src_x + 6);
-                    uint8_t *fb_ptr = &framebuffer[y_to_fb_offset[dst_y] + dst_x_base];
-                    uint8_t bit_mask = y_to_bit_mask[dst_y];
-                    *fb_ptr |= bit_mask;
-                    if (dst_x_fill && dst_x_base < 319)
-                        *(fb_ptr + 1) |= bit_mask;
-                }
-                if (src_byte & 0x80) {
-                    int dst_y = 239 - (base_src_x + 7);
-                    uint8_t *fb_ptr = &framebuffer[y_to_fb_offset[dst_y] + dst_x_base];
-                    uint8_t bit_mask = y_to_bit_mask[dst_y];
-                    *fb_ptr |= bit_mask;
-                    if (dst_x_fill && dst_x_base < 319)
-                        *(fb_ptr + 1) |= bit_mask;
-                }
-            }
-        }
+    refresh_irq_init();
+    // 清屏等同步发送的最后一段可能还在发送 (整帧显存模式下它还在读显存)
+    lcd_wait_output();
+
+    refresh_start_us = time_us_32();
+    refresh_conversion_us = 0;
+    refresh_col0 = col0;
+    refresh_col1 = col1;
+    refresh_rotation = current_rotation;
+    refresh_holds_render = holds_render;
+    refresh_band = false;
+    refresh_reading_source = true;
+    if (holds_render)
+        lcd_framebuffer_hold_render();
+
+    // 内核和软件变换在一帧之内不变，查一次表
+    convert_page_fn convert = convert_page_kernels[convert_kernel][current_transform];
+
+#if ST75320_PAGE_PIPELINE
+    // 页流水线：第p页在线上发送时转换第p+1页，两个页缓冲轮流使用；第一页在DMA空闲时转换
+    refresh_src = src_data;
+    refresh_convert = convert;
+    refresh_unconverted = page_mask;
+    refresh_last_page = -2;
+    refresh_convert_next();
 #else
-        // 270度顺时针旋转：240x240不缩放版本
-        const uint8_t *src_ptr = src_data;
+    for (int page = 0; page < FB_PAGES; page++)
+    {
+        if (page_mask & (1u << page))
+            convert_page(convert, src_data, page, &framebuffer[page * FB_COLS], col0, col1);
+    }
+    refresh_conversion_us = time_us_32() - refresh_start_us;
+    refresh_release_source();
+    refresh_pages = page_mask;
+#endif
 
-        for (int src_y = 0; src_y < 240; src_y++)
-        {
-            uint16_t dst_x = src_y;
+    // 第一段的完成中断不能抢在下一页排队之前 (否则会被当成刷新结束)；
+    // 之前同步发送留下的中断标志不属于这次刷新
+    uint32_t irq_state = save_and_disable_interrupts();
+    refresh_ack_irqs();
+    refresh_busy = true;
+    refresh_send_next();
+    restore_interrupts(irq_state);
+    return true;
+}
 
-            for (int src_x_byte = 0; src_x_byte < 30; src_x_byte++)
-            {
-                uint8_t src_byte = *src_ptr++;
-                if (src_byte == 0) continue;
-
-                int base_src_x = src_x_byte * 8;
-
-                // 简单270度旋转，无缩放
-                if (src_byte & 0x01) {
-                    int dst_y = 239 - base_src_x;
-                    uint8_t *fb_ptr = &framebuffer[y_to_fb_offset[dst_y] + dst_x];
-                    *fb_ptr |= y_to_bit_mask[dst_y];
-                }
-                if (src_byte & 0x02) {
-                    int dst_y = 239 - (base_src_x + 1);
-                    uint8_t *fb_ptr = &framebuffer[y_to_fb_offset[dst_y] + dst_x];
-                    *fb_ptr |= y_to_bit_mask[dst_y];
-                }
-                if (src_byte & 0x04) {
-                    int dst_y = 239 - (base_src_x + 2);
-                    uint8_t *fb_ptr = &framebuffer[y_to_fb_offset[dst_y] + dst_x];
-                    *fb_ptr |= y_to_bit_mask[dst_y];
-                }
-                if (src_byte & 0x08) {
-                    int dst_y = 239 - (base_src_x + 3);
-                    uint8_t *fb_ptr = &framebuffer[y_to_fb_offset[dst_y] + dst_x];
-                    *fb_ptr |= y_to_bit_mask[dst_y];
-                }
-                if (src_byte & 0x10) {
-                    int dst_y = 239 - (base_src_x + 4);
-                    uint8_t *fb_ptr = &framebuffer[y_to_fb_offset[dst_y] + dst_x];
-                    *fb_ptr |= y_to_bit_mask[dst_y];
-                }
-                if (src_byte & 0x20) {
-                    int dst_y = 239 - (base_src_x + 5);
-                    uint8_t *fb_ptr = &framebuffer[y_to_fb_offset[dst_y] + dst_x];
-                    *fb_ptr |= y_to_bit_mask[dst_y];
-                }
-                if (src_byte & 0x40) {
-                    int dst_y = 239 - (base_src_x + 6);
-                    uint8_t *fb_ptr = &framebuffer[y_to_fb_offset[dst_y] + dst_x];
-                    *fb_ptr |= y_to_bit_mask[dst_y];
-                }
-                if (src_byte & 0x80) {
-                    int dst_y = 239 - (base_src_x + 7);
-                    uint8_t *fb_ptr = &framebuffer[y_to_fb_offset[dst_y] + dst_x];
-                    *fb_ptr |= y_to_bit_mask[dst_y];
-                }
-            }
-        }
-#endif
-        break;
+bool lcd_submit_dirty_from_framebuffer(const lcd_dirty_rows_t *dirty)
+{
+    if (!lcd_poll() || !lcd_framebuffer_is_render_ready())
+        return false;
+    const uint8_t *src_data = lcd_framebuffer_get_render_data();
+    if (src_data == NULL)
+        return false;
+    if (!refresh_submit(src_data, dirty, true))
+        lcd_framebuffer_output_complete(time_us_32()); // 没有需要刷新的内容
+    return true;
+}
+
+// 追帧送显：源帧是正在捕获的缓冲区，带外的行还没有捕获
+bool lcd_submit_rows(const uint8_t *src_data, const lcd_dirty_rows_t *rows)
+{
+    if (!lcd_poll() || src_data == NULL || rows == NULL)
+        return false;
+
+    // 整帧的带按整屏更新 (连同边距)；旋转改变后的整屏重绘不能用局部的带完成，
+    // 要求下一帧整帧送出，这之前的带照常按局部更新
+    bool whole = lcd_framebuffer_count_dirty_rows(rows) >= LCD_FB_HEIGHT;
+    bool full_pending = force_full_update;
+    if (!whole)
+    {
+        if (full_pending)
+            lcd_framebuffer_force_redraw();
+        force_full_update = false;
     }
+    bool started = refresh_submit(src_data, whole ? NULL : rows, false);
+    if (!whole)
+        force_full_update = full_pending;
+    if (started)
+        refresh_band = true;
+    else
+        lcd_framebuffer_output_complete(time_us_32());
+    return true;
+}
 
-    default:
-        // 默认使用0度转换
-        printf("警告: 未知的旋转角度，使用默认0度\n");
-        current_rotation = LCD_ROTATION_0;
-        lcd_update_from_1bit_framebuffer(src_data);
-        return;
+bool lcd_is_busy(void)
+{
+    return refresh_busy;
+}
+
+bool lcd_poll(void)
+{
+    if (refresh_finished)
+    {
+        refresh_finished = false;
+        uint32_t total_us = refresh_end_us - refresh_start_us;
+        // 转换时间按旋转角度分项
+        // 帧统计只记整帧提交，追帧的带只是一帧的一部分
+        if (!refresh_band)
+            frame_stats_update_variant(&lcd_stats, refresh_rotation, refresh_conversion_us,
+                                       total_us - refresh_conversion_us, true);
+        lcd_framebuffer_output_complete(refresh_end_us);
     }
+    return !refresh_busy;
+}
 
-    uint32_t conversion_end_us = time_us_32();
-    uint32_t conversion_time_us = conversion_end_us - conversion_start_us;
+void lcd_wait(void)
+{
+    while (refresh_busy)
+    {
+        tight_loop_contents(); // 发送由完成中断推进
+    }
+    lcd_poll();
+}
 
-    // 传输开始时间
-    uint32_t transfer_start_us = time_us_32();
+// 高效批量更新240x240区域 (从1-bit framebuffer数据，支持旋转)
+void lcd_update_from_1bit_framebuffer(const uint8_t *src_data)
+{
+    lcd_update_dirty_from_1bit_framebuffer(src_data, NULL);
+}
 
-    // 刷新显示
-    lcd_refresh();
+// 只重新生成并发送脏行对应的区域 (dirty为NULL时整屏更新)
+// 源帧读完就返回：最后的页 (整帧显存时是整帧) 在后台发送，下一次输出前等待
+void lcd_update_dirty_from_1bit_framebuffer(const uint8_t *src_data, const lcd_dirty_rows_t *dirty)
+{
+    if (src_data == NULL)
+        return;
 
-    uint32_t transfer_end_us = time_us_32();
-    uint32_t transfer_time_us = transfer_end_us - transfer_start_us;
+    lcd_wait();
+    if (!refresh_submit(src_data, dirty, false))
+        return;
+    while (refresh_reading_source)
+    {
+        tight_loop_contents();
+    }
+}
 
-    // 更新性能统计 (ST75320使用DMA传输)
-    frame_stats_update(&lcd_stats, conversion_time_us, transfer_time_us, true);
+#if !ST75320_PAGE_PIPELINE
+// 同步逐段发送整个显存 (段之间等待，最后一段在后台发送)，不计入帧统计
+void lcd_refresh(void)
+{
+    lcd_wait();
+    refresh_col0 = 0;
+    refresh_col1 = FB_COLS - 1;
+    refresh_pages = (1u << FB_PAGES) - 1;
+    while (refresh_send_next())
+    {
+    }
 }
+#endif
 
 // 硬件镜像控制
 void lcd_set_mirror(lcd_mirror_t mirror)
 {
+    lcd_wait();
     switch (mirror)
     {
     case LCD_MIRROR_NORMAL:      // 正常显示
@@ -908,40 +1263,90 @@ void lcd_set_mirror(lcd_mirror_t mirror)
                                                                              : "水平+垂直镜像");
 }
 
-// 软件旋转控制 (支持所有角度的真正旋转)
+// 旋转控制：控制器镜像 + 最便宜的软件变换 (见 orientation_plans)
 void lcd_set_rotation(lcd_rotation_t rotation)
 {
+    if (rotation > LCD_ROTATION_270)
+    {
+        printf("ST75320旋转: 未知角度，使用默认0度\n");
+        rotation = LCD_ROTATION_0;
+    }
+
+    // 正在发送的帧还在按旧的映射转换页
+    lcd_wait();
+    const orientation_plan_t *plan = &orientation_plans[hardware_mirroring][rotation];
     current_rotation = rotation;
+    current_transform = plan->transform;
+    bool mirror_cols = (plan->mirror == LCD_MIRROR_H || plan->mirror == LCD_MIRROR_HV);
+    ram_col_offset = mirror_cols ? FB_COLS - IMAGE_COLS : 0;
+    force_full_update = true;
+
+    lcd_set_mirror(plan->mirror);
+    printf("ST75320旋转: %s (%s%s)\n", rotation_names[rotation], sw_transforms[plan->transform].name,
+           plan->mirror == LCD_MIRROR_NORMAL ? "" : " + 硬件镜像");
+}
 
-    switch (rotation)
-    {
-    case LCD_ROTATION_0: // 正常方向
-        lcd_set_mirror(LCD_MIRROR_NORMAL);
-        printf("ST75320旋转: 0度 (优化硬件路径)\n");
-        break;
+void lcd_set_hardware_mirroring(bool enable)
+{
+    hardware_mirroring = enable;
+    lcd_set_rotation(current_rotation);
+}
 
-    case LCD_ROTATION_90: // 90度旋转
-        lcd_set_mirror(LCD_MIRROR_NORMAL);
-        printf("ST75320旋转: 90度 (软件像素重映射)\n");
-        break;
+void lcd_set_convert_kernel(lcd_convert_kernel_t kernel)
+{
+    convert_kernel = kernel;
+}
 
-    case LCD_ROTATION_180: // 180度旋转
-        // 可以选择硬件镜像或软件实现
-        lcd_set_mirror(LCD_MIRROR_NORMAL); // 使用软件实现保持一致性
-        printf("ST75320旋转: 180度 (软件像素重映射)\n");
-        break;
+void lcd_set_contiguous_refresh(bool enable)
+{
+    lcd_wait();
+    lcd_wait_output();
+    contiguous_refresh = enable;
+#if !ST75320_PAGE_PIPELINE
+    link_list_valid = false;
+#endif
+}
 
-    case LCD_ROTATION_270: // 270度旋转
-        lcd_set_mirror(LCD_MIRROR_NORMAL);
-        printf("ST75320旋转: 270度 (软件像素重映射)\n");
-        break;
+bool lcd_set_pio_link(bool enable)
+{
+    if (enable == link_active)
+        return true;
 
-    default:
-        lcd_set_mirror(LCD_MIRROR_NORMAL);
-        current_rotation = LCD_ROTATION_0;
-        printf("ST75320旋转: 默认0度\n");
-        break;
+    // 切换引脚前等当前链路上的发送结束 (SPI控制器可能还在发最后一页)
+    lcd_wait();
+    lcd_wait_output();
+
+    if (enable)
+    {
+        if (!link_ready)
+        {
+            if (!lcd_link_init(&link, LCD_LINK_PIO, PIN_A0, PIN_CS, PIN_SCK, PIN_MOSI, SPI_BAUDRATE))
+            {
+                printf("⚠️ pio1没有空闲的状态机/指令空间/DMA通道，ST75320使用SPI逐页发送\n");
+                return false;
+            }
+            link_ready = true;
+            if (refresh_irq_ready)
+                dma_channel_set_irq1_enabled(link.data_channel, true);
+        }
+        else
+        {
+            pio_gpio_init(LCD_LINK_PIO, PIN_A0);
+            pio_gpio_init(LCD_LINK_PIO, PIN_CS);
+            pio_gpio_init(LCD_LINK_PIO, PIN_SCK);
+            pio_gpio_init(LCD_LINK_PIO, PIN_MOSI);
+        }
+    }
+    else
+    {
+        // 引脚还给SPI控制器和SIO (SIO仍保持CS高、A0输出)
+        gpio_set_function(PIN_MOSI, GPIO_FUNC_SPI);
+        gpio_set_function(PIN_SCK, GPIO_FUNC_SPI);
+        gpio_set_function(PIN_A0, GPIO_FUNC_SIO);
+        gpio_set_function(PIN_CS, GPIO_FUNC_SIO);
     }
+    link_active = enable;
+    return true;
 }
 
 void lcd_set_contrast(uint8_t contrast)
@@ -951,6 +1356,7 @@ void lcd_set_contrast(uint8_t contrast)
         contrast = 0x7F;
     }
 
+    lcd_wait(); // 命令和帧数据共用输出链路，在两帧之间发送
     lcd_write_command(0x81);  // 设置对比度命令
     lcd_write_data(contrast); // 对比度值
     lcd_write_data(0x01);     // 固定参数
@@ -3,6 +3,8 @@
 
 #include "pico/stdlib.h"
 #include <stdbool.h>
+#include "lcd_framebuffer.h"
+#include "lcd_config.h"
 
 #define LCD_WIDTH 320
 #define LCD_HEIGHT 240
@@ -10,10 +12,13 @@
 // 初始化LCD
 void lcd_init(void);
 
-// 清屏
+// 清屏 (清空显示RAM)
 void lcd_clear(void);
 
-// 设置像素点
+#if !ST75320_PAGE_PIPELINE
+// 以下直接操作整帧显存，页流水线模式 (ST75320_PAGE_PIPELINE) 下不提供
+
+// 设置像素点 (显示RAM坐标，显示位置受当前镜像设置影响)
 void lcd_set_pixel(uint16_t x, uint16_t y, bool color);
 
 // 绘制矩形边框
@@ -21,10 +26,41 @@ void lcd_draw_rect(uint16_t x, uint16_t y, uint16_t width, uint16_t height, bool
 
 // 刷新显示
 void lcd_refresh(void);
+#endif
 
 // 高效批量更新240x240区域 (从1-bit framebuffer数据)
 void lcd_update_from_1bit_framebuffer(const uint8_t *src_data);
 
+// 局部更新：只重新生成并发送脏行对应的页 (0°/180°) 或列窗口 (90°/270°)
+// src_data读完 (转换完最后一页) 就返回，最后的页在后台发送
+void lcd_update_dirty_from_1bit_framebuffer(const uint8_t *src_data, const lcd_dirty_rows_t *dirty);
+
+/**
+ * @brief 异步提交 lcd_framebuffer 的渲染帧 (局部更新同上)
+ *
+ * 转换并启动第一段后立即返回，余下的页由DMA完成中断 (DMA_IRQ_1) 接力转换和发送；
+ * 源帧读完后在中断里释放渲染缓冲区 (lcd_framebuffer_release_render)
+ * @return 上一帧还在发送或没有就绪的渲染帧时返回false
+ */
+bool lcd_submit_dirty_from_framebuffer(const lcd_dirty_rows_t *dirty);
+
+/**
+ * @brief 追帧送显：直接从捕获缓冲区提交一个带 (lcd_framebuffer_beam_next_band)
+ *
+ * 只刷新rows里的行对应的区域，不占用渲染缓冲区，不计入帧统计；
+ * 旋转改变后的整屏重绘推迟到下一次整帧的带
+ */
+bool lcd_submit_rows(const uint8_t *src_data, const lcd_dirty_rows_t *rows);
+
+// 已提交的刷新是否还在发送
+bool lcd_is_busy(void);
+
+// 记录已完成刷新的帧统计 (会打印，不在中断里做)，在主循环里调用；返回是否空闲
+bool lcd_poll(void);
+
+// 等待已提交的刷新发送完成
+void lcd_wait(void);
+
 // 显示镜像控制 (硬件支持)
 typedef enum {
     LCD_MIRROR_NORMAL = 0,     // 正常显示
@@ -35,16 +71,41 @@ typedef enum {
 
 void lcd_set_mirror(lcd_mirror_t mirror);
 
-// 软件旋转控制 (需要重新排列framebuffer数据)
+// 旋转控制 (控制器镜像 + 软件重新排列，会覆盖 lcd_set_mirror 的设置)
 typedef enum {
     LCD_ROTATION_0   = 0,  // 正常方向
-    LCD_ROTATION_90  = 1,  // 顺时针90度 (软件实现)
-    LCD_ROTATION_180 = 2,  // 180度 (可用硬件镜像)
-    LCD_ROTATION_270 = 3   // 顺时针270度 (软件实现)
+    LCD_ROTATION_90  = 1,  // 顺时针90度 (转置 + 水平镜像)
+    LCD_ROTATION_180 = 2,  // 180度 (水平+垂直镜像)
+    LCD_ROTATION_270 = 3   // 顺时针270度 (转置 + 垂直镜像)
 } lcd_rotation_t;
 
 void lcd_set_rotation(lcd_rotation_t rotation);
 
+/**
+ * @brief 旋转是否借助控制器镜像
+ *
+ * @param enable true: 镜像 (0xA0/0xC8) 承担旋转里的反转，180°只做0°的按行转换，
+ *               90°/270°只做纯转置 (默认)；false: 控制器不镜像，全部由软件重映射。
+ *               立即按当前角度重新设置，下一帧整屏重绘
+ */
+void lcd_set_hardware_mirroring(bool enable);
+
+// 1-bit源数据 -> 页格式显存的转换内核
+typedef enum {
+    LCD_CONVERT_TRANSPOSE = 0, // 8x8位矩阵转置，固定操作数 (默认)
+    LCD_CONVERT_BITWISE   = 1  // 逐位测试并或入，耗时与点亮像素数成正比 (参考实现)
+} lcd_convert_kernel_t;
+
+void lcd_set_convert_kernel(lcd_convert_kernel_t kernel);
+
+/**
+ * @brief 整页宽度的连续页是否只寻址一次
+ *
+ * @param enable true: 只在第一页设置页/列地址，其后靠控制器地址自动递增跨页写入，
+ *               整屏刷新只有一组寻址命令 (默认)；false: 每页重新寻址
+ */
+void lcd_set_contiguous_refresh(bool enable);
+
 /**
  * @brief 设置LCD对比度
  *
@@ -52,4 +113,13 @@ void lcd_set_rotation(lcd_rotation_t rotation);
  */
 void lcd_set_contrast(uint8_t contrast);
 
+/**
+ * @brief 切换输出链路
+ *
+ * @param enable true: pio1驱动A0/CS/SCK/MOSI，一次刷新是一张DMA控制块表 (异步)；
+ *               false: SPI控制器逐页发送
+ * @return PIO/DMA资源不足无法启用时返回false (保持SPI发送)
+ */
+bool lcd_set_pio_link(bool enable);
+
 #endif // LCD_ST75320_H
\ No newline at end of file
@@ -0,0 +1,164 @@
+#ifndef LCD_TRIPLE_BUFFER_H
+#define LCD_TRIPLE_BUFFER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+// =============================================================================
+// 无锁三重缓冲索引
+//
+// active/display/render 三个缓冲区索引和"新帧"标志打包在同一个32位字里，
+// 生产者 (DMA中断) 和消费者 (显示循环，可以在另一个核上) 都只做CAS原子更新：
+//   生产者发布：active <-> display 交换，置NEW
+//   消费者获取：NEW置位时 display <-> render 交换，清NEW
+// 三个索引始终互不相同，生产者只写active、消费者只读render，两者永远不会相同。
+// CAS失败只说明对方刚刚更新过状态字，重新读取后重试即可，任何一方都不会等待另一方。
+// RP2350 (Cortex-M33) 的LDREX/STREX在SRAM上跨核有效，core1上的消费者同样安全。
+//
+// 乒乓DMA捕获时生产者额外持有一个不在状态字里的备用缓冲区：
+// 下一帧的目标地址在当前帧完成之前就已装进硬件，发布时用 lcd_triple_buffer_publish_next
+// 把备用缓冲区换成active，回收的旧display缓冲区成为新的备用缓冲区。
+// 帧完整性监视打开时，写完的帧要等到下一个FRAME边沿的判定才能发布：生产者用
+// lcd_triple_buffer_retire_active 把它移出状态字暂存，判定有效后用 lcd_triple_buffer_publish_held
+// 发布 (共5个缓冲区，索引3位)。
+// =============================================================================
+
+#define LCD_TB_ACTIVE_SHIFT 0
+#define LCD_TB_DISPLAY_SHIFT 3
+#define LCD_TB_RENDER_SHIFT 6
+#define LCD_TB_INDEX_MASK 0x7u
+#define LCD_TB_NEW_FRAME (1u << 9)
+
+typedef struct {
+    _Atomic uint32_t state;
+} lcd_triple_buffer_t;
+
+static inline uint32_t lcd_triple_buffer_pack(uint32_t active, uint32_t display, uint32_t render)
+{
+    return (active << LCD_TB_ACTIVE_SHIFT) | (display << LCD_TB_DISPLAY_SHIFT) | (render << LCD_TB_RENDER_SHIFT);
+}
+
+static inline uint32_t lcd_triple_buffer_index(uint32_t state, uint32_t shift)
+{
+    return (state >> shift) & LCD_TB_INDEX_MASK;
+}
+
+// 初始化/复位为 active=0, display=1, render=2, 无新帧
+// (复位时DMA必须已停止，且由消费者所在的一侧调用)
+static inline void lcd_triple_buffer_init(lcd_triple_buffer_t *tb)
+{
+    atomic_store_explicit(&tb->state, lcd_triple_buffer_pack(0, 1, 2), memory_order_release);
+}
+
+// 生产者当前写入的缓冲区
+static inline uint32_t lcd_triple_buffer_active(lcd_triple_buffer_t *tb)
+{
+    return lcd_triple_buffer_index(atomic_load_explicit(&tb->state, memory_order_acquire), LCD_TB_ACTIVE_SHIFT);
+}
+
+// 消费者当前使用的缓冲区
+static inline uint32_t lcd_triple_buffer_render(lcd_triple_buffer_t *tb)
+{
+    return lcd_triple_buffer_index(atomic_load_explicit(&tb->state, memory_order_acquire), LCD_TB_RENDER_SHIFT);
+}
+
+// 生产者：active缓冲区写完后发布为display，返回新的active缓冲区
+// 上一个未被取走的display缓冲区被直接回收 (丢弃旧帧，永远不阻塞生产者)
+static inline uint32_t lcd_triple_buffer_publish(lcd_triple_buffer_t *tb)
+{
+    uint32_t old_state = atomic_load_explicit(&tb->state, memory_order_relaxed);
+    uint32_t new_state;
+    do
+    {
+        uint32_t active = lcd_triple_buffer_index(old_state, LCD_TB_ACTIVE_SHIFT);
+        uint32_t display = lcd_triple_buffer_index(old_state, LCD_TB_DISPLAY_SHIFT);
+        uint32_t render = lcd_triple_buffer_index(old_state, LCD_TB_RENDER_SHIFT);
+        new_state = lcd_triple_buffer_pack(display, active, render) | LCD_TB_NEW_FRAME;
+    } while (!atomic_compare_exchange_weak_explicit(&tb->state, &old_state, new_state,
+                                                    memory_order_acq_rel, memory_order_relaxed));
+
+    return lcd_triple_buffer_index(new_state, LCD_TB_ACTIVE_SHIFT);
+}
+
+// 生产者 (乒乓捕获)：active写完后发布为display，next_active (生产者持有的备用缓冲区) 成为新的active，
+// 返回被回收的旧display缓冲区 (生产者的新备用缓冲区)；superseded (可为NULL) 表示它是还没被取走的新帧
+static inline uint32_t lcd_triple_buffer_publish_next(lcd_triple_buffer_t *tb, uint32_t next_active,
+                                                      bool *superseded)
+{
+    uint32_t old_state = atomic_load_explicit(&tb->state, memory_order_relaxed);
+    uint32_t new_state;
+    do
+    {
+        uint32_t active = lcd_triple_buffer_index(old_state, LCD_TB_ACTIVE_SHIFT);
+        uint32_t render = lcd_triple_buffer_index(old_state, LCD_TB_RENDER_SHIFT);
+        new_state = lcd_triple_buffer_pack(next_active, active, render) | LCD_TB_NEW_FRAME;
+    } while (!atomic_compare_exchange_weak_explicit(&tb->state, &old_state, new_state,
+                                                    memory_order_acq_rel, memory_order_relaxed));
+
+    if (superseded)
+        *superseded = (old_state & LCD_TB_NEW_FRAME) != 0;
+    return lcd_triple_buffer_index(old_state, LCD_TB_DISPLAY_SHIFT);
+}
+
+// 生产者 (等待判定)：active写完后移出状态字，next_active成为新的active，返回写完的缓冲区
+// (display/render不变，消费者看不到这一帧)
+static inline uint32_t lcd_triple_buffer_retire_active(lcd_triple_buffer_t *tb, uint32_t next_active)
+{
+    uint32_t old_state = atomic_load_explicit(&tb->state, memory_order_relaxed);
+    uint32_t new_state;
+    do
+    {
+        uint32_t keep = old_state & ~(LCD_TB_INDEX_MASK << LCD_TB_ACTIVE_SHIFT);
+        new_state = keep | (next_active << LCD_TB_ACTIVE_SHIFT);
+    } while (!atomic_compare_exchange_weak_explicit(&tb->state, &old_state, new_state,
+                                                    memory_order_acq_rel, memory_order_relaxed));
+
+    return lcd_triple_buffer_index(old_state, LCD_TB_ACTIVE_SHIFT);
+}
+
+// 生产者 (判定有效)：把暂存的缓冲区发布为display，返回被回收的旧display缓冲区 (superseded同上)
+static inline uint32_t lcd_triple_buffer_publish_held(lcd_triple_buffer_t *tb, uint32_t held, bool *superseded)
+{
+    uint32_t old_state = atomic_load_explicit(&tb->state, memory_order_relaxed);
+    uint32_t new_state;
+    do
+    {
+        uint32_t active = lcd_triple_buffer_index(old_state, LCD_TB_ACTIVE_SHIFT);
+        uint32_t render = lcd_triple_buffer_index(old_state, LCD_TB_RENDER_SHIFT);
+        new_state = lcd_triple_buffer_pack(active, held, render) | LCD_TB_NEW_FRAME;
+    } while (!atomic_compare_exchange_weak_explicit(&tb->state, &old_state, new_state,
+                                                    memory_order_acq_rel, memory_order_relaxed));
+
+    if (superseded)
+        *superseded = (old_state & LCD_TB_NEW_FRAME) != 0;
+    return lcd_triple_buffer_index(old_state, LCD_TB_DISPLAY_SHIFT);
+}
+
+// 消费者：display是否有还没取走的新帧
+static inline bool lcd_triple_buffer_has_new(lcd_triple_buffer_t *tb)
+{
+    return (atomic_load_explicit(&tb->state, memory_order_acquire) & LCD_TB_NEW_FRAME) != 0;
+}
+
+// 消费者：有新帧时把display换成render，返回true；没有新帧时render保持不变
+static inline bool lcd_triple_buffer_acquire(lcd_triple_buffer_t *tb)
+{
+    uint32_t old_state = atomic_load_explicit(&tb->state, memory_order_acquire);
+    uint32_t new_state;
+    do
+    {
+        if (!(old_state & LCD_TB_NEW_FRAME))
+            return false;
+
+        uint32_t active = lcd_triple_buffer_index(old_state, LCD_TB_ACTIVE_SHIFT);
+        uint32_t display = lcd_triple_buffer_index(old_state, LCD_TB_DISPLAY_SHIFT);
+        uint32_t render = lcd_triple_buffer_index(old_state, LCD_TB_RENDER_SHIFT);
+        new_state = lcd_triple_buffer_pack(active, render, display);
+    } while (!atomic_compare_exchange_weak_explicit(&tb->state, &old_state, new_state,
+                                                    memory_order_acq_rel, memory_order_acquire));
+
+    return true;
+}
+
+#endif // LCD_TRIPLE_BUFFER_H
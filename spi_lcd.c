@@ -4,6 +4,11 @@
 #include "hardware/spi.h"
 #include "hardware/gpio.h"
 #include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "hardware/pio.h"
+#include "hardware/clocks.h"
+#include "st7789_expand.pio.h"
 #include "spi_lcd.h"
 #include "lcd_framebuffer.h"
 #include "frame_stats.h"
@@ -16,29 +21,41 @@ static uint lcd_pin_rst = 3;  // Reset
 static uint lcd_pin_sck = 2;  // Clock
 static uint lcd_pin_mosi = 1; // Data
 static uint lcd_pin_blk = 0;  // Backlight
+static uint lcd_pin_te = 0xFF; // Tearing Effect (0xFF = 未连接)
 
 // LCD configuration
 static lcd_config_t current_config;
 static bool lcd_initialized = false;
 static uint dma_channel_tx = -1;
+static dma_channel_config stream_dma_config; // 像素流：逐个读块缓冲区里的像素
+static dma_channel_config fill_dma_config;   // 纯色填充：重复读同一个颜色字
 static frame_stats_t lcd_stats;
 
-// LUT for 1-bit to 2-byte RGB565 conversion
-// 每个字节(8个1-bit像素) -> 16字节RGB565输出
-static uint8_t byte_to_rgb565_lut[256][16];
+// LUT for 1-bit to wire-format conversion
+// 每个字节(8个1-bit像素) -> 线上像素流，按16位SPI帧存放 (原生uint16_t，MSB先出)：
+//   RGB565: 8个像素 = 8个半字
+//   RGB444: 8个像素 x 12位 = 96位 = 6个半字 (两个像素打包成3字节)
+static uint16_t byte_to_pixel_lut[256][8];
+static uint32_t lut_halfwords_per_byte = 8;
+
+// 控制器当前的CASET/RASET窗口：只重发变化的那一半 (整行窗口之间只有RASET不同)
+static uint16_t window_x0, window_y0, window_x1, window_y1;
+static bool window_valid = false;
+// 整帧更新使用的窗口 (spi_lcd_set_continuous_window)
+static uint16_t continuous_x0 = 0, continuous_y0 = 0, continuous_x1 = 239, continuous_y1 = 239;
 // Low-level SPI functions
 static inline void lcd_write_command(uint8_t cmd)
 {
     gpio_put(lcd_pin_dc, 0); // Command mode
     gpio_put(lcd_pin_cs, 0); // Select LCD
 
-    // Add small delay for signal setup
-    sleep_us(1);
+    // Add small delay for signal setup (busy wait: also called from the DMA completion IRQ)
+    busy_wait_us(1);
 
     int bytes_written = spi_write_blocking(spi_default, &cmd, 1);
 
     // Add small delay before deselect
-    sleep_us(1);
+    busy_wait_us(1);
 
     gpio_put(lcd_pin_cs, 1); // Deselect LCD
 }
@@ -56,22 +73,51 @@ static inline void lcd_write_data_byte(uint8_t data)
     lcd_write_data(&data, 1);
 }
 
-// Initialize LUT for fast 1-bit to RGB565 conversion
+// 每像素线上位数
+static inline uint32_t color_format_bits(lcd_color_format_t format)
+{
+    return format == LCD_COLOR_RGB444 ? 12 : 16;
+}
+
+// RGB565颜色转换为RGB444 (各分量取高4位)
+static inline uint16_t rgb565_to_rgb444(uint16_t color)
+{
+    return (uint16_t)(((color >> 12) << 8) | (((color >> 7) & 0xF) << 4) | ((color >> 1) & 0xF));
+}
+
+// RGB565颜色转换为线上像素值
+static inline uint32_t wire_color(uint16_t color)
+{
+    return current_config.color_format == LCD_COLOR_RGB444 ? rgb565_to_rgb444(color) : color;
+}
+
+// Initialize LUT for fast 1-bit to wire-format conversion
 static void init_pixel_conversion_lut(void)
 {
+    uint32_t pixel_bits = color_format_bits(current_config.color_format);
+    uint32_t fg = wire_color(current_config.fg_color);
+    uint32_t bg = wire_color(current_config.bg_color);
+    lut_halfwords_per_byte = pixel_bits * 8 / 16;
+
     for (int byte_val = 0; byte_val < 256; byte_val++)
     {
+        // 8个像素依次移入位流，每满16位落一个半字
+        uint32_t acc = 0;
+        uint32_t acc_bits = 0;
+        uint32_t out = 0;
         for (int bit = 0; bit < 8; bit++)
         {
             // 提取第bit位的值 (0 or 1)
             uint8_t pixel_bit = (byte_val >> bit) & 0x01;
 
-            // 转换: 0->0x0000(黑), 1->0xFFFF(白)
-            uint16_t rgb565 = pixel_bit ? 0xFFFF : 0x0000;
-
-            // 存储为big-endian格式 (MSB, LSB)
-            byte_to_rgb565_lut[byte_val][bit * 2] = rgb565 >> 8;       // MSB
-            byte_to_rgb565_lut[byte_val][bit * 2 + 1] = rgb565 & 0xFF; // LSB
+            // 转换: 0->背景色, 1->前景色
+            acc = (acc << pixel_bits) | (pixel_bit ? fg : bg);
+            acc_bits += pixel_bits;
+            while (acc_bits >= 16)
+            {
+                acc_bits -= 16;
+                byte_to_pixel_lut[byte_val][out++] = (uint16_t)(acc >> acc_bits);
+            }
         }
     }
 }
@@ -85,18 +131,35 @@ static void lcd_hardware_reset(void)
     sleep_ms(120);
 }
 
-// Set drawing window
+static inline bool window_is(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1)
+{
+    return window_valid && x0 == window_x0 && y0 == window_y0 && x1 == window_x1 && y1 == window_y1;
+}
+
+// Set drawing window (CASET/RASET与控制器当前窗口相同时不重发，RAMWR总是发送以重置地址指针)
 static void lcd_set_window(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1)
 {
     // Column Address Set
-    lcd_write_command(0x2A);
-    uint8_t col_data[] = {x0 >> 8, x0 & 0xFF, x1 >> 8, x1 & 0xFF};
-    lcd_write_data(col_data, 4);
+    if (!window_valid || x0 != window_x0 || x1 != window_x1)
+    {
+        lcd_write_command(0x2A);
+        uint8_t col_data[] = {x0 >> 8, x0 & 0xFF, x1 >> 8, x1 & 0xFF};
+        lcd_write_data(col_data, 4);
+    }
 
     // Row Address Set
-    lcd_write_command(0x2B);
-    uint8_t row_data[] = {y0 >> 8, y0 & 0xFF, y1 >> 8, y1 & 0xFF};
-    lcd_write_data(row_data, 4);
+    if (!window_valid || y0 != window_y0 || y1 != window_y1)
+    {
+        lcd_write_command(0x2B);
+        uint8_t row_data[] = {y0 >> 8, y0 & 0xFF, y1 >> 8, y1 & 0xFF};
+        lcd_write_data(row_data, 4);
+    }
+
+    window_x0 = x0;
+    window_y0 = y0;
+    window_x1 = x1;
+    window_y1 = y1;
+    window_valid = true;
 
     // Memory Write
     lcd_write_command(0x2C);
@@ -107,21 +170,18 @@ void spi_lcd_set_continuous_window(uint16_t x0, uint16_t y0, uint16_t x1, uint16
 {
     if (!lcd_initialized)
         return;
+    spi_lcd_wait();
 
     printf("设置连续传输窗口: (%u,%u) to (%u,%u)\n", x0, y0, x1, y1);
 
-    // Column Address Set
-    lcd_write_command(0x2A);
-    uint8_t col_data[] = {x0 >> 8, x0 & 0xFF, x1 >> 8, x1 & 0xFF};
-    lcd_write_data(col_data, 4);
+    continuous_x0 = x0;
+    continuous_y0 = y0;
+    continuous_x1 = x1;
+    continuous_y1 = y1;
 
-    // Row Address Set
-    lcd_write_command(0x2B);
-    uint8_t row_data[] = {y0 >> 8, y0 & 0xFF, y1 >> 8, y1 & 0xFF};
-    lcd_write_data(row_data, 4);
-
-    // Memory Write - 进入连续写入模式
-    lcd_write_command(0x2C);
+    // CASET/RASET全部重发，RAMWR进入连续写入模式
+    window_valid = false;
+    lcd_set_window(x0, y0, x1, y1);
 
     printf("LCD已设置为连续传输模式\n");
 }
@@ -134,8 +194,9 @@ bool spi_lcd_init(const lcd_config_t *config)
         return false;
     }
 
-    // Save configuration
+    // Save configuration (输出引擎在初始化完成后再切换)
     memcpy(&current_config, config, sizeof(lcd_config_t));
+    current_config.output_engine = LCD_OUTPUT_SPI_LUT;
 
     // Override pin assignments if provided
     if (config->pin_cs != 0xFF)
@@ -150,6 +211,7 @@ bool spi_lcd_init(const lcd_config_t *config)
         lcd_pin_mosi = config->pin_mosi;
     if (config->pin_blk != 0xFF)
         lcd_pin_blk = config->pin_blk;
+    lcd_pin_te = config->pin_te;
 
     // Initialize SPI
     spi_init(spi0, config->spi_freq_hz);
@@ -196,9 +258,9 @@ bool spi_lcd_init(const lcd_config_t *config)
         lcd_write_command(0x36);
         lcd_write_data_byte(0x00); // Normal orientation for ST7789VW
 
-        // Color Mode - 16bit RGB565
+        // Color Mode - 16bit RGB565 (0x05) / 12bit RGB444 (0x03)
         lcd_write_command(0x3A);
-        lcd_write_data_byte(0x05);
+        lcd_write_data_byte(config->color_format == LCD_COLOR_RGB444 ? 0x03 : 0x05);
 
         // Porch Control - ST7789VW optimized
         lcd_write_command(0xB2);
@@ -276,27 +338,36 @@ bool spi_lcd_init(const lcd_config_t *config)
         return false;
     }
 
-    // Clear screen
-    spi_lcd_clear(0x0000);
-
     // Claim DMA channel for high-speed transfers
-    dma_channel_tx = dma_claim_unused_channel(true);
-    if (dma_channel_tx != -1)
-    {
-        // Configure DMA for SPI transfers
-        dma_channel_config c = dma_channel_get_default_config(dma_channel_tx);
-        channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
-        channel_config_set_dreq(&c, spi_get_dreq(spi_default, true));
-        channel_config_set_write_increment(&c, false);
-        channel_config_set_read_increment(&c, true);
+    // 送显和清屏都只走DMA，没有空闲通道时初始化失败
+    int channel = dma_claim_unused_channel(false);
+    if (channel < 0)
+        return false;
+    dma_channel_tx = (uint)channel;
 
-        dma_channel_configure(dma_channel_tx, &c, &spi_get_hw(spi_default)->dr, NULL, 0, false);
-    }
+    // Configure DMA for SPI transfers
+    dma_channel_config c = dma_channel_get_default_config(dma_channel_tx);
+    // 只用于像素流和纯色填充：SPI此时是一个像素一帧，每次DMA传输一个像素
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_dreq(&c, spi_get_dreq(spi_default, true));
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_read_increment(&c, true);
+    stream_dma_config = c;
+    channel_config_set_read_increment(&c, false);
+    fill_dma_config = c;
+
+    dma_channel_configure(dma_channel_tx, &stream_dma_config, &spi_get_hw(spi_default)->dr, NULL, 0, false);
 
-    // 初始化帧统计 (ST7789: 240x240x2 = 115.2KB RGB565数据)
-    frame_stats_init(&lcd_stats, "ST7789", 115.2f);
+    // 初始化帧统计 (ST7789: 240x240x2 = 115.2KB RGB565数据 / 240x240x1.5 = 86.4KB RGB444数据)
+    frame_stats_init(&lcd_stats, "ST7789",
+                     (float)config->width * config->height * color_format_bits(config->color_format) / 8 / 1000);
 
     lcd_initialized = true;
+
+    // Clear screen (DMA填充)
+    spi_lcd_clear(0x0000);
+    if (config->output_engine != LCD_OUTPUT_SPI_LUT)
+        spi_lcd_set_output_engine(config->output_engine);
     return true;
 }
 
@@ -304,107 +375,823 @@ bool spi_lcd_init(const lcd_config_t *config)
 // 显示的核心功能 (集中管理)
 // =============================================================================
 
-// 清屏
-void spi_lcd_clear(uint16_t color)
+// =============================================================================
+// 流式送显：每次把LCD_STREAM_CHUNK_ROWS行转换到两个块缓冲区之一，DMA同时发送另一块，
+// 发送完成的DMA_IRQ_1启动下一块并把再下一块转换进空出的缓冲区，转换时间被SPI传输掩盖。
+// 两块共 2 x 8行 x 480字节 = 7.5KB，取代原来整帧115.2KB的RGB565缓冲区。
+// 像素流期间SPI切换为16位帧，DMA每次搬一个uint16_t (总线事务减半，不需要字节交换)；
+// 命令和窗口参数仍然用8位帧。RGB444时每行240像素 = 180个半字，块缓冲区按RGB565的大小分配。
+// =============================================================================
+#define LCD_STREAM_CHUNK_ROWS 8
+#define LCD_STREAM_CHUNK_PIXELS (LCD_STREAM_CHUNK_ROWS * LCD_FB_WIDTH)
+
+static uint16_t stream_chunks[2][LCD_STREAM_CHUNK_PIXELS] __attribute__((aligned(4)));
+static volatile uint32_t stream_chunk_len[2]; // 半字数 >0: 已转换，排队或正在发送；发送完成后由中断清0
+static volatile int8_t stream_sending = -1;   // 正在发送的块 (-1 = DMA空闲)
+
+static void stream_start_chunk(uint8_t chunk)
 {
-    if (!lcd_initialized)
-        return;
+    stream_sending = (int8_t)chunk;
+    dma_channel_transfer_from_buffer_now(dma_channel_tx, stream_chunks[chunk], stream_chunk_len[chunk]);
+}
 
-    lcd_set_window(0, 0, current_config.width - 1, current_config.height - 1);
-    uint8_t color_bytes[] = {color >> 8, color & 0xFF};
+// 把 [y0, y1] 行的1-bit像素查表展开成线上像素流，返回半字数
+// halfwords_per_byte 在两个实例里是常量 (RGB565: 8，RGB444: 6)，每字节的拷贝展开成固定的字读写
+static __force_inline uint32_t convert_rows_as(const uint8_t *framebuffer_data, uint16_t *dst, uint16_t y0,
+                                               uint16_t rows, uint32_t halfwords_per_byte)
+{
+    uint32_t bytes_per_row = (LCD_FB_WIDTH + 7) / 8;
+    const uint8_t *src = framebuffer_data + (uint32_t)y0 * bytes_per_row;
+    uint32_t total_bytes = (uint32_t)rows * bytes_per_row;
 
-    gpio_put(lcd_pin_dc, 1);
-    gpio_put(lcd_pin_cs, 0);
-    for (uint32_t i = 0; i < (uint32_t)current_config.width * current_config.height; i++)
+    for (uint32_t byte_idx = 0; byte_idx < total_bytes; byte_idx++)
     {
-        spi_write_blocking(spi_default, color_bytes, 2);
+        // 直接拷贝LUT中预计算的8个像素
+        memcpy(dst, byte_to_pixel_lut[src[byte_idx]], halfwords_per_byte * 2);
+        dst += halfwords_per_byte;
     }
-    gpio_put(lcd_pin_cs, 1);
+    return total_bytes * halfwords_per_byte;
 }
 
-// 从帧缓冲区更新显示 (使用DMA批量传输+性能统计)
-bool spi_lcd_update_from_framebuffer(void)
+static uint32_t convert_rows_rgb565(const uint8_t *framebuffer_data, uint16_t *dst, uint16_t y0, uint16_t rows)
+{
+    return convert_rows_as(framebuffer_data, dst, y0, rows, 8);
+}
+
+static uint32_t convert_rows_rgb444(const uint8_t *framebuffer_data, uint16_t *dst, uint16_t y0, uint16_t rows)
+{
+    return convert_rows_as(framebuffer_data, dst, y0, rows, 6);
+}
+
+static uint32_t convert_rows(const uint8_t *framebuffer_data, uint16_t *dst, uint16_t y0, uint16_t rows)
+{
+    if (lut_halfwords_per_byte == 6)
+        return convert_rows_rgb444(framebuffer_data, dst, y0, rows);
+    return convert_rows_rgb565(framebuffer_data, dst, y0, rows);
+}
+
+// =============================================================================
+// PIO展开输出 (st7789_expand.pio)：DMA把渲染缓冲区的原始1-bit数据直接写进pio1的TX FIFO，
+// 状态机自己驱动SCK/MOSI并把每个像素位展开成前景色/背景色。CPU不做转换，
+// 总线上只搬运7.2KB而不是115.2KB。SCK/MOSI平时归SPI控制器发送命令，送显时才切到pio1。
+// 状态机按32位字搬运：每次发送偶数行 (一对行 = 60字节 = 15个字)。
+// =============================================================================
+#define LCD_EXPAND_PIO pio1
+
+static int expand_sm = -1;
+static int expand_dma_channel = -1;
+
+// 颜色按位反转放在低位：OSR右移，颜色的MSB先上线
+static uint32_t expand_program_color(uint16_t color)
+{
+    uint32_t bits = color_format_bits(current_config.color_format);
+    uint32_t value = wire_color(color);
+    uint32_t reversed = 0;
+    for (uint32_t i = 0; i < bits; i++)
+        reversed |= ((value >> i) & 1u) << (bits - 1 - i);
+    return reversed;
+}
+
+// 颜色表在RX FIFO存储里 (FJOIN_RX_GET)：[0] = 背景色，[1] = 前景色
+static void expand_load_colors(void)
+{
+    LCD_EXPAND_PIO->rxf_putget[expand_sm][0] = expand_program_color(current_config.bg_color);
+    LCD_EXPAND_PIO->rxf_putget[expand_sm][1] = expand_program_color(current_config.fg_color);
+}
+
+static bool expand_init(void)
 {
-    if (!lcd_initialized || !lcd_framebuffer_is_render_ready())
+    if (expand_sm >= 0)
+        return true;
+
+    PIO pio = LCD_EXPAND_PIO;
+    if (!pio_can_add_program(pio, &st7789_expand_program))
         return false;
+    int sm = pio_claim_unused_sm(pio, false);
+    if (sm < 0)
+        return false;
+    int channel = dma_claim_unused_channel(false);
+    if (channel < 0)
+    {
+        pio_sm_unclaim(pio, (uint)sm);
+        return false;
+    }
+    uint offset = pio_add_program(pio, &st7789_expand_program);
+
+    pio_sm_config c = st7789_expand_program_get_default_config(offset);
+    sm_config_set_out_pins(&c, lcd_pin_mosi, 1);
+    sm_config_set_sideset_pins(&c, lcd_pin_sck);
+    sm_config_set_out_shift(&c, true, false, color_format_bits(current_config.color_format));
+    sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_TXGET);
+    // SCK = 状态机时钟/2，不超过配置的SPI频率
+    float div = (float)clock_get_hz(clk_sys) / (2.0f * current_config.spi_freq_hz);
+    sm_config_set_clkdiv(&c, div < 1.0f ? 1.0f : div);
+
+    // 状态机一直运行 (空闲时停在pull上，SCK为低)，引脚在送显时才切换给它
+    uint32_t pin_mask = (1u << lcd_pin_sck) | (1u << lcd_pin_mosi);
+    pio_sm_set_pins_with_mask(pio, (uint)sm, 0, pin_mask);
+    pio_sm_set_pindirs_with_mask(pio, (uint)sm, pin_mask, pin_mask);
+    pio_sm_init(pio, (uint)sm, offset, &c);
+    expand_sm = sm;
+    expand_load_colors();
+    pio_sm_set_enabled(pio, (uint)sm, true);
+
+    dma_channel_config dc = dma_channel_get_default_config((uint)channel);
+    channel_config_set_transfer_data_size(&dc, DMA_SIZE_32);
+    channel_config_set_read_increment(&dc, true);
+    channel_config_set_write_increment(&dc, false);
+    channel_config_set_dreq(&dc, pio_get_dreq(pio, (uint)sm, true));
+    dma_channel_configure((uint)channel, &dc, &pio->txf[sm], NULL, 0, false);
+    dma_channel_set_irq1_enabled((uint)channel, true); // 完成中断推进异步送显
+    expand_dma_channel = channel;
+
+    printf("✅ PIO像素展开输出: pio1 SM%d, DMA通道%d\n", sm, channel);
+    return true;
+}
 
-    // 记录开始时间
-    uint32_t start_time_us = time_us_32();
+// 启动 [y0, y1] 行 (y0为偶数，行数为偶数；窗口/0x2C已由调用者设置)，DMA完成时产生DMA_IRQ_1
+static void expand_start_rows(const uint8_t *framebuffer_data, uint16_t y0, uint16_t y1)
+{
+    PIO pio = LCD_EXPAND_PIO;
+    uint32_t bytes_per_row = (LCD_FB_WIDTH + 7) / 8;
+    const uint8_t *src = framebuffer_data + (uint32_t)y0 * bytes_per_row;
+    uint32_t words = (uint32_t)(y1 - y0 + 1) * bytes_per_row / 4;
 
-    // 静态分配显示缓冲区 (240x240x2字节 = 115,200字节，32位对齐)
-    static uint8_t display_buffer[LCD_FB_WIDTH * LCD_FB_HEIGHT * 2] __attribute__((aligned(4)));
+    gpio_put(lcd_pin_dc, 1); // 数据模式
+    gpio_put(lcd_pin_cs, 0); // 选中LCD
 
-    // 使用新的帧统计模块
+    // 之前的命令已由spi_write_blocking发完，SPI空闲；状态机停在pull上，SCK为低
+    pio_gpio_init(pio, lcd_pin_sck);
+    pio_gpio_init(pio, lcd_pin_mosi);
 
-    // 高效批量转换：1-bit -> RGB565 (使用直接数据访问)
-    uint32_t conversion_start_us = time_us_32();
+    dma_channel_transfer_from_buffer_now(expand_dma_channel, src, words);
+}
 
-    const uint8_t *framebuffer_data = lcd_framebuffer_get_render_data();
-    if (!framebuffer_data)
+// DMA完成只代表数据进了TX FIFO，等状态机移完最后一个字 (最多FIFO里的4个字) 重新停在pull上，
+// 再把引脚还给SPI控制器
+static void expand_finish(void)
+{
+    PIO pio = LCD_EXPAND_PIO;
+    uint32_t stall_mask = 1u << (PIO_FDEBUG_TXSTALL_LSB + expand_sm);
+    while (!pio_sm_is_tx_fifo_empty(pio, (uint)expand_sm))
+    {
+        tight_loop_contents();
+    }
+    pio->fdebug = stall_mask; // 写1清除；状态机仍停在pull上时下一个周期重新置位
+    while (!(pio->fdebug & stall_mask))
+    {
+        tight_loop_contents();
+    }
+
+    gpio_set_function(lcd_pin_sck, GPIO_FUNC_SPI);
+    gpio_set_function(lcd_pin_mosi, GPIO_FUNC_SPI);
+    gpio_put(lcd_pin_cs, 1); // 取消选中LCD
+}
+
+bool spi_lcd_set_output_engine(lcd_output_engine_t engine)
+{
+    if (!lcd_initialized)
+        return false;
+    spi_lcd_wait();
+
+    if (engine == LCD_OUTPUT_PIO_EXPAND && !expand_init())
     {
+        printf("⚠️ pio1没有空闲的状态机/指令空间/DMA通道，保持LUT输出\n");
+        current_config.output_engine = LCD_OUTPUT_SPI_LUT;
         return false;
     }
+    current_config.output_engine = engine;
+    return true;
+}
 
-    // 超高速LUT转换：直接查表替代计算
-    uint32_t buffer_idx = 0;
-    uint32_t total_bytes = (LCD_FB_WIDTH * LCD_FB_HEIGHT + 7) / 8;
+lcd_output_engine_t spi_lcd_get_output_engine(void)
+{
+    return current_config.output_engine;
+}
 
-    for (uint32_t byte_idx = 0; byte_idx < total_bytes; byte_idx++)
+// 两个输出引擎使用同一组颜色 (先等正在发送的帧结束，中断里的转换还在用LUT)
+void spi_lcd_set_colors(uint16_t fg_color, uint16_t bg_color)
+{
+    spi_lcd_wait();
+    current_config.fg_color = fg_color;
+    current_config.bg_color = bg_color;
+    init_pixel_conversion_lut();
+    if (expand_sm >= 0)
+        expand_load_colors();
+}
+
+// =============================================================================
+// 局部刷新规划：把脏行合并成总线时间最少的一组窗口
+// 整行窗口之间CASET不变，每个窗口的固定开销是RASET (1条命令 + 4字节参数) + RAMWR，
+// 外加 lcd_write_command 前后各等的1us和启动/结束一次像素流 (在完成中断里进行)。两段脏行之间空隙的发送时间
+// 不超过一个窗口的开销就连同空隙一起发 (每个空隙的取舍互不影响，逐个比较即最优)；
+// 合并后的总时间不低于整帧 (一条RAMWR + 全部行) 时改发整帧
+// =============================================================================
+#define LCD_COMMAND_OVERHEAD_NS 2000 // lcd_write_command 前后各 busy_wait_us(1)
+#define LCD_BURST_OVERHEAD_NS 1000   // 切换16位帧/引脚、启动DMA、等最后一个字节移出
+#define LCD_MAX_ROW_SPANS (LCD_FB_HEIGHT / 2) // 互不相邻的脏行段最多每隔一行一段
+
+typedef struct {
+    uint16_t y0, y1;
+} row_span_t;
+
+// 规划局部刷新：返回true表示整帧发送更便宜 (dirty为NULL时也是)，
+// 否则spans/count为要发送的窗口 (count为0表示没有变化的行)
+static bool plan_row_spans(const lcd_dirty_rows_t *dirty, row_span_t *spans, uint32_t *count)
+{
+    *count = 0;
+    if (dirty == NULL)
+        return true;
+
+    uint32_t byte_ns = (uint32_t)(8000000000ull / spi_get_baudrate(spi_default));
+    uint64_t row_ns = (uint64_t)byte_ns * LCD_FB_WIDTH * color_format_bits(current_config.color_format) / 8;
+    uint64_t window_ns = 2 * LCD_COMMAND_OVERHEAD_NS + 6 * byte_ns + LCD_BURST_OVERHEAD_NS;
+    bool even_rows = current_config.output_engine == LCD_OUTPUT_PIO_EXPAND;
+
+    uint16_t y = 0;
+    while (y < LCD_FB_HEIGHT)
     {
-        uint8_t byte_data = framebuffer_data[byte_idx];
+        if (!lcd_dirty_row_test(dirty, y))
+        {
+            y++;
+            continue;
+        }
 
-        // 直接拷贝LUT中预计算的16字节结果
-        memcpy(&display_buffer[buffer_idx], byte_to_rgb565_lut[byte_data], 16);
-        buffer_idx += 16;
+        uint16_t y0 = y;
+        while (y < LCD_FB_HEIGHT && lcd_dirty_row_test(dirty, y))
+            y++;
+        uint16_t y1 = y - 1;
+        if (even_rows)
+        {
+            // PIO按字搬运，每次两行：扩展到偶数行边界
+            y0 &= ~1u;
+            y1 |= 1u;
+            y = y1 + 1;
+        }
 
-        // 边界检查
-        if (buffer_idx >= LCD_FB_WIDTH * LCD_FB_HEIGHT * 2)
-            break;
+        // 空隙比一个窗口便宜：并入上一段
+        if (*count > 0 && (y0 - spans[*count - 1].y1 - 1) * row_ns <= window_ns)
+            spans[*count - 1].y1 = y1;
+        else
+            spans[(*count)++] = (row_span_t){y0, y1};
     }
-    uint32_t conversion_end_us = time_us_32();
-    uint32_t conversion_time_us = conversion_end_us - conversion_start_us;
+    if (*count == 0)
+        return false;
 
-    // 记录传输开始时间
-    uint32_t transfer_start_us = time_us_32();
-    // 重新发送Memory Write命令重置地址指针 (防止滚动)
-    lcd_write_command(0x2C);
+    uint32_t rows = 0;
+    for (uint32_t i = 0; i < *count; i++)
+        rows += spans[i].y1 - spans[i].y0 + 1;
+    uint64_t spans_ns = rows * row_ns + *count * window_ns;
+    // 整帧：控制器还停在局部窗口时要多发一次RASET
+    uint64_t full_ns = LCD_FB_HEIGHT * row_ns + LCD_COMMAND_OVERHEAD_NS + LCD_BURST_OVERHEAD_NS;
+    if (!window_is(continuous_x0, continuous_y0, continuous_x1, continuous_y1))
+        full_ns += LCD_COMMAND_OVERHEAD_NS + 5 * byte_ns;
+    if (spans_ns >= full_ns)
+    {
+        *count = 0;
+        return true;
+    }
+    return false;
+}
+
+// =============================================================================
+// TE同步送显节拍
+// 面板扫描模型：每个刷新周期扫描320条栅极线，加上前后沿各12行 (初始化的B2 0x0C/0x0C)，
+// TE (TEON，只输出V消隐) 在消隐开始时上升，240行窗口是扫描的前240条线。
+// 扫描读第240~319行和消隐期间都不碰窗口里的行，开始窗口就围着TE上升沿：
+// 从扫描离开第239行 (上升沿前80行) 起，到消隐结束、扫描回到第0行为止。在这里开始写，
+// 每一行都在上一次扫描之后写入；写一行比扫一行快时整帧都在下一次扫描前面，
+// 慢时每行多落后 写一行 - 扫一行，窗口末尾提前这么多，保证最后一行也在扫描到它之前写完。
+// 局部刷新从更靠下的行开始，只会更早写到每一行，同样安全。
+// 窗口内输出空闲且有新帧时才取帧，每个周期最多一帧；窗口之间到达的旧帧已经被三重缓冲换成
+// 最新的一帧。窗口结束时还有帧在等 (上一帧没发完或主循环来晚了) 记一次迟到，该帧留到下一个周期
+// =============================================================================
+#define ST7789_SCAN_LINES 344      // 320条栅极线 + 24行前后沿
+#define ST7789_BLANK_LINES 24
+#define ST7789_TE_NOMINAL_US 16667 // FRCTRL2 0x0F: 60Hz
+#define TE_START_MARGIN_US 100     // 周期估计误差、打开第一个窗口和转换第一块的时间
+#define TE_LOST_PERIODS 4          // 这么久没有上升沿就当TE断了，退回有帧就送
+
+static bool te_pacing = false;
+static bool te_irq_ready = false;
+static volatile uint32_t te_edge_count = 0;
+static volatile uint32_t te_edge_us = 0;
+static volatile uint32_t te_period_us = ST7789_TE_NOMINAL_US;
+static uint32_t te_slot_used;   // 已经用过 (送了一帧或已结束) 的开始窗口，按所围的边沿编号
+static uint32_t te_plan_edges;  // 开始窗口按哪个边沿计算
+static int32_t te_window_open_us, te_window_close_us; // 相对TE上升沿，负数在上升沿之前
+static uint32_t te_edge_base, te_superseded_base;
+static spi_lcd_te_stats_t te_stats;
+
+static void te_irq_handler(void)
+{
+    if (!(gpio_get_irq_event_mask(lcd_pin_te) & GPIO_IRQ_EDGE_RISE))
+        return;
+    gpio_acknowledge_irq(lcd_pin_te, GPIO_IRQ_EDGE_RISE);
+
+    // 周期取滑动平均；漏掉边沿 (中断被关掉) 的间隔不参与
+    uint32_t now = time_us_32();
+    uint32_t interval = now - te_edge_us;
+    if (te_edge_count > 0 && interval > te_period_us / 2 && interval < te_period_us * 3 / 2)
+        te_period_us += ((int32_t)interval - (int32_t)te_period_us) / 8;
+    te_edge_us = now;
+    te_edge_count++;
+}
+
+// 最近一个TE上升沿 (中断可能在另一个核上，计数前后一致才算读到同一个边沿)
+static uint32_t te_last_edge(uint32_t *edge_us)
+{
+    uint32_t edges;
+    do
+    {
+        edges = te_edge_count;
+        *edge_us = te_edge_us;
+    } while (edges != te_edge_count);
+    return edges;
+}
+
+// 一整行像素的线上时间：SPI控制器按波特率；PIO展开每像素 6 + 2 x 位数 个状态机周期，SCK = 状态机时钟/2
+static uint32_t row_write_ns(void)
+{
+    uint32_t bits = color_format_bits(current_config.color_format);
+    if (current_config.output_engine == LCD_OUTPUT_PIO_EXPAND)
+    {
+        uint32_t sck_hz = clock_get_hz(clk_sys) / 2;
+        if (sck_hz > current_config.spi_freq_hz)
+            sck_hz = current_config.spi_freq_hz;
+        return (uint32_t)((uint64_t)LCD_FB_WIDTH * (bits + 3) * 1000000000ull / sck_hz);
+    }
+    return (uint32_t)((uint64_t)LCD_FB_WIDTH * bits * 1000000000ull / spi_get_baudrate(spi_default));
+}
+
+// 按测得的TE周期和当前引擎/像素格式的写入速度计算开始窗口
+static void te_plan_window(void)
+{
+    uint32_t line_ns = te_period_us * 1000 / ST7789_SCAN_LINES;
+    uint32_t lines_before_edge = ST7789_SCAN_LINES - ST7789_BLANK_LINES - LCD_FB_HEIGHT;
+    uint32_t row_ns = row_write_ns();
+    uint32_t lag_us = row_ns > line_ns ? (uint32_t)((uint64_t)(row_ns - line_ns) * LCD_FB_HEIGHT / 1000) : 0;
+
+    te_window_open_us = -(int32_t)(line_ns * lines_before_edge / 1000) + TE_START_MARGIN_US;
+    te_window_close_us = (int32_t)(line_ns * ST7789_BLANK_LINES / 1000) - (int32_t)lag_us - TE_START_MARGIN_US;
+}
+
+// 开启之后收到过TE上升沿，且最近一个没有隔太久
+static bool te_running(uint32_t now_us)
+{
+    uint32_t edge_us;
+    uint32_t edges = te_last_edge(&edge_us);
+    return edges != te_edge_base && now_us - edge_us <= TE_LOST_PERIODS * te_period_us;
+}
+
+// 现在落在哪个边沿的开始窗口附近：上升沿之后到下一个窗口打开前算这个边沿，之后算下一个 (预测的) 边沿
+static uint32_t te_slot_now(uint32_t now_us, int32_t *from_edge_us)
+{
+    uint32_t edge_us;
+    uint32_t edges = te_last_edge(&edge_us);
+    int32_t since_edge = (int32_t)(now_us - edge_us);
+    int32_t next_open = (int32_t)te_period_us + te_window_open_us;
+    if (since_edge >= next_open)
+    {
+        *from_edge_us = since_edge - (int32_t)te_period_us;
+        return edges + 1;
+    }
+    *from_edge_us = since_edge;
+    return edges;
+}
+
+// 提交时调用：这个开始窗口已用掉，记录相对TE上升沿的开始时刻
+static void te_frame_started(uint32_t start_us)
+{
+    if (!te_running(start_us))
+        return;
+    int32_t from_edge_us;
+    te_slot_used = te_slot_now(start_us, &from_edge_us);
+    te_stats.frames++;
+    if (from_edge_us < te_stats.min_start_us)
+        te_stats.min_start_us = from_edge_us;
+    if (from_edge_us > te_stats.max_start_us)
+        te_stats.max_start_us = from_edge_us;
+}
+
+bool spi_lcd_set_te_pacing(bool enable)
+{
+    if (!lcd_initialized || (enable && lcd_pin_te == 0xFF))
+        return false;
+    spi_lcd_wait();
+    if (enable == te_pacing)
+        return true;
+
+    if (enable)
+    {
+        lcd_write_command(0x35); // TEON
+        lcd_write_data_byte(0x00); // 只输出V消隐
+        if (!te_irq_ready)
+        {
+            gpio_init(lcd_pin_te);
+            gpio_set_dir(lcd_pin_te, GPIO_IN);
+            gpio_add_raw_irq_handler(lcd_pin_te, te_irq_handler);
+            irq_set_enabled(IO_IRQ_BANK0, true);
+            te_irq_ready = true;
+        }
+        memset(&te_stats, 0, sizeof(te_stats));
+        te_stats.min_start_us = INT32_MAX;
+        te_stats.max_start_us = INT32_MIN;
+        te_edge_base = te_edge_count;
+        te_superseded_base = lcd_framebuffer_get_superseded_count();
+        // 只用开启之后的边沿
+        te_slot_used = te_edge_count;
+        te_plan_edges = te_edge_count - 1;
+    }
+    else
+    {
+        lcd_write_command(0x34); // TEOFF
+    }
+    gpio_set_irq_enabled(lcd_pin_te, GPIO_IRQ_EDGE_RISE, enable);
+    te_pacing = enable;
+    printf("✅ TE同步送显: %s (GPIO %u)\n", enable ? "开启" : "关闭", lcd_pin_te);
+    return true;
+}
 
-    // 进入数据传输模式
+bool spi_lcd_get_te_pacing(void)
+{
+    return te_pacing;
+}
+
+bool spi_lcd_frame_slot(void)
+{
+    bool idle = spi_lcd_poll();
+    if (!te_pacing)
+        return idle;
+
+    uint32_t now = time_us_32();
+    if (!te_running(now))
+        return idle; // 还没有 (或不再有) TE上升沿
+    uint32_t edge_us;
+    uint32_t edges = te_last_edge(&edge_us);
+    if (edges != te_plan_edges)
+    {
+        te_plan_window();
+        te_plan_edges = edges;
+    }
+
+    int32_t from_edge_us;
+    uint32_t slot = te_slot_now(now, &from_edge_us);
+    if (slot == te_slot_used || from_edge_us < te_window_open_us)
+        return false; // 这个窗口已经送过一帧或已结束，或者还没打开
+    bool waiting = lcd_framebuffer_has_new_frame();
+    if (from_edge_us > te_window_close_us)
+    {
+        te_slot_used = slot;
+        if (waiting)
+            te_stats.late++;
+        return false;
+    }
+    return idle && waiting;
+}
+
+void spi_lcd_get_te_stats(spi_lcd_te_stats_t *stats)
+{
+    *stats = te_stats;
+    stats->te_edges = te_edge_count - te_edge_base;
+    stats->dropped = lcd_framebuffer_get_superseded_count() - te_superseded_base;
+    stats->period_us = te_period_us;
+    stats->window_open_us = te_window_open_us;
+    stats->window_close_us = te_window_close_us;
+    if (te_stats.frames == 0)
+        stats->min_start_us = stats->max_start_us = 0;
+}
+
+// =============================================================================
+// 异步送显：提交时打开第一个窗口、启动像素流后立即返回，之后全部由DMA_IRQ_1推进：
+// LUT的一块发完就启动另一块并把下一块转换进空出的缓冲区；一个窗口发完就等最后的像素移出、
+// 拉高CS，接着在中断里发下一个窗口的RASET/RAMWR；最后一个窗口发完时记下完成时刻，
+// 把渲染缓冲区还给 lcd_framebuffer。帧统计会打印，不能在中断里更新，由 spi_lcd_poll 补记。
+// 中断里只自旋等FIFO里最后几个帧/字移出，以及发窗口命令的几个字节。
+// =============================================================================
+static row_span_t frame_spans[LCD_MAX_ROW_SPANS];
+static uint32_t frame_span_count;
+static uint32_t frame_span_index;            // 正在发送的窗口
+static bool frame_full;                      // 整帧：使用连续传输窗口
+static uint16_t frame_next_row;              // LUT：当前窗口下一块的起始行
+static const uint8_t *frame_data;            // 正在发送的渲染缓冲区
+static volatile bool frame_busy = false;     // 已提交的帧还没发完
+static volatile bool frame_finished = false; // 已发完，统计还没记录
+static uint32_t frame_start_us, frame_end_us;
+static uint32_t frame_conversion_us;         // 没有被DMA传输掩盖的转换时间
+static bool frame_holds_render;              // 追帧的带直接读捕获缓冲区，不占用渲染缓冲区
+static bool frame_fill;                      // 纯色填充 (spi_lcd_fill_rect)，不是帧
+static uint16_t fill_x0, fill_x1;            // 填充矩形的列范围 (行范围在frame_spans[0])
+static uint16_t fill_color;                  // 线上像素值，DMA重复读它，发完之前不能改
+static bool frame_irq_ready = false;
+
+// LUT：把当前窗口的下一块转换进chunk并排队，窗口已经全部转换时返回false
+static bool stream_fill_chunk(uint8_t chunk)
+{
+    const row_span_t *span = &frame_spans[frame_span_index];
+    if (frame_next_row > span->y1)
+        return false;
+
+    uint16_t rows = span->y1 - frame_next_row + 1;
+    if (rows > LCD_STREAM_CHUNK_ROWS)
+        rows = LCD_STREAM_CHUNK_ROWS;
+    stream_chunk_len[chunk] = convert_rows(frame_data, stream_chunks[chunk], frame_next_row, rows);
+    frame_next_row += rows;
+    return true;
+}
+
+// 打开当前窗口并启动它的像素流 (SPI空闲、CS为高、8位帧)
+static void frame_begin_span(void)
+{
+    const row_span_t *span = &frame_spans[frame_span_index];
+    if (frame_fill)
+    {
+        // 纯色填充：一个像素一个SPI帧 (RGB565 16位，RGB444 12位)，DMA不递增读地址，CPU不碰像素
+        lcd_set_window(fill_x0, span->y0, fill_x1, span->y1);
+        spi_set_format(spi_default, color_format_bits(current_config.color_format), SPI_CPOL_0, SPI_CPHA_0,
+                       SPI_MSB_FIRST);
+        gpio_put(lcd_pin_dc, 1); // 数据模式
+        gpio_put(lcd_pin_cs, 0); // 选中LCD
+        uint32_t pixels = (uint32_t)(fill_x1 - fill_x0 + 1) * (span->y1 - span->y0 + 1);
+        // 控制器按字节锁存，CS拉高时丢掉不满一个字节的位：RGB444奇数个像素多发一帧补齐最后半个字节，
+        // 多出的8位回绕到窗口左上角，只是半个像素，同样被丢掉
+        if (current_config.color_format == LCD_COLOR_RGB444 && (pixels & 1u))
+            pixels++;
+        dma_channel_set_config(dma_channel_tx, &fill_dma_config, false);
+        dma_channel_transfer_from_buffer_now(dma_channel_tx, &fill_color, pixels);
+        return;
+    }
+    if (frame_full)
+        lcd_set_window(continuous_x0, continuous_y0, continuous_x1, continuous_y1);
+    else
+        lcd_set_window(0, span->y0, LCD_FB_WIDTH - 1, span->y1);
+
+    if (current_config.output_engine == LCD_OUTPUT_PIO_EXPAND)
+    {
+        expand_start_rows(frame_data, span->y0, span->y1);
+        return;
+    }
+
+    // 进入数据传输模式：像素以16位帧发送
+    spi_set_format(spi_default, 16, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
     gpio_put(lcd_pin_dc, 1); // 数据模式
     gpio_put(lcd_pin_cs, 0); // 选中LCD
 
-    bool used_dma = false;
+    // DMA空闲时转换的第一块计入转换时间，第二块在第一块发送期间转换
+    frame_next_row = span->y0;
+    uint32_t conversion_start_us = time_us_32();
+    stream_fill_chunk(0);
+    frame_conversion_us += time_us_32() - conversion_start_us;
+
+    // 第一块的完成中断不能抢在第二块排队之前 (否则会被当成窗口结束)
+    uint32_t irq_state = save_and_disable_interrupts();
+    stream_start_chunk(0);
+    stream_fill_chunk(1);
+    restore_interrupts(irq_state);
+}
+
+static void frame_complete(void)
+{
+    frame_end_us = time_us_32();
+    frame_data = NULL;
+    if (frame_holds_render)
+        lcd_framebuffer_release_render();
+    frame_finished = true;
+    frame_busy = false;
+}
 
-    // 使用DMA高速传输整帧数据
-    if (dma_channel_tx != -1 && !dma_channel_is_busy(dma_channel_tx))
+// 当前窗口的数据已全部交给FIFO：等最后的像素移出再取消片选，然后开始下一个窗口
+static void frame_end_span(void)
+{
+    if (frame_fill)
+    {
+        dma_channel_set_config(dma_channel_tx, &stream_dma_config, false);
+    }
+    if (current_config.output_engine == LCD_OUTPUT_PIO_EXPAND && !frame_fill)
     {
-        used_dma = true;
+        expand_finish();
+    }
+    else
+    {
+        while (spi_is_busy(spi_default))
+        {
+            tight_loop_contents();
+        }
+        gpio_put(lcd_pin_cs, 1); // 取消选中LCD
+        spi_set_format(spi_default, 8, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST); // 恢复8位帧发送命令
+    }
 
-        // 恢复8位传输（32位传输与SPI硬件不兼容）
-        dma_channel_transfer_from_buffer_now(dma_channel_tx, display_buffer, buffer_idx);
+    if (++frame_span_index < frame_span_count)
+        frame_begin_span();
+    else
+        frame_complete();
+}
 
-        // 等待DMA传输完成
-        dma_channel_wait_for_finish_blocking(dma_channel_tx);
+static void frame_dma_irq_handler(void)
+{
+    if (dma_channel_get_irq1_status(dma_channel_tx))
+    {
+        dma_channel_acknowledge_irq1(dma_channel_tx);
+        if (frame_fill)
+        {
+            frame_end_span();
+            return;
+        }
+
+        // 一块发送完成：释放它，另一块已经转换好就立即接着发送，并把下一块转换进空出的缓冲区
+        uint8_t done = (uint8_t)stream_sending;
+        stream_chunk_len[done] = 0;
+        stream_sending = -1;
+        if (stream_chunk_len[done ^ 1] != 0)
+        {
+            stream_start_chunk(done ^ 1);
+            stream_fill_chunk(done);
+        }
+        else
+        {
+            frame_end_span();
+        }
+    }
+
+    if (expand_dma_channel >= 0 && dma_channel_get_irq1_status((uint)expand_dma_channel))
+    {
+        dma_channel_acknowledge_irq1((uint)expand_dma_channel);
+        frame_end_span();
+    }
+}
+
+// 完成中断在第一次送显时注册，从而落在运行显示循环的核上 (双核模式下是core1)
+static void frame_irq_init(void)
+{
+    if (frame_irq_ready)
+        return;
+    irq_add_shared_handler(DMA_IRQ_1, frame_dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    dma_channel_set_irq1_enabled(dma_channel_tx, true);
+    irq_set_enabled(DMA_IRQ_1, true);
+    frame_irq_ready = true;
+}
+
+// 提交一帧的脏行 (dirty为NULL或整帧更便宜时整帧发送)：脏行按 plan_row_spans 合并成窗口，
+// 每个窗口一次RASET + RAMWR。启动第一个窗口后立即返回，data在发完之前不能改写
+static void submit_rows(const uint8_t *data, const lcd_dirty_rows_t *dirty, bool holds_render)
+{
+    frame_irq_init();
+
+    // 整帧：使用连续传输窗口 (上一帧是局部窗口时只重发RASET)，RAMWR重置地址指针 (防止滚动)；
+    // 局部：窗口留在最后一段上，下一次整帧更新时再恢复
+    frame_full = plan_row_spans(dirty, frame_spans, &frame_span_count);
+    if (frame_full && !holds_render && lcd_framebuffer_count_dirty_rows(dirty) < LCD_FB_HEIGHT)
+    {
+        // 追帧的带：带外的行还没捕获，整帧更便宜时也只发第一个到最后一个脏行
+        uint16_t y0 = 0, y1 = LCD_FB_HEIGHT - 1;
+        while (!lcd_dirty_row_test(dirty, y0))
+            y0++;
+        while (!lcd_dirty_row_test(dirty, y1))
+            y1--;
+        if (current_config.output_engine == LCD_OUTPUT_PIO_EXPAND)
+        {
+            y0 &= ~1u;
+            y1 |= 1u;
+        }
+        frame_full = false;
+        frame_spans[0] = (row_span_t){y0, y1};
+        frame_span_count = 1;
     }
+    else if (frame_full)
+    {
+        frame_spans[0] = (row_span_t){0, LCD_FB_HEIGHT - 1};
+        frame_span_count = 1;
+    }
+    frame_span_index = 0;
+    frame_data = data;
+    frame_conversion_us = 0;
+    frame_start_us = time_us_32();
+    if (te_pacing && holds_render)
+        te_frame_started(frame_start_us);
+    frame_busy = true;
+    frame_fill = false;
+    frame_holds_render = holds_render;
+    if (holds_render)
+        lcd_framebuffer_hold_render();
+
+    if (frame_span_count == 0)
+        frame_complete(); // 没有变化的行
     else
+        frame_begin_span();
+}
+
+// 提交渲染缓冲区的脏行，渲染缓冲区在发完之前保持占用
+bool spi_lcd_submit_dirty_from_framebuffer(const lcd_dirty_rows_t *dirty)
+{
+    if (!lcd_initialized || !spi_lcd_poll() || !lcd_framebuffer_is_render_ready())
+        return false;
+
+    const uint8_t *framebuffer_data = lcd_framebuffer_get_render_data();
+    if (!framebuffer_data)
     {
-        // DMA不可用时使用传统方式
-        spi_write_blocking(spi_default, display_buffer, buffer_idx);
+        return false;
     }
-    uint32_t transfer_end_us = time_us_32();
-    uint32_t transfer_time_us = transfer_end_us - transfer_start_us;
 
-    gpio_put(lcd_pin_cs, 1); // 取消选中LCD
+    submit_rows(framebuffer_data, dirty, true);
+    return true;
+}
+
+// 追帧送显：提交正在捕获的帧里已经落地的一个带 (lcd_framebuffer_beam_next_band)
+bool spi_lcd_submit_rows(const uint8_t *data, const lcd_dirty_rows_t *rows)
+{
+    if (!lcd_initialized || !spi_lcd_poll() || data == NULL || rows == NULL)
+        return false;
 
-    // 计算和显示详细性能统计
-    uint32_t end_time_us = time_us_32();
-    uint32_t total_time_us = end_time_us - start_time_us;
-    float data_size_kb = 115.2f;                                                            // 240x240x2字节 = 115,200字节
-    float transfer_speed_mbps = (data_size_kb / 1024.0f) / (transfer_time_us / 1000000.0f); // MB/s
+    submit_rows(data, rows, false);
+    return true;
+}
+
+// 纯色填充矩形 (超出屏幕的部分裁掉)：等上一帧发完，设好窗口启动DMA后立即返回，之后的送显/绘制会等它发完。
+// 完成中断还没注册时 (初始化时在core0上清屏，中断要留给显示循环所在的核) 在这里等DMA发完
+bool spi_lcd_fill_rect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color)
+{
+    if (!lcd_initialized || x >= current_config.width || y >= current_config.height || w == 0 || h == 0)
+        return false;
+    if (w > current_config.width - x)
+        w = current_config.width - x;
+    if (h > current_config.height - y)
+        h = current_config.height - y;
+    spi_lcd_wait();
+
+    fill_x0 = x;
+    fill_x1 = x + w - 1;
+    fill_color = (uint16_t)wire_color(color);
+    frame_spans[0] = (row_span_t){y, (uint16_t)(y + h - 1)};
+    frame_span_count = 1;
+    frame_span_index = 0;
+    frame_full = false;
+    frame_data = NULL;
+    frame_conversion_us = 0;
+    frame_start_us = time_us_32();
+    frame_busy = true;
+    frame_fill = true;
+    frame_holds_render = false;
+    frame_begin_span();
+
+    if (!frame_irq_ready)
+    {
+        dma_channel_wait_for_finish_blocking(dma_channel_tx);
+        dma_channel_acknowledge_irq1(dma_channel_tx); // 以后打开中断时不能被当成一块发完
+        frame_end_span();
+        spi_lcd_poll();
+    }
+    return true;
+}
+
+// 清屏 (DMA填充整屏)
+void spi_lcd_clear(uint16_t color)
+{
+    spi_lcd_fill_rect(0, 0, current_config.width, current_config.height, color);
+}
+
+bool spi_lcd_is_busy(void)
+{
+    return frame_busy;
+}
+
+// 记录已完成帧的统计 (主循环里调用)，返回是否空闲
+bool spi_lcd_poll(void)
+{
+    if (frame_finished)
+    {
+        frame_finished = false;
+        uint32_t total_us = frame_end_us - frame_start_us;
+        // 帧统计只记整帧提交，追帧的带只是一帧的一部分
+        if (frame_holds_render)
+            frame_stats_update(&lcd_stats, frame_conversion_us, total_us - frame_conversion_us, true);
+        if (!frame_fill)
+            lcd_framebuffer_output_complete(frame_end_us);
+    }
+    return !frame_busy;
+}
+
+void spi_lcd_wait(void)
+{
+    while (frame_busy)
+    {
+        tight_loop_contents(); // 发送由完成中断推进
+    }
+    spi_lcd_poll();
+}
 
-    // 更新性能统计
-    frame_stats_update(&lcd_stats, conversion_time_us, transfer_time_us, used_dma);
+// 从帧缓冲区更新显示 (使用DMA批量传输+性能统计)
+bool spi_lcd_update_from_framebuffer(void)
+{
+    return spi_lcd_update_dirty_from_framebuffer(NULL);
+}
 
+// 阻塞版本：提交后等待发送完成
+bool spi_lcd_update_dirty_from_framebuffer(const lcd_dirty_rows_t *dirty)
+{
+    spi_lcd_wait();
+    if (!spi_lcd_submit_dirty_from_framebuffer(dirty))
+        return false;
+    spi_lcd_wait();
     return true;
 }
 
@@ -413,8 +1200,17 @@ void spi_lcd_draw_pixel(uint16_t x, uint16_t y, uint16_t color)
 {
     if (!lcd_initialized || x >= current_config.width || y >= current_config.height)
         return;
+    spi_lcd_wait();
 
     lcd_set_window(x, y, x, y);
+    if (current_config.color_format == LCD_COLOR_RGB444)
+    {
+        // 单个12位像素占满第一个字节和第二个字节的高4位，写命令结束时低4位被丢弃
+        uint16_t c = rgb565_to_rgb444(color);
+        uint8_t color_bytes[] = {c >> 4, (c & 0xF) << 4};
+        lcd_write_data(color_bytes, 2);
+        return;
+    }
     uint8_t color_bytes[] = {color >> 8, color & 0xFF};
     lcd_write_data(color_bytes, 2);
 }
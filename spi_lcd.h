@@ -3,18 +3,45 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "lcd_framebuffer.h"
 
 // Supported LCD controller types
 typedef enum {
     LCD_CONTROLLER_ST7789
 } lcd_controller_type_t;
 
+// Pixel format on the wire (COLMOD). The 1-bit source only needs black and
+// white, so RGB444 is lossless and sends 25% fewer bytes per frame. The
+// ST7789 has no 3-bit interface format: idle mode (0x39) only limits the
+// displayed colors, the pixel data still uses the COLMOD width.
+typedef enum {
+    LCD_COLOR_RGB565 = 0,   // COLMOD 0x05, 2 bytes/pixel
+    LCD_COLOR_RGB444 = 1    // COLMOD 0x03, 3 bytes per 2 pixels
+} lcd_color_format_t;
+
+// How the 1-bit framebuffer becomes pixels on the wire.
+//   LCD_OUTPUT_SPI_LUT:    the CPU expands rows through a LUT into chunk buffers,
+//                          DMA streams them to the SPI controller.
+//   LCD_OUTPUT_PIO_EXPAND: DMA feeds the raw render buffer into a pio1 state
+//                          machine that drives SCK/MOSI itself and expands each
+//                          bit into a 16/12-bit color (st7789_expand.pio). No
+//                          conversion, 16x less data over the bus fabric. Rows
+//                          are sent in pairs (one pair = 15 words).
+typedef enum {
+    LCD_OUTPUT_SPI_LUT = 0,
+    LCD_OUTPUT_PIO_EXPAND = 1
+} lcd_output_engine_t;
+
 // LCD configuration structure
 typedef struct {
     lcd_controller_type_t controller_type;
     uint16_t width;
     uint16_t height;
     uint32_t spi_freq_hz;
+    lcd_color_format_t color_format;
+    lcd_output_engine_t output_engine;
+    uint16_t fg_color;   // RGB565 color for set framebuffer bits
+    uint16_t bg_color;   // RGB565 color for clear framebuffer bits
     
     // Pin assignments (0xFF = use default)
     uint8_t pin_cs;      // Chip Select
@@ -23,6 +50,7 @@ typedef struct {
     uint8_t pin_sck;     // SPI Clock
     uint8_t pin_mosi;    // SPI Data
     uint8_t pin_blk;     // Backlight Control
+    uint8_t pin_te;      // Tearing Effect output of the panel (0xFF = not connected)
 } lcd_config_t;
 
 // Common LCD resolutions
@@ -53,9 +81,75 @@ typedef struct {
 // Function prototypes
 bool spi_lcd_init(const lcd_config_t* config);
 void spi_lcd_clear(uint16_t color);
+// Fill a rectangle (clipped to the panel) with one colour. The DMA reads the
+// same colour word for every pixel, one SPI frame per pixel, so the CPU only
+// sends the window commands. Returns once the fill is started; the next
+// update or drawing call waits for it. Returns false for an empty rectangle.
+bool spi_lcd_fill_rect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color);
 void spi_lcd_draw_pixel(uint16_t x, uint16_t y, uint16_t color);
 bool spi_lcd_update_from_framebuffer(void);
+// Send only the dirty rows. Spans are coalesced by estimated bus time (a gap
+// is sent along when that is cheaper than opening another RASET/RAMWR
+// window) and the whole frame is sent when that is cheaper than the windows.
+bool spi_lcd_update_dirty_from_framebuffer(const lcd_dirty_rows_t* dirty);
+// Asynchronous version of the update above: opens the first window, starts
+// the pixel stream and returns. The DMA completion IRQ (DMA_IRQ_1) converts
+// and queues the following chunks, opens the remaining windows, deasserts CS
+// after the last one and releases the render buffer (the next
+// lcd_framebuffer_prepare_*_frame fails until then). Returns false while the
+// previous frame is still in flight or no render frame is ready.
+bool spi_lcd_submit_dirty_from_framebuffer(const lcd_dirty_rows_t* dirty);
+// Race-the-beam: send the rows set in *rows straight from a capture buffer
+// (lcd_framebuffer_beam_next_band). Asynchronous like the call above, but the
+// render buffer is not held and TE pacing does not apply; rows outside the
+// band are never sent, even where a full frame would be cheaper.
+bool spi_lcd_submit_rows(const uint8_t* data, const lcd_dirty_rows_t* rows);
+// True while a submitted frame is still on the wire
+bool spi_lcd_is_busy(void);
+// Records the statistics of a completed frame (frame_stats prints, so this is
+// not done in the IRQ). Call from the main loop; returns true when idle.
+bool spi_lcd_poll(void);
+// Block until the submitted frame has been sent
+void spi_lcd_wait(void);
 void spi_lcd_set_continuous_window(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
+// Switch the framebuffer output engine at runtime. Returns false (and keeps
+// the LUT engine) when no pio1 state machine/program space/DMA channel is free.
+bool spi_lcd_set_output_engine(lcd_output_engine_t engine);
+lcd_output_engine_t spi_lcd_get_output_engine(void);
+// Foreground/background colors used by both engines
+void spi_lcd_set_colors(uint16_t fg_color, uint16_t bg_color);
+
+// Tearing-effect pacing. Turns on the controller's TE output (TEON, V-blank
+// only) and paces frames to the panel refresh: at most one frame starts per
+// TE period, inside a start window where the write cannot cross the scan
+// line. The window surrounds the TE rising edge, from the moment the scan
+// leaves the last of our 240 rows until it returns to row 0 after V-blank;
+// a write slower than the scan closes it earlier by the distance it falls
+// behind over 240 rows. Without TE edges frames are sent as soon as the
+// output is idle. Returns false when no TE pin is configured.
+bool spi_lcd_set_te_pacing(bool enable);
+bool spi_lcd_get_te_pacing(void);
+// Whether the display loop may take a new frame now. Without TE pacing this
+// is spi_lcd_poll(). With it, true only inside the current start window
+// while the output is idle and a new frame is waiting; the triple buffer has
+// already replaced stale frames with the newest one. A window that closes
+// with a frame still waiting counts as late.
+bool spi_lcd_frame_slot(void);
+
+typedef struct {
+    uint32_t te_edges;       // TE rising edges seen
+    uint32_t frames;         // frames started in a TE start window
+    uint32_t dropped;        // captured frames replaced by a newer one before a window took them
+    uint32_t late;           // start windows that closed with a frame waiting
+    uint32_t period_us;      // measured TE period
+    int32_t window_open_us;  // start window relative to the TE rising edge (negative = before it)
+    int32_t window_close_us;
+    int32_t min_start_us;    // frame start relative to the TE rising edge
+    int32_t max_start_us;
+} spi_lcd_te_stats_t;
+
+// Counters since pacing was enabled
+void spi_lcd_get_te_stats(spi_lcd_te_stats_t* stats);
 
 // Helper function to create RGB565 color from RGB components
 static inline uint16_t spi_lcd_rgb565(uint8_t r, uint8_t g, uint8_t b) {
@@ -68,12 +162,17 @@ static const lcd_config_t LCD_CONFIG_ST7789_240x240 = {
     .width = 240,
     .height = 240,
     .spi_freq_hz = LCD_DEFAULT_SPI_FREQ,
+    .color_format = LCD_COLOR_RGB565,
+    .output_engine = LCD_OUTPUT_SPI_LUT,
+    .fg_color = LCD_COLOR_WHITE,
+    .bg_color = LCD_COLOR_BLACK,
     .pin_cs = 0xFF,     // Use defaults
     .pin_dc = 0xFF,
     .pin_rst = 0xFF,
     .pin_sck = 0xFF,
     .pin_mosi = 0xFF,
-    .pin_blk = 0xFF
+    .pin_blk = 0xFF,
+    .pin_te = 0xFF      // Not connected
 };
 
 